@@ -21,6 +21,17 @@ HEADERS +=  $$PWD/../include/VBBInstance.h \
             $$PWD/../include/VBBTextureStreaming.h \
             $$PWD/../include/VBBUtils.h \
             $$PWD/../include/VBBUtilsUnitAxes.h \
+            $$PWD/../include/VBBMeshFile.h \
+            $$PWD/../include/VBBMappedFile.h \
+            $$PWD/../include/VBBPixels.h \
+            $$PWD/../include/VBBMipDownsampler.h \
+            $$PWD/../include/VBBTextureUploadBatch.h \
+            $$PWD/../include/VBBUploadService.h \
+            $$PWD/../include/VBBStagingRing.h \
+            $$PWD/../include/VBBMeshletCuller.h \
+            $$PWD/../include/VBBMath.h \
+            $$PWD/../include/VBBGeometryPool.h \
+            $$PWD/../include/VBBMeshGeneratorGPU.h \
             $$PWD/QtVulkanWindow.h
 
 
@@ -40,6 +51,17 @@ SOURCES +=  $$PWD/../src/VBBInstance.cpp \
             $$PWD/../src/VBBTextureStreaming.cpp \
             $$PWD/../src/VBBUtils.cpp \
             $$PWD/../src/VBBUtilsUnitAxes.cpp \
+            $$PWD/../src/VBBMeshFile.cpp \
+            $$PWD/../src/VBBMappedFile.cpp \
+            $$PWD/../src/VBBPixels.cpp \
+            $$PWD/../src/VBBMipDownsampler.cpp \
+            $$PWD/../src/VBBTextureUploadBatch.cpp \
+            $$PWD/../src/VBBUploadService.cpp \
+            $$PWD/../src/VBBStagingRing.cpp \
+            $$PWD/../src/VBBMeshletCuller.cpp \
+            $$PWD/../src/VBBMath.cpp \
+            $$PWD/../src/VBBGeometryPool.cpp \
+            $$PWD/../src/VBBMeshGeneratorGPU.cpp \
             $$PWD/QtVulkanWindow.cpp
 
             
@@ -0,0 +1,914 @@
+//
+//  MeshBench
+//  Times the VBBMake* mesh generators, the welding in VBBSimpleIndexedMesh, and
+//  reports how well the meshes use the post-transform vertex cache. Also times loading
+//  the Orrery's targas, raw and run length encoded, the pixel conversions for upload, and
+//  building mip chains on the CPU
+//
+//  Created by LunarG on 10/17/26.
+//
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#include "VBBUtils.h"
+#include "VBBMeshFile.h"
+#include "VBBMappedFile.h"
+#include "VBBMath.h"
+#include "VBBPixels.h"
+#include "StopWatch.h"
+
+// *************************************************************************************
+// Build the same mesh with the linear search and with the spatial hash, time both, and
+// make sure they came out the same.
+template <typename T>
+void compareBuilders(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh linearMesh;
+    VBBSimpleIndexedMesh hashMesh;
+    StopWatch timer;
+
+    linearMesh.setUseSpatialHash(false);
+    timer.reset();
+    buildMesh(linearMesh);
+    double linearTime = timer.getElapsedSeconds();
+
+    hashMesh.setUseSpatialHash(true);
+    timer.reset();
+    buildMesh(hashMesh);
+    double hashTime = timer.getElapsedSeconds();
+
+    // Should be the same, index for index
+    bool bSame = (linearMesh.getAttributeCount() == hashMesh.getAttributeCount()) &&
+                 (linearMesh.getIndexCount() == hashMesh.getIndexCount());
+
+    for (uint32_t i = 0; bSame && i < hashMesh.getIndexCount(); i++)
+        if (linearMesh.getIndexPointer()[i] != hashMesh.getIndexPointer()[i]) bSame = false;
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << hashMesh.getAttributeCount()
+              << std::setw(10) << hashMesh.getIndexCount() << std::fixed << std::setprecision(4) << std::setw(12) << linearTime
+              << std::setw(12) << hashTime << std::setprecision(1) << std::setw(10) << (linearTime / hashTime) << "x"
+              << (bSame ? "" : "   MISMATCH!") << std::endl;
+}
+
+// *************************************************************************************
+// Welded (with the hash) vs. writing the grid and indexes directly
+template <typename T, typename U>
+void compareGrid(const char* szName, T buildWelded, U buildGrid) {
+    VBBSimpleIndexedMesh weldedMesh;
+    VBBSimpleIndexedMesh gridMesh;
+    StopWatch timer;
+
+    timer.reset();
+    buildWelded(weldedMesh);
+    double weldedTime = timer.getElapsedSeconds();
+
+    timer.reset();
+    buildGrid(gridMesh);
+    double gridTime = timer.getElapsedSeconds();
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << weldedMesh.getAttributeCount()
+              << std::setw(10) << gridMesh.getAttributeCount() << std::fixed << std::setprecision(4) << std::setw(12)
+              << weldedTime << std::setw(12) << gridTime << std::setprecision(1) << std::setw(10) << (weldedTime / gridTime)
+              << "x" << std::endl;
+}
+
+// *************************************************************************************
+// Same mesh on 1 to maxThreads threads. The output has to match the single threaded
+// mesh exactly.
+static bool sameMesh(VBBSimpleIndexedMesh& a, VBBSimpleIndexedMesh& b) {
+    if (a.getAttributeCount() != b.getAttributeCount() || a.getIndexCount() != b.getIndexCount()) return false;
+
+    uint32_t count = a.getAttributeCount();
+    return memcmp(a.getVertexPointer(), b.getVertexPointer(), count * sizeof(VBBSimpleIndexedMesh::VBBSimpleVertex)) == 0 &&
+           memcmp(a.getNormalPointer(), b.getNormalPointer(), count * sizeof(VBBSimpleIndexedMesh::VBBSimpleNormal)) == 0 &&
+           memcmp(a.getTexCoordPointer(), b.getTexCoordPointer(), count * sizeof(VBBSimpleIndexedMesh::VBBSimpleTexCoord)) == 0 &&
+           memcmp(a.getIndexPointer(), b.getIndexPointer(), a.getIndexCount() * sizeof(uint32_t)) == 0;
+}
+
+template <typename T>
+void threadScaling(const char* szName, uint32_t maxThreads, T buildMesh) {
+    VBBSimpleIndexedMesh serialMesh;
+    StopWatch timer;
+
+    timer.reset();
+    buildMesh(serialMesh, 1);
+    double serialTime = timer.getElapsedSeconds();
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << 1 << std::fixed << std::setprecision(4)
+              << std::setw(12) << serialTime << std::setprecision(1) << std::setw(10) << 1.0 << "x" << std::endl;
+
+    for (uint32_t threads = 2; threads <= maxThreads; threads++) {
+        VBBSimpleIndexedMesh mesh;
+        timer.reset();
+        buildMesh(mesh, threads);
+        double time = timer.getElapsedSeconds();
+
+        std::cout << std::left << std::setw(10) << "" << std::right << std::setw(10) << threads << std::fixed << std::setprecision(4)
+                  << std::setw(12) << time << std::setprecision(1) << std::setw(10) << (serialTime / time) << "x"
+                  << (sameMesh(serialMesh, mesh) ? "" : "   MISMATCH!") << std::endl;
+    }
+}
+
+// *************************************************************************************
+// Vertex cache statistics before and after optimizing
+static const uint32_t kCacheSize = 32;
+
+template <typename T>
+void compareOptimized(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh;
+    StopWatch timer;
+
+    buildMesh(mesh);
+    float acmrBefore = mesh.getACMR(kCacheSize);
+    float atvrBefore = mesh.getATVR(kCacheSize);
+
+    timer.reset();
+    mesh.optimize(kCacheSize);
+    double optimizeTime = timer.getElapsedSeconds();
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::fixed << std::setprecision(3) << std::setw(12)
+              << acmrBefore << std::setw(12) << mesh.getACMR(kCacheSize) << std::setw(12) << atvrBefore << std::setw(12)
+              << mesh.getATVR(kCacheSize) << std::setprecision(4) << std::setw(12) << optimizeTime << std::endl;
+}
+
+// *************************************************************************************
+// LOD chain, half the triangles each level
+template <typename T>
+void lodChain(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh;
+    std::vector<uint32_t> indexes;
+    std::vector<VBBMeshLOD> lods;
+    StopWatch timer;
+
+    buildMesh(mesh);
+
+    timer.reset();
+    vbbBuildLODChain(mesh, indexes, lods, 6, 0.5f);
+    double buildTime = timer.getElapsedSeconds();
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::fixed << std::setprecision(4) << std::setw(12) << buildTime;
+    for (size_t i = 0; i < lods.size(); i++) std::cout << "  " << lods[i].indexCount / 3 << " (" << lods[i].error << ")";
+    std::cout << std::endl;
+}
+
+// *************************************************************************************
+// Mesh file save, load into a mesh, and just mapping it (with and without the checksum)
+static const char* kMeshFileName = "MeshBench.vbm";
+
+template <typename T>
+void meshFileTimes(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh;
+    VBBSimpleIndexedMesh loadedMesh;
+    StopWatch timer;
+
+    buildMesh(mesh);
+
+    timer.reset();
+    bool bOK = mesh.saveMesh(kMeshFileName);
+    double saveTime = timer.getElapsedSeconds();
+
+    timer.reset();
+    bOK = bOK && loadedMesh.loadMesh(kMeshFileName);
+    double loadTime = timer.getElapsedSeconds();
+
+    VBBMeshFile meshFile;
+    timer.reset();
+    bOK = bOK && meshFile.open(kMeshFileName);
+    double mapTime = timer.getElapsedSeconds();
+
+    timer.reset();
+    bOK = bOK && meshFile.open(kMeshFileName, false);
+    double mapNoCRCTime = timer.getElapsedSeconds();
+    meshFile.close();
+
+    bOK = bOK && sameMesh(mesh, loadedMesh);
+    remove(kMeshFileName);
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::fixed << std::setprecision(4) << std::setw(12) << saveTime
+              << std::setw(12) << loadTime << std::setw(12) << mapTime << std::setw(12) << mapNoCRCTime << (bOK ? "" : "   FAILED!")
+              << std::endl;
+}
+
+// *************************************************************************************
+// Compressed mesh files. Sizes, and how fast each section decodes into memory that's
+// already there (like a mapped staging buffer would be).
+template <typename T>
+void codecStats(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh;
+    VBBSimpleIndexedMesh loadedMesh;
+    StopWatch timer;
+
+    buildMesh(mesh);
+
+    bool bOK = mesh.saveMesh(kMeshFileName);
+    FILE* pFile = fopen(kMeshFileName, "rb");
+    long rawSize = 0;
+    if (pFile != nullptr) {
+        fseek(pFile, 0, SEEK_END);
+        rawSize = ftell(pFile);
+        fclose(pFile);
+    }
+
+    timer.reset();
+    bOK = bOK && mesh.saveMesh(kMeshFileName, false, true);
+    double saveTime = timer.getElapsedSeconds();
+
+    VBBMeshFile meshFile;
+    bOK = bOK && meshFile.open(kMeshFileName);
+    size_t compressedSize = meshFile.getMappedSize();
+
+    // Decode every section a few times, best time wins
+    const VBBMeshSectionType types[] = {VBB_MESH_SECTION_INDEXES, VBB_MESH_SECTION_POSITIONS, VBB_MESH_SECTION_NORMALS,
+                                        VBB_MESH_SECTION_TEXCOORDS};
+    uint64_t decodedSize = 0;
+    for (int t = 0; t < 4; t++) decodedSize += meshFile.getDecodedSize(types[t]);
+
+    std::vector<unsigned char> staging(static_cast<size_t>(decodedSize));
+    double decodeTime = 1.0e30;
+    for (int pass = 0; bOK && pass < 5; pass++) {
+        timer.reset();
+        unsigned char* pDest = staging.data();
+        for (int t = 0; t < 4; t++) {
+            bOK = bOK && meshFile.decodeSection(types[t], pDest);
+            pDest += meshFile.getDecodedSize(types[t]);
+        }
+        double elapsed = timer.getElapsedSeconds();
+        if (elapsed < decodeTime) decodeTime = elapsed;
+    }
+    meshFile.close();
+
+    bOK = bOK && loadedMesh.loadMesh(kMeshFileName) && sameMesh(mesh, loadedMesh);
+    remove(kMeshFileName);
+
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(12) << rawSize << std::setw(12) << compressedSize
+              << std::fixed << std::setprecision(2) << std::setw(10) << double(rawSize) / double(compressedSize) << std::setprecision(4)
+              << std::setw(12) << saveTime << std::setprecision(2) << std::setw(14) << double(decodedSize) / decodeTime / 1.0e9
+              << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// Split into meshlets, then see how many triangles the culling test would keep from a
+// camera looking at the middle of the mesh from outside.
+template <typename T>
+void meshletStats(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh;
+    std::vector<VBBMeshlet> meshlets;
+    StopWatch timer;
+
+    buildMesh(mesh);
+    mesh.optimizeVertexCache(kCacheSize);
+
+    timer.reset();
+    bool bOK = vbbBuildMeshlets(mesh, meshlets);
+    double buildTime = timer.getElapsedSeconds();
+
+    // Camera at (0, 0, 5) looking down -z, 60 degree square frustum, near 0.1, far 100
+    const float n = 0.1f, f = 100.0f, t = 1.0f / tanf(30.0f * 3.14159265f / 180.0f);
+    const float mvp[16] = {t, 0.0f, 0.0f, 0.0f, 0.0f, t, 0.0f, 0.0f, 0.0f, 0.0f, f / (n - f), -1.0f,
+                           0.0f, 0.0f, -5.0f * f / (n - f) + n * f / (n - f), 5.0f};
+    const float camera[3] = {0.0f, 0.0f, 5.0f};
+    float planes[24];
+    vbbExtractFrustumPlanes(mvp, planes);
+
+    uint32_t vertexTotal = 0, keptTriangles = 0;
+    for (size_t i = 0; i < meshlets.size(); i++) {
+        vertexTotal += meshlets[i].vertexCount;
+        if (vbbIsMeshletVisible(meshlets[i], planes, camera)) keptTriangles += meshlets[i].indexCount / 3;
+    }
+
+    uint32_t triangles = mesh.getIndexCount() / 3;
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << meshlets.size() << std::fixed
+              << std::setprecision(1) << std::setw(12) << float(triangles) / meshlets.size() << std::setw(12)
+              << float(vertexTotal) / meshlets.size() << std::setw(11) << (100.0f * (triangles - keptTriangles) / triangles) << "%"
+              << std::setprecision(4) << std::setw(12) << buildTime << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// The same grid as a triangle list and as strips. Index bytes are what the GPU has to
+// fetch, ACMR is how many vertices it has to shade per triangle.
+template <typename T>
+void compareStrips(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh listMesh, stripMesh;
+    StopWatch timer;
+
+    buildMesh(listMesh, false);
+    timer.reset();
+    buildMesh(stripMesh, true);
+    double stripTime = timer.getElapsedSeconds();
+
+    bool bOK = (listMesh.getTriangleCount() == stripMesh.getTriangleCount()) &&
+               (stripMesh.getPrimitiveRestartEnable() == VK_TRUE);
+    std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << listMesh.getIndexDataSize() << std::setw(10)
+              << stripMesh.getIndexDataSize() << std::fixed << std::setprecision(2) << std::setw(9)
+              << float(listMesh.getIndexCount()) / float(stripMesh.getIndexCount()) << "x" << std::setprecision(3) << std::setw(10)
+              << listMesh.getACMR(kCacheSize) << std::setw(10) << stripMesh.getACMR(kCacheSize) << std::setprecision(4)
+              << std::setw(12) << stripTime << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// The sphere kept up as vertices are added against the one worked out from scratch.
+// Both have to hold every vertex.
+static bool sphereHoldsMesh(VBBSimpleIndexedMesh& mesh, const VBBBoundingSphere& sphere) {
+    const VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = mesh.getVertexPointer();
+    for (uint32_t v = 0; v < mesh.getAttributeCount(); v++) {
+        float d[3] = {pVertices[v].x - sphere.center[0], pVertices[v].y - sphere.center[1], pVertices[v].z - sphere.center[2]};
+        if (sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) > sphere.radius * 1.0001f) return false;
+    }
+
+    return true;
+}
+
+template <typename T>
+void boundsStats(const char* szName, T buildMesh) {
+    VBBSimpleIndexedMesh mesh, added;
+    StopWatch timer;
+
+    // The generators call endBuilding(), which tightens the sphere. Add the vertices again
+    // without it to see the incremental one.
+    buildMesh(mesh);
+    const uint32_t* pIndexes = mesh.getIndexPointer();
+    added.startBuilding(mesh.getAttributeCount());
+    for (uint32_t i = 0; i < mesh.getIndexCount(); i++)
+        added.addVertex(&mesh.getVertexPointer()[pIndexes[i]], nullptr, nullptr, 1);
+    VBBBoundingSphere incremental = added.getBoundingSphere();
+
+    timer.reset();
+    mesh.updateBounds();
+    double updateTime = timer.getElapsedSeconds();
+    VBBBoundingSphere full = mesh.getBoundingSphere();
+    VBBBoundingBox box = mesh.getBoundingBox();
+
+    float halfDiagonal = 0.5f * sqrtf((box.max[0] - box.min[0]) * (box.max[0] - box.min[0]) +
+                                      (box.max[1] - box.min[1]) * (box.max[1] - box.min[1]) +
+                                      (box.max[2] - box.min[2]) * (box.max[2] - box.min[2]));
+
+    bool bOK = sphereHoldsMesh(added, incremental) && sphereHoldsMesh(mesh, full);
+    std::cout << std::left << std::setw(10) << szName << std::right << std::fixed << std::setprecision(4) << std::setw(12)
+              << halfDiagonal << std::setw(12) << incremental.radius << std::setw(12) << full.radius << std::setw(12) << updateTime
+              << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// A field of random bounds around the camera from meshletStats(), one at a time against
+// four at a time. The answers have to match.
+static void cullingTimes(uint32_t count) {
+    std::vector<VBBBoundingSphere> spheres(count);
+    std::vector<VBBBoundingBox> boxes(count);
+    srand(1234);
+    for (uint32_t i = 0; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            float center = (float(rand()) / RAND_MAX) * 40.0f - 20.0f;
+            float size = (float(rand()) / RAND_MAX) * 0.5f + 0.01f;
+            spheres[i].center[k] = center;
+            boxes[i].min[k] = center - size;
+            boxes[i].max[k] = center + size;
+        }
+        spheres[i].radius = (float(rand()) / RAND_MAX) * 0.5f + 0.01f;
+    }
+
+    const float n = 0.1f, f = 100.0f, t = 1.0f / tanf(30.0f * 3.14159265f / 180.0f);
+    const float mvp[16] = {t, 0.0f, 0.0f, 0.0f, 0.0f, t, 0.0f, 0.0f, 0.0f, 0.0f, f / (n - f), -1.0f,
+                           0.0f, 0.0f, -5.0f * f / (n - f) + n * f / (n - f), 5.0f};
+    float planes[24];
+    vbbExtractFrustumPlanes(mvp, planes);
+
+    std::vector<uint8_t> scalar(count), simd(count);
+    const int repeats = 20;
+    StopWatch timer;
+
+    for (int shape = 0; shape < 2; shape++) {
+        uint32_t scalarCount = 0, simdCount = 0;
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++) {
+            scalarCount = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                scalar[i] = (shape == 0) ? vbbIsSphereVisible(planes, spheres[i]) : vbbIsBoxVisible(planes, boxes[i]);
+                scalarCount += scalar[i];
+            }
+        }
+        double scalarTime = timer.getElapsedSeconds() / repeats;
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++)
+            simdCount = (shape == 0) ? vbbCullSpheres(planes, spheres.data(), count, simd.data())
+                                     : vbbCullBoxes(planes, boxes.data(), count, simd.data());
+        double simdTime = timer.getElapsedSeconds() / repeats;
+
+        bool bOK = (scalarCount == simdCount) && (memcmp(scalar.data(), simd.data(), count) == 0);
+        std::cout << std::left << std::setw(10) << ((shape == 0) ? "Spheres" : "Boxes") << std::right << std::setw(10) << count
+                  << std::setw(10) << simdCount << std::fixed << std::setprecision(6) << std::setw(12) << scalarTime << std::setw(12)
+                  << simdTime << std::setprecision(2) << std::setw(10) << scalarTime / simdTime << "x" << (bOK ? "" : "   FAILED!")
+                  << std::endl;
+    }
+}
+
+// *************************************************************************************
+// Each batch math kernel against the one at a time code it replaces. The answers have to
+// be close, not bit for bit, the scalar normalize is done in double like the generators
+// used to.
+static void mathKernels(uint32_t count) {
+    std::vector<float> source(count * 3), simd(count * 3), scalar(count * 3);
+    srand(4321);
+    for (size_t i = 0; i < source.size(); i++) source[i] = (float(rand()) / RAND_MAX) * 4.0f - 2.0f;
+
+    const float matrix[16] = {0.8f, 0.6f, 0.0f, 0.0f, -0.6f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 1.0f, 2.0f, 3.0f, 1.0f};
+    float normalMatrix[9];
+    vbbGetNormalMatrix(matrix, normalMatrix);
+
+    const int repeats = 10;
+    StopWatch timer;
+
+    for (int kernel = 0; kernel < 3; kernel++) {
+        const char* szName = (kernel == 0) ? "Normalize" : (kernel == 1) ? "Points" : "Vectors";
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++)
+            for (uint32_t i = 0; i < count; i++) {
+                const float* in = &source[i * 3];
+                float* out = &scalar[i * 3];
+                if (kernel == 0) {
+                    double length = sqrt(double(in[0]) * in[0] + double(in[1]) * in[1] + double(in[2]) * in[2]);
+                    for (int k = 0; k < 3; k++) out[k] = in[k] / length;
+                } else if (kernel == 1) {
+                    for (int k = 0; k < 3; k++)
+                        out[k] = matrix[k] * in[0] + matrix[4 + k] * in[1] + matrix[8 + k] * in[2] + matrix[12 + k];
+                } else {
+                    for (int k = 0; k < 3; k++) out[k] = normalMatrix[k] * in[0] + normalMatrix[3 + k] * in[1] + normalMatrix[6 + k] * in[2];
+                }
+            }
+        double scalarTime = timer.getElapsedSeconds() / repeats;
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++) {
+            if (kernel == 0) {
+                simd = source;  // In place, so start over each time (the scalar loop copies too)
+                vbbNormalizeArray(simd.data(), count);
+            } else if (kernel == 1)
+                vbbTransformPoints(matrix, source.data(), simd.data(), count);
+            else
+                vbbTransformVectors(normalMatrix, source.data(), simd.data(), count);
+        }
+        double simdTime = timer.getElapsedSeconds() / repeats;
+
+        float worst = 0.0f;
+        for (size_t i = 0; i < simd.size(); i++) worst = std::max(worst, fabsf(simd[i] - scalar[i]) / std::max(1.0f, fabsf(scalar[i])));
+
+        std::cout << std::left << std::setw(10) << szName << std::right << std::setw(10) << count << std::fixed << std::setprecision(6)
+                  << std::setw(12) << scalarTime << std::setw(12) << simdTime << std::setprecision(2) << std::setw(10)
+                  << scalarTime / simdTime << "x" << (worst < 1.0e-5f ? "" : "   FAILED!") << std::endl;
+    }
+
+    // A grid's worth of sin and cos, every vertex against one table shared by every row
+    uint32_t columns = 1024, rows = count / columns;
+    double step = 2.0 * 3.14159265358979 / columns, sum = 0.0, tableSum = 0.0;
+
+    timer.reset();
+    for (uint32_t i = 0; i < rows; i++)
+        for (uint32_t j = 0; j <= columns; j++) sum += sin(double(j) * step) + cos(double(j) * step);
+    double scalarTime = timer.getElapsedSeconds();
+
+    timer.reset();
+    std::vector<double> sinTable(columns + 1), cosTable(columns + 1);
+    vbbMakeSinCosTable(columns + 1, step, sinTable.data(), cosTable.data());
+    for (uint32_t i = 0; i < rows; i++)
+        for (uint32_t j = 0; j <= columns; j++) tableSum += sinTable[j] + cosTable[j];
+    double tableTime = timer.getElapsedSeconds();
+
+    std::cout << std::left << std::setw(10) << "SinCos" << std::right << std::setw(10) << rows * (columns + 1) << std::fixed
+              << std::setprecision(6) << std::setw(12) << scalarTime << std::setw(12) << tableTime << std::setprecision(2)
+              << std::setw(10) << scalarTime / tableTime << "x" << (sum == tableSum ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// Pixel conversions for texture upload, against the per pixel loop the Orrery used to swizzle
+// its targa with. The conversions have to match exactly.
+static void pixelConversions(uint32_t count) {
+    std::vector<unsigned char> source(count * 4), simd(count * 4), scalar(count * 4);
+    srand(1234);
+    for (size_t i = 0; i < source.size(); i++) source[i] = (unsigned char)(rand() & 0xff);
+
+    const VBBPixelConversion conversions[] = {VBB_PIXELS_SWAP_RB, VBB_PIXELS_BGR_TO_RGBA, VBB_PIXELS_GREY_TO_RGBA, VBB_PIXELS_SWAP_RB};
+    const char* names[] = {"Swap RB", "BGR>RGBA", "Grey>RGBA", "Premul"};
+
+    const int repeats = 10;
+    StopWatch timer;
+
+    for (int kernel = 0; kernel < 4; kernel++) {
+        bool bPremultiply = (kernel == 3);
+        uint32_t sourceSize = vbbGetPixelConversionSizes(conversions[kernel]);
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++)
+            for (uint32_t i = 0; i < count; i++) {
+                const unsigned char* in = &source[i * sourceSize];
+                unsigned char* out = &scalar[i * 4];
+                if (sourceSize == 1) {
+                    out[0] = out[1] = out[2] = in[0];
+                    out[3] = 255;
+                } else {
+                    out[0] = in[2];
+                    out[1] = in[1];
+                    out[2] = in[0];
+                    out[3] = (sourceSize == 4) ? in[3] : 255;
+                }
+                if (bPremultiply)
+                    for (int k = 0; k < 3; k++) out[k] = (unsigned char)((out[k] * out[3] + 127) / 255);
+            }
+        double scalarTime = timer.getElapsedSeconds() / repeats;
+
+        timer.reset();
+        for (int r = 0; r < repeats; r++) vbbConvertPixels(conversions[kernel], source.data(), simd.data(), count, bPremultiply);
+        double simdTime = timer.getElapsedSeconds() / repeats;
+
+        std::cout << std::left << std::setw(10) << names[kernel] << std::right << std::setw(10) << count << std::fixed
+                  << std::setprecision(6) << std::setw(12) << scalarTime << std::setw(12) << simdTime << std::setprecision(2)
+                  << std::setw(10) << scalarTime / simdTime << "x" << (simd == scalar ? "" : "   FAILED!") << std::endl;
+    }
+}
+
+// *************************************************************************************
+// Full mip chains on the CPU, one thread and then all of them. MB/s is level 0 bytes in per second.
+// The chain has to come out the same however many threads make it.
+static void mipChainTimes(uint32_t size, uint32_t maxThreads) {
+    std::vector<unsigned char> image(size_t(size) * size * 4);
+    srand(99);
+    for (uint32_t y = 0; y < size; y++)
+        for (uint32_t x = 0; x < size * 4; x++) image[size_t(y) * size * 4 + x] = (unsigned char)(((x / 4 + y) >> 3) + (rand() & 15));
+
+    uint32_t levels = vbbGetMipLevelCount(size, size);
+    size_t chainSize = vbbGetMipChainSize(size, size, levels, 4);
+    std::vector<unsigned char> single(chainSize), threaded(chainSize);
+
+    const char* names[] = {"Box", "Kaiser", "Box sRGB", "Kaiser sRGB"};
+    StopWatch timer;
+    for (int kernel = 0; kernel < 4; kernel++) {
+        VBBMipFilter filter = (kernel & 1) ? VBB_MIP_FILTER_KAISER : VBB_MIP_FILTER_BOX;
+        bool bSRGB = (kernel >= 2);
+
+        timer.reset();
+        vbbGenerateMipChain(image.data(), single.data(), size, size, 4, levels, filter, bSRGB, 1);
+        double singleTime = timer.getElapsedSeconds();
+
+        timer.reset();
+        vbbGenerateMipChain(image.data(), threaded.data(), size, size, 4, levels, filter, bSRGB, maxThreads);
+        double threadedTime = timer.getElapsedSeconds();
+
+        double megabytes = double(image.size()) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(12) << names[kernel] << std::right << std::setw(8) << levels << std::fixed
+                  << std::setprecision(6) << std::setw(12) << singleTime << std::setw(12) << threadedTime << std::setprecision(0)
+                  << std::setw(10) << megabytes / singleTime << std::setw(10) << megabytes / threadedTime << std::setprecision(2)
+                  << std::setw(10) << singleTime / threadedTime << "x" << (single == threaded ? "" : "   FAILED!") << std::endl;
+    }
+}
+
+// *************************************************************************************
+// Targas from the Orrery, as they are and run length encoded. Size on disk, and how fast
+// each one loads (best of a few tries, MB of pixels per second). Both have to come out the same.
+static const char* kTargaFileName = "MeshBench.tga";
+
+// Greedy packets, a run as soon as two pixels match
+static bool writeRLETarga(const char* szFileName, TGAHEADER header, const unsigned char* pPixels, uint32_t depth) {
+    FILE* pFile = fopen(szFileName, "wb");
+    if (pFile == nullptr) return false;
+
+    header.imageType |= 8;
+    header.identsize = 0;
+    fwrite(&header, 18, 1, pFile);
+
+    uint32_t pixelCount = uint32_t(header.width) * header.height;
+    std::vector<unsigned char> packets;
+    uint32_t i = 0;
+    while (i < pixelCount) {
+        uint32_t run = 1;
+        while (i + run < pixelCount && run < 128 && memcmp(pPixels + i * depth, pPixels + (i + run) * depth, depth) == 0) run++;
+
+        if (run > 1) {
+            packets.push_back(uint8_t(0x80 | (run - 1)));
+            packets.insert(packets.end(), pPixels + i * depth, pPixels + (i + 1) * depth);
+            i += run;
+            continue;
+        }
+
+        uint32_t count = 1;
+        while (i + count < pixelCount && count < 128 &&
+               (i + count + 1 >= pixelCount ||
+                memcmp(pPixels + (i + count) * depth, pPixels + (i + count + 1) * depth, depth) != 0))
+            count++;
+
+        packets.push_back(uint8_t(count - 1));
+        packets.insert(packets.end(), pPixels + i * depth, pPixels + (i + count) * depth);
+        i += count;
+    }
+
+    bool bOK = fwrite(packets.data(), packets.size(), 1, pFile) == 1;
+    fclose(pFile);
+    return bOK;
+}
+
+static long fileSize(const char* szFileName) {
+    FILE* pFile = fopen(szFileName, "rb");
+    if (pFile == nullptr) return 0;
+    fseek(pFile, 0, SEEK_END);
+    long size = ftell(pFile);
+    fclose(pFile);
+    return size;
+}
+
+// Best of a few loads into the same buffer, like a staging buffer would be
+static double timeTarga(const char* szFileName, std::vector<unsigned char>& pixels) {
+    StopWatch timer;
+    double best = 1.0e30;
+    for (int pass = 0; pass < 5; pass++) {
+        uint32_t w, h, c;
+        VkFormat format;
+        timer.reset();
+        if (vbbReadTGABits(szFileName, &w, &h, &c, &format, pixels.data()) == nullptr) return 0.0;
+        double elapsed = timer.getElapsedSeconds();
+        if (elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+static void targaStats(const char* szDirectory, const char* szName) {
+    std::string fileName = std::string(szDirectory) + "/" + szName;
+
+    uint32_t w, h, c;
+    VkFormat format;
+    unsigned char* pBits = vbbReadTGABits(fileName.c_str(), &w, &h, &c, &format);
+    if (pBits == nullptr) {
+        std::cout << std::left << std::setw(14) << szName << "   not found" << std::endl;
+        return;
+    }
+
+    TGAHEADER header;
+    FILE* pFile = fopen(fileName.c_str(), "rb");
+    bool bOK = pFile != nullptr && fread(&header, 18, 1, pFile) == 1;
+    if (pFile != nullptr) fclose(pFile);
+
+    uint32_t depth = getBytesPerPixel(format);
+    size_t imageSize = size_t(w) * h * depth;
+    std::vector<unsigned char> raw(imageSize), rle(imageSize);
+    bOK = bOK && writeRLETarga(kTargaFileName, header, pBits, depth);
+
+    double rawTime = timeTarga(fileName.c_str(), raw);
+    double rleTime = timeTarga(kTargaFileName, rle);
+    bOK = bOK && rawTime > 0.0 && rleTime > 0.0 && memcmp(raw.data(), pBits, imageSize) == 0 && raw == rle;
+
+    long rawSize = fileSize(fileName.c_str());
+    long rleSize = fileSize(kTargaFileName);
+    remove(kTargaFileName);
+    free(pBits);
+
+    std::cout << std::left << std::setw(14) << szName << std::right << std::setw(10) << rawSize << std::setw(10) << rleSize
+              << std::fixed << std::setprecision(2) << std::setw(8) << double(rawSize) / double(rleSize) << std::setprecision(0)
+              << std::setw(12) << double(imageSize) / rawTime / 1.0e6 << std::setw(12) << double(imageSize) / rleTime / 1.0e6
+              << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// Getting a targa into staging memory (a plain buffer stands in for it here). The old way reads
+// it into a malloc'd buffer and then copies that, the mapped way decodes straight from the file
+// mapping into staging. Extra is how much memory the old way needs on top of the staging buffer.
+static void targaStagingTimes(const char* szDirectory, const char* szName) {
+    std::string fileName = std::string(szDirectory) + "/" + szName;
+    StopWatch timer;
+
+    VBBMappedFile file;
+    uint32_t w, h, c;
+    VkFormat format;
+    size_t imageSize = 0;
+    if (!file.open(fileName.c_str()) || !vbbGetTGAInfo(file.getData(), file.getSize(), &w, &h, &c, &format, &imageSize)) {
+        std::cout << std::left << std::setw(14) << szName << "   not found" << std::endl;
+        return;
+    }
+    file.close();
+
+    std::vector<unsigned char> readStaging(imageSize), mappedStaging(imageSize);
+    double readTime = 1.0e30, mappedTime = 1.0e30;
+    bool bOK = true;
+    for (int pass = 0; pass < 5; pass++) {
+        timer.reset();
+        unsigned char* pBits = vbbReadTGABits(fileName.c_str(), &w, &h, &c, &format);
+        if (pBits != nullptr) memcpy(readStaging.data(), pBits, imageSize);
+        free(pBits);
+        double elapsed = timer.getElapsedSeconds();
+        if (elapsed < readTime) readTime = elapsed;
+        bOK = bOK && pBits != nullptr;
+
+        timer.reset();
+        bOK = bOK && file.open(fileName.c_str()) && vbbDecodeTGA(file.getData(), file.getSize(), mappedStaging.data());
+        file.close();
+        elapsed = timer.getElapsedSeconds();
+        if (elapsed < mappedTime) mappedTime = elapsed;
+    }
+
+    bOK = bOK && readStaging == mappedStaging;
+
+    std::cout << std::left << std::setw(14) << szName << std::right << std::setw(10) << imageSize << std::fixed
+              << std::setprecision(6) << std::setw(12) << readTime << std::setw(12) << mappedTime << std::setprecision(2)
+              << std::setw(10) << readTime / mappedTime << "x" << std::setw(10) << imageSize << (bOK ? "" : "   FAILED!") << std::endl;
+}
+
+// *************************************************************************************
+// Optionally pass a detail level on the command line. Each step doubles the tessellation
+// in both directions. Be patient with the linear search at higher levels. The targas are
+// looked for in ../Orrery/OrreryData, or pass the folder after the detail level.
+int main(int argc, char* argv[]) {
+    uint32_t detail = 1;
+    if (argc > 1) detail = atoi(argv[1]);
+    if (detail < 1) detail = 1;
+
+    const char* szTargaDirectory = (argc > 2) ? argv[2] : "../Orrery/OrreryData";
+
+    uint32_t scale = 1 << (detail - 1);
+
+    std::cout << "Mesh welding benchmark, detail level " << detail << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(10) << "Vertices" << std::setw(10)
+              << "Indexes" << std::setw(12) << "Linear (s)" << std::setw(12) << "Hash (s)" << std::setw(11) << "Speedup"
+              << std::endl;
+
+    compareBuilders("Torus", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeTorus(mesh, 1.0f, 0.25f, uint16_t(64 * scale), uint16_t(32 * scale));
+    });
+
+    compareBuilders("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphere(mesh, 1.0, 64 * scale, 32 * scale); });
+
+    compareBuilders("Cylinder", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeCylinder(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale);
+    });
+
+    compareBuilders("Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDisk(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    std::cout << std::endl << "Grid generators (no welding)" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(10) << "Welded" << std::setw(10) << "Grid"
+              << std::setw(12) << "Welded (s)" << std::setw(12) << "Grid (s)" << std::setw(11) << "Speedup" << std::endl;
+
+    compareGrid(
+        "Torus",
+        [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeTorus(mesh, 1.0f, 0.25f, uint16_t(64 * scale), uint16_t(32 * scale)); },
+        [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 64 * scale, 32 * scale); });
+
+    compareGrid(
+        "Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphere(mesh, 1.0, 64 * scale, 32 * scale); },
+        [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphereGrid(mesh, 1.0, 64 * scale, 32 * scale); });
+
+    compareGrid(
+        "Cylinder", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeCylinder(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale); },
+        [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeCylinderGrid(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale); });
+
+    compareGrid(
+        "Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDisk(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); },
+        [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDiskGrid(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads < 4) maxThreads = 4;
+
+    std::cout << std::endl << "Grid generator thread scaling" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(10) << "Threads" << std::setw(12) << "Time (s)"
+              << std::setw(11) << "Speedup" << std::endl;
+
+    threadScaling("Torus", maxThreads, [scale](VBBSimpleIndexedMesh& mesh, uint32_t threads) {
+        VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 1024 * scale, 512 * scale, threads);
+    });
+
+    threadScaling("Sphere", maxThreads, [scale](VBBSimpleIndexedMesh& mesh, uint32_t threads) {
+        VBBMakeSphereGrid(mesh, 1.0, 1024 * scale, 512 * scale, threads);
+    });
+
+    std::cout << std::endl << "Vertex cache optimization, " << kCacheSize << " entry FIFO" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(12) << "ACMR" << std::setw(12) << "ACMR opt"
+              << std::setw(12) << "ATVR" << std::setw(12) << "ATVR opt" << std::setw(12) << "Time (s)" << std::endl;
+
+    compareOptimized("Torus", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeTorus(mesh, 1.0f, 0.25f, uint16_t(64 * scale), uint16_t(32 * scale));
+    });
+
+    compareOptimized("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphere(mesh, 1.0, 64 * scale, 32 * scale); });
+
+    compareOptimized("Cylinder", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeCylinder(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale);
+    });
+
+    compareOptimized("Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDisk(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    std::cout << std::endl << "Triangle lists vs strips with primitive restart" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(10) << "List (B)" << std::setw(10) << "Strip (B)"
+              << std::setw(10) << "Smaller" << std::setw(10) << "ACMR" << std::setw(10) << "ACMR st" << std::setw(12) << "Time (s)"
+              << std::endl;
+
+    compareStrips("Torus", [scale](VBBSimpleIndexedMesh& mesh, bool bStrips) {
+        VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 64 * scale, 32 * scale, 1, bStrips);
+    });
+    compareStrips("Sphere", [scale](VBBSimpleIndexedMesh& mesh, bool bStrips) {
+        VBBMakeSphereGrid(mesh, 1.0, 64 * scale, 32 * scale, 1, bStrips);
+    });
+    compareStrips("Cylinder", [scale](VBBSimpleIndexedMesh& mesh, bool bStrips) {
+        VBBMakeCylinderGrid(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale, 360, 1, bStrips);
+    });
+    compareStrips("Disk", [scale](VBBSimpleIndexedMesh& mesh, bool bStrips) {
+        VBBMakeDiskGrid(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale, 360, 1, bStrips);
+    });
+
+    std::cout << std::endl << "Meshlets, 64 vertices / 124 triangles, culled from (0, 0, 5)" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(10) << "Meshlets" << std::setw(12) << "Tris each"
+              << std::setw(12) << "Verts each" << std::setw(12) << "Culled" << std::setw(12) << "Time (s)" << std::endl;
+
+    meshletStats("Torus", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 64 * scale, 32 * scale); });
+    meshletStats("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphereGrid(mesh, 1.0, 64 * scale, 32 * scale); });
+    meshletStats("Cylinder", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeCylinderGrid(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale);
+    });
+    meshletStats("Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDiskGrid(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    std::cout << std::endl << "LOD chains, triangles (error)" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(12) << "Time (s)" << "  Levels" << std::endl;
+
+    lodChain("Torus", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 64 * scale, 32 * scale); });
+    lodChain("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphere(mesh, 1.0, 64 * scale, 32 * scale); });
+    lodChain("Cylinder", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeCylinderGrid(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale); });
+    lodChain("Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDiskGrid(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    std::cout << std::endl << "Bounding spheres, radius" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(12) << "Box" << std::setw(12) << "Added"
+              << std::setw(12) << "Updated" << std::setw(12) << "Time (s)" << std::endl;
+
+    boundsStats("Torus", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeTorus(mesh, 1.0f, 0.25f, uint16_t(64 * scale), uint16_t(32 * scale));
+    });
+    boundsStats("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphere(mesh, 1.0, 64 * scale, 32 * scale); });
+    boundsStats("Cylinder", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeCylinder(mesh, 1.0f, 0.5f, 2.0f, 64 * scale, 32 * scale);
+    });
+    boundsStats("Disk", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeDisk(mesh, 0.25f, 1.0f, 64 * scale, 32 * scale); });
+
+    std::cout << std::endl << "Frustum culling" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Bounds" << std::right << std::setw(10) << "Count" << std::setw(10) << "Visible"
+              << std::setw(12) << "Scalar (s)" << std::setw(12) << "SIMD (s)" << std::setw(11) << "Speedup" << std::endl;
+
+    cullingTimes(100000 * scale);
+
+    std::cout << std::endl << "Batch math" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Kernel" << std::right << std::setw(10) << "Count" << std::setw(12) << "Scalar (s)"
+              << std::setw(12) << "Batch (s)" << std::setw(11) << "Speedup" << std::endl;
+
+    mathKernels(1024 * 1024 * scale);
+
+    std::cout << std::endl << "Mesh files" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(12) << "Save (s)" << std::setw(12) << "Load (s)"
+              << std::setw(12) << "Map (s)" << std::setw(12) << "No CRC (s)" << std::endl;
+
+    meshFileTimes("Torus", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 1024 * scale, 512 * scale);
+    });
+
+    meshFileTimes("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphereGrid(mesh, 1.0, 1024 * scale, 512 * scale); });
+
+    std::cout << std::endl << "Compressed mesh files" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Mesh" << std::right << std::setw(12) << "Raw" << std::setw(12) << "Compressed"
+              << std::setw(10) << "Ratio" << std::setw(12) << "Save (s)" << std::setw(14) << "Decode GB/s" << std::endl;
+
+    codecStats("Torus", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeTorusGrid(mesh, 1.0f, 0.25f, 1024 * scale, 512 * scale); });
+    codecStats("Sphere", [scale](VBBSimpleIndexedMesh& mesh) { VBBMakeSphereGrid(mesh, 1.0, 1024 * scale, 512 * scale); });
+    codecStats("Strips", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeSphereGrid(mesh, 1.0, 1024 * scale, 512 * scale, 1, true);
+    });
+    codecStats("Welded", [scale](VBBSimpleIndexedMesh& mesh) {
+        VBBMakeTorus(mesh, 1.0f, 0.25f, uint16_t(256 * scale), uint16_t(128 * scale));
+    });
+
+    std::cout << std::endl << "Targa loading, raw vs RLE" << std::endl << std::endl;
+    std::cout << std::left << std::setw(14) << "Image" << std::right << std::setw(10) << "Raw" << std::setw(10) << "RLE"
+              << std::setw(8) << "Ratio" << std::setw(12) << "Raw MB/s" << std::setw(12) << "RLE MB/s" << std::endl;
+
+    const char* targaNames[] = {"Floor.tga", "HUD.tga", "Marslike.tga", "Pyramid.tga", "SUN.tga", "Terra.tga"};
+    for (const char* szName : targaNames) targaStats(szTargaDirectory, szName);
+
+    std::cout << std::endl << "Targa into staging memory, read and copy vs mapped" << std::endl << std::endl;
+    std::cout << std::left << std::setw(14) << "Image" << std::right << std::setw(10) << "Bytes" << std::setw(12) << "Read (s)"
+              << std::setw(12) << "Mapped (s)" << std::setw(11) << "Speedup" << std::setw(10) << "Extra" << std::endl;
+
+    for (const char* szName : targaNames) targaStagingTimes(szTargaDirectory, szName);
+
+    std::cout << std::endl << "Pixel conversion for texture upload" << std::endl << std::endl;
+    std::cout << std::left << std::setw(10) << "Kernel" << std::right << std::setw(10) << "Pixels" << std::setw(12) << "Scalar (s)"
+              << std::setw(12) << "SIMD (s)" << std::setw(11) << "Speedup" << std::endl;
+
+    pixelConversions(1024 * 1024 * scale);
+
+    std::cout << std::endl << "Mip chains, " << 2048 * scale << " x " << 2048 * scale << " RGBA" << std::endl << std::endl;
+    std::cout << std::left << std::setw(12) << "Filter" << std::right << std::setw(8) << "Levels" << std::setw(12) << "1 thread"
+              << std::setw(12) << maxThreads << " threads" << std::setw(10) << "MB/s" << std::setw(10) << "MB/s" << std::setw(11)
+              << "Speedup" << std::endl;
+
+    mipChainTimes(2048 * scale, maxThreads);
+
+    return 0;
+}
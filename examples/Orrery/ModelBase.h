@@ -14,6 +14,7 @@ and draw themselves.
 #include "VBBDescriptors.h"
 #include "VBBCanvas.h"
 #include "VBBUtils.h"
+#include "VBBGeometryPool.h"
 
 
 class ModelBase {
@@ -24,15 +25,31 @@ class ModelBase {
     virtual bool initModel(void) = 0;  // Init/load the model
     virtual bool drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4 mv) = 0;  // Pass in modelview matrix, projection, etc...
 
+    // Models that share vertex and index buffers. Set before initModel(), and bind the pool before drawModel().
+    void setGeometryPool(VBBGeometryPool* pPool) { pGeometryPool = pPool; }
+
+    // Models that share one texture array, and one descriptor set for it (binding 1). The layer comes in as
+    // the instance index. Set before initModel(), bind the set before drawModel(), with any of their layouts.
+    void setTextureLayer(VkDescriptorSetLayout layout, uint32_t layer) {
+        textureSetLayout = layout;
+        textureLayer = layer;
+    }
+
+    VkPipelineLayout getPipelineLayout(void) { return (pPipeline != nullptr) ? pPipeline->getPipelineLayout() : VK_NULL_HANDLE; }
+
 
  protected:
     // **************************** Passed these in *********************
     VmaAllocator        Allocator;
     VBBDevice*          pLogicalDevice = nullptr;
     VBBCanvas*          pCanvas = nullptr;
+    VBBGeometryPool*    pGeometryPool = nullptr;
+    VkDescriptorSetLayout textureSetLayout = VK_NULL_HANDLE;
+    uint32_t            textureLayer = 0;
 
 
     // **************************** Build these **************************
     VBBPipelineGraphics* pPipeline = nullptr;
+    uint32_t            geometryRange = VBB_GEOMETRY_POOL_INVALID;
 };
 
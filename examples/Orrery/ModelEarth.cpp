@@ -10,8 +10,6 @@ ModelEarth::ModelEarth(VmaAllocator vmaAllocator, VBBDevice* pDevice, VBBCanvas*
 
 ModelEarth::~ModelEarth() {
     delete pVertexBuffer;
-    delete pNormalBuffer;
-    delete pTexCoordBuffer;
 
     delete pIndexBuffer;
     delete pDescriptors;
@@ -23,9 +21,15 @@ bool ModelEarth::initModel(void) {
     pPipeline = new VBBPipelineGraphics();
     if (pPipeline == nullptr) return false;
 
-    // What does the attribute data look like, and what is it's location
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 0, VK_FORMAT_R32G32B32_SFLOAT);
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 1, VK_FORMAT_R32G32B32_SFLOAT);
+    // Positions, normals, and texture coordinates are interleaved in one buffer, locations 0, 1,
+    // and 2. All quantized, 16 bytes a vertex instead of 32.
+    VBBMakeSphere(sphere, 0.4f, 52, 26);
+    VBBMeshAttribute attributes[] = {VBB_MESH_ATTRIBUTE_POSITION, VBB_MESH_ATTRIBUTE_NORMAL, VBB_MESH_ATTRIBUTE_TEXCOORD};
+    VBBMeshEncoding encodings[] = {VBB_MESH_ENCODING_SNORM16, VBB_MESH_ENCODING_OCTAHEDRAL, VBB_MESH_ENCODING_UNORM16};
+    if (!sphere.makeInterleavedLayout(vertexLayout, 3, attributes, 4, 0, encodings)) return false;
+    vbbGetDequantizeMatrix(vertexLayout, dequantizeMatrix);
+
+    pPipeline->addInterleavedVertexBinding(vertexLayout);
 
     // Push constants are SO FREAKING EASY
     VkPushConstantRange pushConstant;
@@ -36,14 +40,18 @@ bool ModelEarth::initModel(void) {
     VBBShaderModule vertexShader;
     VBBShaderModule fragmentShader;
     // If these are undefined #define VBB_USE_SHADER_TOOLCHAIN
-    vertexShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLight.vert",
+    vertexShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLightLayerQ.vert",
                                  shaderc_glsl_default_vertex_shader);
 
-    fragmentShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLight.frag",
+    fragmentShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLightLayer.frag",
                                    shaderc_glsl_default_fragment_shader);
 
     pPipeline->setPushConstants(1, &pushConstant);
 
+    // The planet texture array
+    if (textureSetLayout == VK_NULL_HANDLE) return false;
+    pPipeline->setDescriptorSetLayouts(1, &textureSetLayout);
+
     pPipeline->setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     pPipeline->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
     pPipeline->setCullMode(VK_CULL_MODE_BACK_BIT);
@@ -54,30 +62,18 @@ bool ModelEarth::initModel(void) {
     VkResult lastResult = pPipeline->createPipeline(pCanvas, vertexShader.getShaderModule(), fragmentShader.getShaderModule());
     if (lastResult != VK_SUCCESS) return false;
 
-    VBBMakeSphere(sphere, 0.4f, 52, 26);
     indexCount = sphere.getIndexCount();
+    indexType = sphere.getIndexType();
     attribCount = sphere.getAttributeCount();
 
     pVertexBuffer = new VBBBufferDynamic(Allocator);
-    pVertexBuffer->createBuffer(sizeof(float) * 3 * attribCount);
+    pVertexBuffer->createBuffer(sphere.getInterleavedSize(vertexLayout));
     void* pMapped = pVertexBuffer->mapMemory();
-    memcpy(pMapped, sphere.getVertexPointer(), sizeof(float) * 3 * attribCount);
+    sphere.copyInterleaved(vertexLayout, pMapped);
     pVertexBuffer->unmapMemory();
 
-    pNormalBuffer = new VBBBufferDynamic(Allocator);
-    pNormalBuffer->createBuffer(sizeof(float) * 3 * attribCount);
-    pMapped = pNormalBuffer->mapMemory();
-    memcpy(pMapped, sphere.getNormalPointer(), sizeof(float) * 3 * attribCount);
-    pNormalBuffer->unmapMemory();
-
-    pTexCoordBuffer = new VBBBufferDynamic(Allocator);
-    pTexCoordBuffer->createBuffer(sizeof(float) * 2 * attribCount);
-    pMapped = pTexCoordBuffer->mapMemory();
-    memcpy(pMapped, sphere.getTexCoordPointer(), sizeof(float) * 2 * attribCount);
-    pTexCoordBuffer->unmapMemory();
-
     pIndexBuffer = new VBBBufferStatic(Allocator);
-    pIndexBuffer->createBuffer(sphere.getIndexPointer(), sizeof(uint32_t) * indexCount, pLogicalDevice);
+    pIndexBuffer->createBuffer(sphere.getIndexData(), sphere.getIndexDataSize(), pLogicalDevice);
 
     return true;
 }
@@ -89,7 +85,7 @@ bool ModelEarth::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4
     // Red lines
     pushConstantDef pc;
 
-    glm::mat4 mvp = proj * modelView;
+    glm::mat4 mvp = proj * modelView * glm::make_mat4(dequantizeMatrix);
     memcpy(pc.mvp, glm::value_ptr(mvp), sizeof(float) * 16);
 
     // Used to transform normals
@@ -105,9 +101,9 @@ bool ModelEarth::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4
     pc.packMatrix[9] = glm::value_ptr(modelView)[9];
     pc.packMatrix[10] = glm::value_ptr(modelView)[10];
 
-    // Store color of object
-    pc.packMatrix[12] = 0.0f;
-    pc.packMatrix[13] = 0.0f;
+    // Store color of object, the texture does the rest
+    pc.packMatrix[12] = 1.0f;
+    pc.packMatrix[13] = 1.0f;
     pc.packMatrix[14] = 1.0f;
     pc.packMatrix[15] = 1.0f;
 
@@ -118,12 +114,10 @@ bool ModelEarth::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
 
-    VkBuffer normalBuffers[] = {pNormalBuffer->getBuffer()};
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, indexType);
 
-    vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, 0);
+    // The textures are already bound, the instance picks the layer
+    vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, textureLayer);
 
     return true;
 }
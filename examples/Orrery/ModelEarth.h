@@ -12,14 +12,14 @@ class ModelEarth : public ModelBase {
 
   private:
     uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
     uint32_t attribCount = 0;
 
     VBBSimpleIndexedMesh sphere;
+    VBBInterleavedLayout vertexLayout;
+    float dequantizeMatrix[16];
 
-    VBBPipelineGraphics* pPipeline = nullptr;
-    VBBBufferDynamic* pVertexBuffer = nullptr;
-    VBBBufferDynamic* pNormalBuffer = nullptr;
-    VBBBufferDynamic* pTexCoordBuffer = nullptr;
+    VBBBufferDynamic* pVertexBuffer = nullptr;  // Interleaved position, normal, and texture coordinates
     VBBBufferStatic* pIndexBuffer = nullptr;
     VBBDescriptors* pDescriptors = nullptr;
 };
@@ -10,11 +10,6 @@ ModelEarthOrbit::ModelEarthOrbit(VmaAllocator vmaAllocator, VBBDevice* pDevice,
     : ModelBase(vmaAllocator, pDevice, pCanv) {}
 
 ModelEarthOrbit::~ModelEarthOrbit() {
-    delete pVertexBuffer;
-    delete pNormalBuffer;
-    delete pTexCoordBuffer;
-
-    delete pIndexBuffer;
     delete pDescriptors;
 }
 
@@ -25,8 +20,9 @@ bool ModelEarthOrbit::initModel(void) {
     if (pPipeline == nullptr) return false;
 
     // What does the attribute data look like, and what is it's location
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 0, VK_FORMAT_R32G32B32_SFLOAT);
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 1, VK_FORMAT_R32G32B32_SFLOAT);
+    // Positions and normals come from the shared geometry pool
+    if (pGeometryPool == nullptr) return false;
+    pPipeline->addInterleavedVertexBinding(pGeometryPool->getLayout());
 
     // Push constants are SO FREAKING EASY
     VkPushConstantRange pushConstant;
@@ -45,6 +41,9 @@ bool ModelEarthOrbit::initModel(void) {
 
     pPipeline->setPushConstants(1, &pushConstant);
 
+    // Doesn't sample it, but it's drawn while the planet textures are bound
+    if (textureSetLayout != VK_NULL_HANDLE) pPipeline->setDescriptorSetLayouts(1, &textureSetLayout);
+
     pPipeline->setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     pPipeline->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
     pPipeline->setCullMode(VK_CULL_MODE_BACK_BIT);
@@ -56,29 +55,8 @@ bool ModelEarthOrbit::initModel(void) {
     if (lastResult != VK_SUCCESS) return false;
 
     VBBMakeTorus(orbit, 10.0f, 0.04f, 100, 13);
-    indexCount = orbit.getIndexCount();
-    attribCount = orbit.getAttributeCount();
-
-    pVertexBuffer = new VBBBufferDynamic(Allocator);
-    pVertexBuffer->createBuffer(sizeof(float) * 3 * attribCount);
-    void* pMapped = pVertexBuffer->mapMemory();
-    memcpy(pMapped, orbit.getVertexPointer(), sizeof(float) * 3 * attribCount);
-    pVertexBuffer->unmapMemory();
-
-    pNormalBuffer = new VBBBufferDynamic(Allocator);
-    pNormalBuffer->createBuffer(sizeof(float) * 3 * attribCount);
-    pMapped = pNormalBuffer->mapMemory();
-    memcpy(pMapped, orbit.getNormalPointer(), sizeof(float) * 3 * attribCount);
-    pNormalBuffer->unmapMemory();
-
-    pTexCoordBuffer = new VBBBufferDynamic(Allocator);
-    pTexCoordBuffer->createBuffer(sizeof(float) * 2 * attribCount);
-    pMapped = pTexCoordBuffer->mapMemory();
-    memcpy(pMapped, orbit.getTexCoordPointer(), sizeof(float) * 2 * attribCount);
-    pTexCoordBuffer->unmapMemory();
-
-    pIndexBuffer = new VBBBufferStatic(Allocator);
-    pIndexBuffer->createBuffer(orbit.getIndexPointer(), sizeof(uint32_t) * indexCount, pLogicalDevice);
+    geometryRange = pGeometryPool->addMesh(orbit);
+    if (geometryRange == VBB_GEOMETRY_POOL_INVALID) return false;
 
     return true;
 }
@@ -114,17 +92,8 @@ bool ModelEarthOrbit::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::
 
     vkCmdPushConstants(cmdBuffer, pPipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstantDef), &pc);
 
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = {pVertexBuffer->getBuffer()};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = {pNormalBuffer->getBuffer()};
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-    vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, 0);
+    // The pool is already bound
+    pGeometryPool->draw(cmdBuffer, geometryRange);
 
     return true;
 }
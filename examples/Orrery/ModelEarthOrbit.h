@@ -11,15 +11,7 @@ class ModelEarthOrbit : public ModelBase {
                            glm::mat4 mv) override;  // Pass in modelview matrix, projection, etc...
 
   private:
-    uint32_t indexCount = 0;
-    uint32_t attribCount = 0;
-
     VBBSimpleIndexedMesh orbit;
 
-    VBBPipelineGraphics* pPipeline = nullptr;
-    VBBBufferDynamic* pVertexBuffer = nullptr;
-    VBBBufferDynamic* pNormalBuffer = nullptr;
-    VBBBufferDynamic* pTexCoordBuffer = nullptr;
-    VBBBufferStatic* pIndexBuffer = nullptr;
     VBBDescriptors* pDescriptors = nullptr;
 };
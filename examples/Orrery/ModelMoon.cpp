@@ -9,11 +9,6 @@ struct pushConstantDef {
 ModelMoon::ModelMoon(VmaAllocator vmaAllocator, VBBDevice* pDevice, VBBCanvas* pCanv) : ModelBase(vmaAllocator, pDevice, pCanv) {}
 
 ModelMoon::~ModelMoon() {
-    delete pVertexBuffer;
-    delete pNormalBuffer;
-    delete pTexCoordBuffer;
-
-    delete pIndexBuffer;
     delete pDescriptors;
 }
 
@@ -24,8 +19,9 @@ bool ModelMoon::initModel(void) {
     if (pPipeline == nullptr) return false;
 
     // What does the attribute data look like, and what is it's location
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 0, VK_FORMAT_R32G32B32_SFLOAT);
-    pPipeline->addVertexAttributeBinding(sizeof(float) * 3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 1, VK_FORMAT_R32G32B32_SFLOAT);
+    // Positions, normals, and texture coordinates come from the shared geometry pool
+    if (pGeometryPool == nullptr) return false;
+    pPipeline->addInterleavedVertexBinding(pGeometryPool->getLayout());
 
     // Push constants are SO FREAKING EASY
     VkPushConstantRange pushConstant;
@@ -36,14 +32,18 @@ bool ModelMoon::initModel(void) {
     VBBShaderModule vertexShader;
     VBBShaderModule fragmentShader;
     // If these are undefined #define VBB_USE_SHADER_TOOLCHAIN
-    vertexShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLight.vert",
+    vertexShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLightLayer.vert",
                                  shaderc_glsl_default_vertex_shader);
 
-    fragmentShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLight.frag",
+    fragmentShader.loadGLSLANGFile(pLogicalDevice->getDevice(), "OrreryData/StockShader_FakeLightLayer.frag",
                                    shaderc_glsl_default_fragment_shader);
 
     pPipeline->setPushConstants(1, &pushConstant);
 
+    // The planet texture array
+    if (textureSetLayout == VK_NULL_HANDLE) return false;
+    pPipeline->setDescriptorSetLayouts(1, &textureSetLayout);
+
     pPipeline->setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     pPipeline->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
     pPipeline->setCullMode(VK_CULL_MODE_BACK_BIT);
@@ -55,29 +55,9 @@ bool ModelMoon::initModel(void) {
     if (lastResult != VK_SUCCESS) return false;
 
     VBBMakeSphere(sphere, 0.15f, 52, 26);
-    indexCount = sphere.getIndexCount();
-    attribCount = sphere.getAttributeCount();
-
-    pVertexBuffer = new VBBBufferDynamic(Allocator);
-    pVertexBuffer->createBuffer(sizeof(float) * 3 * attribCount);
-    void* pMapped = pVertexBuffer->mapMemory();
-    memcpy(pMapped, sphere.getVertexPointer(), sizeof(float) * 3 * attribCount);
-    pVertexBuffer->unmapMemory();
-
-    pNormalBuffer = new VBBBufferDynamic(Allocator);
-    pNormalBuffer->createBuffer(sizeof(float) * 3 * attribCount);
-    pMapped = pNormalBuffer->mapMemory();
-    memcpy(pMapped, sphere.getNormalPointer(), sizeof(float) * 3 * attribCount);
-    pNormalBuffer->unmapMemory();
-
-    pTexCoordBuffer = new VBBBufferDynamic(Allocator);
-    pTexCoordBuffer->createBuffer(sizeof(float) * 2 * attribCount);
-    pMapped = pTexCoordBuffer->mapMemory();
-    memcpy(pMapped, sphere.getTexCoordPointer(), sizeof(float) * 2 * attribCount);
-    pTexCoordBuffer->unmapMemory();
-
-    pIndexBuffer = new VBBBufferStatic(Allocator);
-    pIndexBuffer->createBuffer(sphere.getIndexPointer(), sizeof(uint32_t) * indexCount, pLogicalDevice);
+    geometryRange = pGeometryPool->addMesh(sphere);
+    if (geometryRange == VBB_GEOMETRY_POOL_INVALID) return false;
+
     return true;
 }
 
@@ -112,17 +92,8 @@ bool ModelMoon::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4 m
 
     vkCmdPushConstants(cmdBuffer, pPipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstantDef), &pc);
 
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = {pVertexBuffer->getBuffer()};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = {pNormalBuffer->getBuffer()};
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-    vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, 0);
+    // The pool and the textures are already bound, the instance picks the layer
+    pGeometryPool->draw(cmdBuffer, geometryRange, 1, textureLayer);
 
     return true;
 }
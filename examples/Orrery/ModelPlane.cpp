@@ -19,24 +19,9 @@ ModelPlane::~ModelPlane() {
 
 bool ModelPlane::initModel(void) {
 
-    uint32_t w, h, c;
-    VkFormat format;
-    unsigned char* pBytes = vbbReadTGABits("OrreryData/MilkyWay.tga", &w, &h, &c, &format, nullptr);
-
-    // Incredi-Hac.... remap BGRA to RGBA
-    for (int i = 0; i < w * h * 4; i += 4) {
-        unsigned char red = pBytes[i];
-        pBytes[i] = pBytes[i + 2];
-        pBytes[i + 2] = red;
-    }
-
-
-    
+    // The targa is BGRA, the texture swizzles it to whatever the device samples
     pTexture = new VBBTexture(Allocator, pLogicalDevice);
-    int bytes = 4 * w * h;
-    pTexture->loadRawTexture(pBytes, format, c, w, h, bytes);
-
-    free(pBytes);
+    if (!pTexture->loadTGATexture("OrreryData/MilkyWay.tga")) return false;
 
     // **************************************************
     // Create the pipeline
@@ -86,6 +71,7 @@ bool ModelPlane::initModel(void) {
 
     VBBMakeDisk(plane, 0.0f, 13.0f, 100, 13);
     indexCount = plane.getIndexCount();
+    indexType = plane.getIndexType();
     attribCount = plane.getAttributeCount();
 
     pVertexBuffer = new VBBBufferDynamic(Allocator);
@@ -101,7 +87,7 @@ bool ModelPlane::initModel(void) {
     pTexCoordBuffer->unmapMemory();
 
     pIndexBuffer = new VBBBufferStatic(Allocator);
-    pIndexBuffer->createBuffer(plane.getIndexPointer(), sizeof(uint32_t) * indexCount, pLogicalDevice);
+    pIndexBuffer->createBuffer(plane.getIndexData(), plane.getIndexDataSize(), pLogicalDevice);
 
     return true;
 }
@@ -170,7 +156,7 @@ bool ModelPlane::drawModel(VkCommandBuffer cmdBuffer, glm::mat4 proj, glm::mat4
     VkBuffer textureBuffer[] = {pTexCoordBuffer->getBuffer()};
     vkCmdBindVertexBuffers(cmdBuffer, 1, 1, textureBuffer, offsets);
 
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(cmdBuffer, pIndexBuffer->getBuffer(), 0, indexType);
 
     vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, 0);
 
@@ -13,6 +13,7 @@ class ModelPlane : public ModelBase {
 
   private:
     uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
     uint32_t attribCount = 0;
 
     VBBSimpleIndexedMesh plane;
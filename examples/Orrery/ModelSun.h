@@ -14,15 +14,7 @@ class ModelSun : public ModelBase
 
 
   private:
-    uint32_t indexCount = 0;
-    uint32_t attribCount = 0;
-
     VBBSimpleIndexedMesh sphere;
 
-    VBBPipelineGraphics* pPipeline = nullptr;
-    VBBBufferDynamic* pVertexBuffer = nullptr;
-    VBBBufferDynamic* pNormalBuffer = nullptr;
-    VBBBufferDynamic* pTexCoordBuffer = nullptr;
-    VBBBufferStatic* pIndexBuffer = nullptr;
     VBBDescriptors* pDescriptors = nullptr;
 };
@@ -25,6 +25,9 @@ Orrery::~Orrery(void) {
     delete pMoon;
     delete pEarthOrbit;
     delete pPlane;
+    delete pGeometry;
+    delete pPlanetDescriptors;
+    delete pPlanetTextures;
 
 }
 
@@ -35,21 +38,66 @@ bool Orrery::initOrrery(VmaAllocator vmaAllocator, VBBDevice* pDevice, VBBCanvas
     pLogicalDevice = pDevice;
     pCanvas = pCanv;
 
+    // Positions, normals, and texture coordinates, interleaved
+    VBBMeshAttribute attributes[] = { VBB_MESH_ATTRIBUTE_POSITION, VBB_MESH_ATTRIBUTE_NORMAL, VBB_MESH_ATTRIBUTE_TEXCOORD };
+    pGeometry = new VBBGeometryPool(allocator);
+    pGeometry->setLayout(3, attributes);
+
+    // All the planet textures are the same size, so they go in one array, one layer each. Sun is
+    // layer 0, Earth 1, and the moon uses the Marslike one, layer 2.
+    const char* planetFiles[] = { "OrreryData/SUN.tga", "OrreryData/Terra.tga", "OrreryData/Marslike.tga" };
+    pPlanetTextures = new VBBTexture(allocator, pLogicalDevice);
+    if (!pPlanetTextures->loadTGATextureLayers(planetFiles, 3))
+        return false;
+
+    // Written once, it never changes
+    pPlanetDescriptors = new VBBDescriptors();
+    if (pPlanetDescriptors->init(pCanvas->getLogicalDevice(), 1, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT) != VK_SUCCESS)
+        return false;
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = pPlanetTextures->getLayout();
+    imageInfo.imageView = pPlanetTextures->getImageView();
+    imageInfo.sampler = pPlanetTextures->getSampler();
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = pPlanetDescriptors->getDescriptorSet();
+    descriptorWrite.dstBinding = 1;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.pImageInfo = &imageInfo;
+    descriptorWrite.descriptorCount = 1;
+    vkUpdateDescriptorSets(pCanvas->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+
+    VkDescriptorSetLayout planetLayout = pPlanetDescriptors->getLayout();
+
     pSun = new ModelSun(allocator, pLogicalDevice, pCanvas);
+    pSun->setGeometryPool(pGeometry);
+    pSun->setTextureLayer(planetLayout, 0);
     pSun->initModel();
 
     pAxes = new ModelAxes(allocator, pLogicalDevice, pCanvas);
     pAxes->initModel();
 
     pEarth = new ModelEarth(allocator, pLogicalDevice, pCanvas);
+    pEarth->setTextureLayer(planetLayout, 1);
     pEarth->initModel();
 
     pMoon = new ModelMoon(allocator, pLogicalDevice, pCanvas);
+    pMoon->setGeometryPool(pGeometry);
+    pMoon->setTextureLayer(planetLayout, 2);
     pMoon->initModel();
 
     pEarthOrbit = new ModelEarthOrbit(allocator, pLogicalDevice, pCanvas);
+    pEarthOrbit->setGeometryPool(pGeometry);
+    pEarthOrbit->setTextureLayer(planetLayout, 0);
     pEarthOrbit->initModel();
 
+    // Everything in the pool goes up together
+    if (pGeometry->createBuffers(pLogicalDevice) != VK_SUCCESS)
+        return false;
+
     pPlane = new ModelPlane(allocator, pLogicalDevice, pCanvas);
     pPlane->initModel();
 
@@ -103,6 +151,12 @@ void Orrery::renderSolarSystem(VkCommandBuffer cmdBuffer, float timeStep, bool b
     sunPos = glm::translate(sunPos, glm::vec3(0.0f, 0.0f, -30.0f));
     sunPos = glm::rotate(sunPos, glm::radians(7.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     sunPos = glm::translate(sunPos, glm::vec3(0.0f, -1.5f, 0.0f));
+
+    // One texture bind for everybody, they all have the same layout. The Earth has its own
+    // buffers, so everything in the pool goes first.
+    VkDescriptorSet planetSet = pPlanetDescriptors->getDescriptorSet();
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pSun->getPipelineLayout(), 0, 1, &planetSet, 0, nullptr);
+    pGeometry->bind(cmdBuffer);
     pSun->drawModel(cmdBuffer, proj, sunPos);
 
     glm::mat4 orbitPos = sunPos;
@@ -116,7 +170,6 @@ void Orrery::renderSolarSystem(VkCommandBuffer cmdBuffer, float timeStep, bool b
     earthPos = glm::rotate(earthPos, glm::radians(7.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     earthPos = glm::rotate(earthPos, earthRot, glm::vec3(0.0f, 1.0f, 0.0f));
     earthPos = glm::translate(earthPos, glm::vec3(10.0f, 0.0f, 0.0f));
-    pEarth->drawModel(cmdBuffer, proj, earthPos);
 
     static float moonRot = 0.0f;
     moonRot += timeStep * 1.0f;
@@ -126,4 +179,6 @@ void Orrery::renderSolarSystem(VkCommandBuffer cmdBuffer, float timeStep, bool b
     moonPos = glm::translate(moonPos, glm::vec3(1.0f, 0.0f, 0.0f));
 
     pMoon->drawModel(cmdBuffer, proj, moonPos);
+
+    pEarth->drawModel(cmdBuffer, proj, earthPos);
 }
@@ -14,6 +14,7 @@
 #include "ModelAxes.h"
 #include "ModelEarthOrbit.h"
 #include "ModelPlane.h"
+#include "VBBTexture.h"
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -39,6 +40,13 @@ protected:
     ModelEarthOrbit* pEarthOrbit = nullptr;
     ModelPlane* pPlane = nullptr;
 
+    // Sun, moon, and orbit all come out of here, one bind for all three
+    VBBGeometryPool* pGeometry = nullptr;
+
+    // And sun, earth, and moon share one texture array, one descriptor set, one bind
+    VBBTexture* pPlanetTextures = nullptr;
+    VBBDescriptors* pPlanetDescriptors = nullptr;
+
     glm::mat4 proj;
 
     void renderSolarSystem(VkCommandBuffer cmdBuffer, float timeStep, bool bMirror = false);
@@ -0,0 +1,54 @@
+#version 450
+// Fake light, for quantized meshes, textured from an array. Same as
+// StockShader_FakeLightLayer.vert, but positions are 16-bit normalized,
+// normals are octahedral encoded, and texture coordinates are 16-bit
+// unsigned normalized (see VBBSimpleIndexedMesh::makeInterleavedLayout).
+// Fold the matrix from vbbGetDequantizeMatrix() into the mvp matrix to
+// get the positions back.
+
+
+layout(push_constant) uniform PC {
+    mat4 mvpMatrix;     // Modelview Projection matrix, times the dequantize matrix
+    mat4 packed;        // Normal matrix and color packed       
+} PushConstants;
+
+
+// Atributes for the geometry
+layout(location = 0) in vec4 inPosition;    // R16G16B16A16_SNORM, w is 1
+layout(location = 1) in vec2 inNormal;      // R16G16_SNORM, octahedral
+layout(location = 2) in vec2 inTexCoord;    // R16G16_UNORM
+
+
+// Interpolate towards fragment shader
+layout(location = 0) out vec4 vColor;
+layout(location = 1) out vec3 vNormal;
+layout(location = 2) out vec2 vTexCoord;
+layout(location = 3) flat out float vLayer;
+
+
+// Unfold the octahedron
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+    }
+
+
+void main(void) {   
+    // Do the lighting stuff
+    // Extract rotation matrix from packed matrix
+    mat3 rot = mat3(normalize(PushConstants.packed[0].xyz),
+                normalize(PushConstants.packed[1].xyz),
+                normalize(PushConstants.packed[2].xyz));
+                
+	// Output to fragment shader
+	vNormal = rot * octDecode(inNormal);
+    vColor = PushConstants.packed[3];
+    vTexCoord = inTexCoord;
+    vLayer = float(gl_InstanceIndex);
+
+	// Normal geometry transformation stuff
+    gl_Position = PushConstants.mvpMatrix * inPosition; 
+    }
@@ -24,6 +24,7 @@
 #include "VBBInstance.h"
 #include "VBBPhysicalDevices.h"
 #include "VBBCanvas.h"
+#include "VBBStagingRing.h"
 
 #include "Orrery.h"
 
@@ -247,6 +248,11 @@ int main(int argc, char *argv[]) {
     VmaAllocator Allocator;
     vmaCreateAllocator(&allocatorCreateInfo, &Allocator);
     printf("VMA Allocator created\n");
+
+    // Everything that's uploaded goes through here
+    VBBStagingRing stagingRing;
+    stagingRing.init(&logicalDevice, Allocator);
+    logicalDevice.setStagingRing(&stagingRing);
     
     VBBCanvas *pVulkanCanvas = new VBBCanvas(&logicalDevice, Allocator);
     pVulkanCanvas->setViewportFlip(VK_TRUE);
@@ -267,6 +273,13 @@ int main(int argc, char *argv[]) {
     pOrrery->initOrrery(Allocator, &logicalDevice, pVulkanCanvas);
     printf("Orrery Initialized\n");
 
+    VBBStagingStats stagingStats;
+    stagingRing.getStats(stagingStats);
+    printf("Staged %llu bytes in %llu allocations, %llu stalls, %llu wraparounds, %llu dedicated\n",
+           (unsigned long long)stagingStats.bytesStaged, (unsigned long long)stagingStats.allocations,
+           (unsigned long long)stagingStats.stalls, (unsigned long long)stagingStats.wraparounds,
+           (unsigned long long)stagingStats.dedicated);
+
     SDL_Event event;
     bool bDone = false;
     while (!bDone) {
@@ -292,6 +305,9 @@ int main(int argc, char *argv[]) {
     delete pOrrery;
     delete pVulkanCanvas;
 
+    logicalDevice.setStagingRing(nullptr);
+    stagingRing.shutdown();
+
     vkDestroySurfaceKHR(vulkanInstance.getInstance(), surface, nullptr);
 
     SDL_Quit();
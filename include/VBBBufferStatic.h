@@ -28,6 +28,8 @@
 
 #include "VBBBufferDynamic.h"
 #include "VBBDevice.h"
+#include "VBBUploadService.h"
+#include "VBBStagingRing.h"
 
 ///////////////////////////////////////////////////////////////
 // Create a dynamic buffer
@@ -44,9 +46,12 @@ class VBBBufferStatic {
     void free(void);
 
     // Many ways to update this buffer
-    // Easy convienient way
+    // Easy convienient way, staged through the device's staging ring if it has one
     bool updateBuffer(void* pData, VkDeviceSize size, VBBDevice* pLogicalDevice);
 
+    // In the background. pData has to stay around until the ticket is complete, and so does this buffer.
+    VBBUploadTicket updateBuffer(const void* pData, VkDeviceSize size, VBBUploadService& uploader, VkDeviceSize dstOffset = 0);
+
     // A little more control, possibly streamlined
     bool updateBuffer(VBBBufferDynamic& dynamicBuffer, VBBDevice* pLogicalDevice, VkCommandBuffer cmdBuffer = VK_NULL_HANDLE, VkDeviceSize srcOffset = 0,
                       VkDeviceSize dstOffset = 0, VkDeviceSize size = 0);
@@ -25,6 +25,8 @@
 #include <cstring>
 #include "VBBInstance.h"
 
+class VBBStagingRing;
+
 class VBBDevice {
     // This class is usualy made by the VkPhysicalDevices, so it needs access to it's internal structures
     friend class VBBPhysicalDevices;
@@ -38,6 +40,20 @@ class VBBDevice {
     VkPhysicalDevice getPhysicalDeviceHandle(void) { return m_physicalDevice; }
     VkCommandPool getCommandPool(void) { return m_commandPool; }
     VkQueue getQueue(void) { return m_primaryQueue; }
+    uint32_t getQueueFamily(void) { return m_queueFamilyIndex; }
+
+    // Queue for uploads. It's the primary queue if the device doesn't have another one.
+    VkQueue getTransferQueue(void) { return m_transferQueue; }
+    uint32_t getTransferQueueFamily(void) { return m_transferQueueFamilyIndex; }
+    bool isTransferQueueShared(void) { return m_transferQueue == m_primaryQueue; }
+
+    // The device is made with every feature it supports turned on, so this is also what it supports
+    const VkPhysicalDeviceFeatures& getEnabledFeatures(void) { return m_enabledFeatures; }
+
+    // Staging everything that uploads to this device shares, see VBBStagingRing.h. Not owned, and it
+    // has to go before the allocator it was made with does.
+    void setStagingRing(VBBStagingRing* pRing) { m_pStagingRing = pRing; }
+    VBBStagingRing* getStagingRing(void) { return m_pStagingRing; }
 
     VkResult allocateCommandBuffers(VkCommandBuffer* pCommandBuffers, uint32_t nCount);
     void releaseCommandBuffers(VkCommandBuffer* pCommandBuffers, uint32_t nCount);
@@ -51,8 +67,14 @@ class VBBDevice {
 
     VkQueue m_primaryQueue = VK_NULL_HANDLE;
     uint32_t m_queueFamilyIndex = 0;
+    VkPhysicalDeviceFeatures m_enabledFeatures = {};
+
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
+    uint32_t m_transferQueueFamilyIndex = 0;
 
     VkCommandPool m_commandPool = VK_NULL_HANDLE;
 
+    VBBStagingRing* m_pStagingRing = nullptr;
+
     std::vector<const char*> m_requiredDeviceExtensions;
 };
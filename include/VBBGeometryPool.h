@@ -0,0 +1,140 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Many meshes in one vertex buffer and one index buffer.
+
+    Add each mesh with addMesh(), which hands back a range with where its indexes and vertices
+    ended up, then createBuffers() uploads everything at once. A whole scene is then one bind()
+    and a vkCmdDrawIndexed() per mesh (draw()), or a single indirect draw for all of them
+    (drawAll()). Everything in a pool has the same interleaved vertex layout, so anything drawn
+    together from it needs to use the same pipeline vertex input (addInterleavedVertexBinding()
+    with getLayout()). Strips and lists can share a pool, but not a draw, so drawAll() only draws
+    the meshes with the topology it's given.
+
+    Indexes stay local to each mesh and the range's vertexOffset is added by the draw, so the
+    index buffer is 16-bit as long as no single mesh has more than 0xFFFF vertices.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include <vector>
+#include "VBBUtils.h"
+#include "VBBDevice.h"
+#include "VBBBufferStatic.h"
+
+// addMesh() didn't work
+#define VBB_GEOMETRY_POOL_INVALID 0xFFFFFFFF
+
+// Where one mesh lives in the pool. Same meaning as the vkCmdDrawIndexed() parameters.
+struct VBBGeometryRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+    uint32_t vertexCount;
+    VkPrimitiveTopology topology;
+
+    // SNORM16 positions are quantized against each mesh's own bounds. See vbbGetDequantizeMatrix().
+    float positionScale[3];
+    float positionOffset[3];
+};
+
+class VBBGeometryPool {
+  public:
+    VBBGeometryPool(VmaAllocator allocator) { m_VMA = allocator; }
+    ~VBBGeometryPool(void);
+
+    // What every vertex in the pool looks like. Same parameters as makeInterleavedLayout().
+    bool setLayout(uint32_t attributeCount, const VBBMeshAttribute* pAttributes, const VBBMeshEncoding* pEncodings = nullptr,
+                   uint32_t alignment = 4);
+    const VBBInterleavedLayout& getLayout(void) { return m_layout; }
+
+    // Copies the mesh into the pool, returns the range index or VBB_GEOMETRY_POOL_INVALID
+    // if the mesh doesn't have the attributes in the layout.
+    uint32_t addMesh(VBBSimpleIndexedMesh& mesh);
+
+    // Upload. The pool keeps its copy, so more meshes can be added and this called again.
+    VkResult createBuffers(VBBDevice* pLogicalDevice);
+
+    uint32_t getRangeCount(void) { return static_cast<uint32_t>(m_ranges.size()); }
+    const VBBGeometryRange& getRange(uint32_t range) { return m_ranges[range]; }
+    VkIndexType getIndexType(void) { return m_indexType; }
+
+    // Vertex buffer at the binding, and the index buffer
+    void bind(VkCommandBuffer cmdBuffer, uint32_t binding = 0);
+
+    // Draw one mesh, or every mesh of one topology with one indirect draw. The pool has to be bound
+    // first, and the pipeline has to match the topology.
+    void draw(VkCommandBuffer cmdBuffer, uint32_t range, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+    void drawAll(VkCommandBuffer cmdBuffer, VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+    VkBuffer getVertexBuffer(void) { return (m_pVertexBuffer != nullptr) ? m_pVertexBuffer->getBuffer() : VK_NULL_HANDLE; }
+    VkBuffer getIndexBuffer(void) { return (m_pIndexBuffer != nullptr) ? m_pIndexBuffer->getBuffer() : VK_NULL_HANDLE; }
+    VkBuffer getDrawBuffer(void) { return (m_pDrawBuffer != nullptr) ? m_pDrawBuffer->getBuffer() : VK_NULL_HANDLE; }
+
+    // How much work it's saving. Allocations are buffers made by createBuffers(), the others
+    // count commands recorded since the last resetCounters().
+    uint32_t getAllocationCount(void) { return m_allocationCount; }
+    uint32_t getBindCount(void) { return m_bindCount; }
+    uint32_t getDrawCount(void) { return m_drawCount; }
+    void resetCounters(void) {
+        m_bindCount = 0;
+        m_drawCount = 0;
+    }
+
+    void free(void);
+
+  protected:
+    VmaAllocator m_VMA = VK_NULL_HANDLE;
+    VBBInterleavedLayout m_layout;
+    uint32_t m_alignment = 4;
+    bool m_bMultiDrawIndirect = false;
+
+    std::vector<unsigned char> m_vertices;  // Interleaved
+    std::vector<uint32_t> m_indexes;        // Local to each mesh
+    std::vector<VBBGeometryRange> m_ranges;
+    uint32_t m_maxMeshVertices = 0;
+    VkIndexType m_indexType = VK_INDEX_TYPE_UINT16;
+
+    VBBBufferStatic* m_pVertexBuffer = nullptr;
+    VBBBufferStatic* m_pIndexBuffer = nullptr;
+    VBBBufferStatic* m_pDrawBuffer = nullptr;  // VkDrawIndexedIndirectCommand for each range, grouped by topology
+
+    // Where each topology's draws are in the draw buffer
+    struct DrawSpan {
+        VkPrimitiveTopology topology;
+        uint32_t first;
+        uint32_t count;
+    };
+    std::vector<DrawSpan> m_drawSpans;
+
+    uint32_t m_allocationCount = 0;
+    uint32_t m_bindCount = 0;
+    uint32_t m_drawCount = 0;
+};
@@ -0,0 +1,60 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    A read only view of a whole file. The pages come in from the OS file cache as they are touched,
+    nothing is read up front and nothing is copied. Used by VBBMeshFile, and to decode textures
+    straight into staging memory.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+class VBBMappedFile {
+  public:
+    VBBMappedFile(void) {}
+    ~VBBMappedFile(void) { close(); }
+
+    // Fails if the file can't be mapped or is smaller than minSize bytes
+    bool open(const char* szFileName, size_t minSize = 0);
+    void close(void);
+    bool isOpen(void) { return m_pData != nullptr; }
+
+    const unsigned char* getData(void) { return m_pData; }
+    size_t getSize(void) { return m_size; }
+
+  protected:
+    const unsigned char* m_pData = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_hFile = nullptr;
+    void* m_hMapping = nullptr;
+#endif
+
+  private:
+    // One owner per mapping
+    VBBMappedFile(const VBBMappedFile&);
+    VBBMappedFile& operator=(const VBBMappedFile&);
+};
@@ -0,0 +1,55 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Small batch math for mesh data. Arrays are packed float[3] (VBBSimpleVertex and
+    VBBSimpleNormal are laid out that way), and are done four at a time with SSE or NEON
+    when the compiler has it, one at a time otherwise. Matrices are column major, like glm.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VBB_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VBB_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Unit length, in place. Zero length vectors are left alone.
+void vbbNormalizeArray(float* pVectors, uint32_t count);
+
+// Points get the whole 4x4 (w = 1, no divide), vectors just a 3x3. pOut can be pIn.
+void vbbTransformPoints(const float matrix[16], const float* pIn, float* pOut, uint32_t count);
+void vbbTransformVectors(const float matrix[9], const float* pIn, float* pOut, uint32_t count);
+
+// Inverse transpose of the upper 3x3, for normals. It's not divided by the determinant, so
+// normalize afterwards. Returns the determinant, negative means the matrix mirrors.
+float vbbGetNormalMatrix(const float matrix[16], float normalMatrix[9]);
+
+// sin and cos of i * step for i = 0 to count - 1, so rings that share angles only work them out
+// once. bWrap makes the last one exactly the same as the first, so seams close.
+void vbbMakeSinCosTable(uint32_t count, double step, double* pSin, double* pCos, bool bWrap = false);
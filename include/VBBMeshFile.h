@@ -0,0 +1,163 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Binary mesh file, version 2. Replaces the raw dump that VBBSimpleIndexedMesh::saveMesh()
+    used to write (which can still be read).
+
+    Layout (little endian):
+        VBBMeshFileHeader
+        VBBMeshFileSection[sectionCount]     attribute table
+        section data, each starting on a VBB_MESH_FILE_ALIGNMENT boundary
+
+    The checksum is a CRC32 of the whole file, taking the checksum field as zero. Files are
+    memory mapped when opened, and getSectionData() points right into the mapping, so the data
+    can be copied straight into a mapped staging buffer (or uploaded directly) without going
+    through another copy first.
+
+    Compressed files (VBB_MESH_FILE_FLAG_COMPRESSED) store every section through encodeStream().
+    Each section is cut into blocks of up to VBB_MESH_CODEC_BLOCK_SIZE bytes. In a block every
+    element (a 16-bit index, or one float of a vertex) becomes the difference from the same
+    element of the previous vertex, ZigZag folded so small negative numbers stay small. Then
+    the bytes are split out into planes (all the low bytes, then the next byte up...) so the high
+    planes come out mostly zero, and the planes are packed as runs of zeros and runs of literal
+    bytes. The section's stride, count, and format describe the decoded data, size is what's in
+    the file. decodeSection() unpacks one block at a time through a small scratch buffer, so it
+    can write straight into mapped memory.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "VBBMappedFile.h"
+
+class VBBSimpleIndexedMesh;
+
+#define VBB_MESH_FILE_MAGIC 0x4D424256  // "VBBM"
+#define VBB_MESH_FILE_VERSION 2
+#define VBB_MESH_FILE_ALIGNMENT 16
+
+// Header flags
+#define VBB_MESH_FILE_FLAG_TRIANGLE_STRIP 0x00000001  // Indexes are strips with primitive restarts
+#define VBB_MESH_FILE_FLAG_COMPRESSED 0x00000002      // Sections are packed with encodeStream()
+
+// Largest block the codec works on, and the largest element stride it takes
+#define VBB_MESH_CODEC_BLOCK_SIZE 16384
+#define VBB_MESH_CODEC_MAX_STRIDE 64
+
+// What's in a section
+enum VBBMeshSectionType {
+    VBB_MESH_SECTION_INDEXES = 1,
+    VBB_MESH_SECTION_POSITIONS = 2,
+    VBB_MESH_SECTION_NORMALS = 3,
+    VBB_MESH_SECTION_TEXCOORDS = 4
+};
+
+struct VBBMeshFileHeader {
+    uint32_t magic;         // VBB_MESH_FILE_MAGIC
+    uint32_t version;       // VBB_MESH_FILE_VERSION
+    uint32_t headerSize;    // sizeof(VBBMeshFileHeader), section table starts here
+    uint32_t sectionCount;  // Entries in the section table
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t flags;         // VBB_MESH_FILE_FLAG_*
+    uint32_t checksum;      // CRC32 of the whole file, with this zeroed
+    uint64_t fileSize;
+    float boundsMin[3];     // Axis aligned bounding box
+    float boundsMax[3];
+    float sphereCenter[3];  // Bounding sphere
+    float sphereRadius;
+    uint32_t reserved[2];
+};
+
+struct VBBMeshFileSection {
+    uint32_t type;    // VBBMeshSectionType
+    uint32_t format;  // VkFormat of each element, R16_UINT or R32_UINT for indexes
+    uint32_t stride;  // Bytes per element
+    uint32_t count;   // Number of elements
+    uint64_t offset;  // From the start of the file, always aligned
+    uint64_t size;    // In bytes
+};
+
+class VBBMeshFile {
+  public:
+    VBBMeshFile(void) {}
+    ~VBBMeshFile(void);
+
+    // Map a file for reading. Fails on anything that doesn't look right, including the checksum
+    // unless told not to check it.
+    bool open(const char* szFileName, bool bVerifyChecksum = true);
+    void close(void);
+    bool isOpen(void) { return m_pData != nullptr; }
+
+    const VBBMeshFileHeader* getHeader(void) { return m_pHeader; }
+    uint32_t getVertexCount(void) { return (m_pHeader != nullptr) ? m_pHeader->vertexCount : 0; }
+    uint32_t getIndexCount(void) { return (m_pHeader != nullptr) ? m_pHeader->indexCount : 0; }
+    VkIndexType getIndexType(void);
+    VkPrimitiveTopology getTopology(void) {
+        return (m_pHeader != nullptr && (m_pHeader->flags & VBB_MESH_FILE_FLAG_TRIANGLE_STRIP)) ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP
+                                                                                                : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    }
+
+    // Sections, pointer and size. Returns nullptr if the file doesn't have it.
+    const VBBMeshFileSection* findSection(VBBMeshSectionType type);
+    const void* getSectionData(VBBMeshSectionType type, uint64_t* pSize = nullptr, VkFormat* pFormat = nullptr);
+
+    // Sections as they are used, uncompressed. decodeSection() writes getDecodedSize() bytes, and works
+    // for compressed files or not. pDest can be a mapped staging buffer.
+    bool isCompressed(void) { return m_pHeader != nullptr && (m_pHeader->flags & VBB_MESH_FILE_FLAG_COMPRESSED); }
+    uint64_t getDecodedSize(VBBMeshSectionType type);
+    bool decodeSection(VBBMeshSectionType type, void* pDest);
+
+    // The whole file, as mapped
+    const void* getMappedData(void) { return m_pData; }
+    size_t getMappedSize(void) { return m_size; }
+
+    // Copy everything into a mesh
+    bool copyToMesh(VBBSimpleIndexedMesh& mesh);
+
+    // Write a mesh out, optionally compressed
+    static bool save(const char* szFileName, VBBSimpleIndexedMesh& mesh, bool bCompress = false);
+
+    static uint32_t crc32(const void* pData, size_t size, uint32_t crc = 0);
+
+    // The codec on its own. count elements of stride bytes each (1, 2, or 4 byte values). Encoding
+    // appends to encoded. Decoding fails on anything that doesn't come out to exactly count * stride bytes.
+    static void encodeStream(const void* pSource, uint32_t count, uint32_t stride, std::vector<unsigned char>& encoded);
+    static bool decodeStream(const void* pEncoded, size_t encodedSize, uint32_t count, uint32_t stride, void* pDest);
+
+  protected:
+    VBBMappedFile m_file;
+    const unsigned char* m_pData = nullptr;
+    size_t m_size = 0;
+    const VBBMeshFileHeader* m_pHeader = nullptr;
+    const VBBMeshFileSection* m_pSections = nullptr;
+};
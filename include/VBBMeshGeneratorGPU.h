@@ -0,0 +1,121 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Parametric surfaces made on the GPU.
+
+    VBBMeshGeneratorGPU is the compute shader version of VBBMakeTorusGrid(), VBBMakeSphereGrid(),
+    VBBMakeCylinderGrid() and VBBMakeDiskGrid() (VBBUtils.h). The make*() functions record one
+    dispatch that writes the vertices and indexes straight into device local buffers, so changing
+    the tessellation (zooming in on a planet) doesn't need a CPU rebuild and a staging upload.
+    The vertex grid and the index order are the same as the CPU generators, list or strips, and
+    the vertices match to within float precision (the CPU works in doubles).
+
+    Vertices are interleaved float positions, normals and texture coordinates, see getLayout().
+    Indexes are always 32-bit. The buffers are sized once by init(), shapes that don't fit fail.
+    make*() records a barrier so the results can be drawn later in the same command buffer, and
+    waits for earlier vertex reads, but it doesn't know about other frames in flight. Don't
+    regenerate a mesh that an earlier submission may still be drawing.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include "VBBUtils.h"
+#include "VBBDevice.h"
+#include "VBBBufferStatic.h"
+#include "VBBDescriptors.h"
+#include "VBBPipelineCompute.h"
+
+// GLSL source of the generator shader, compute, 8 x 8 vertices per workgroup
+extern const char* VBBMeshGeneratorShaderSrc;
+
+class VBBMeshGeneratorGPU {
+  public:
+    VBBMeshGeneratorGPU(VmaAllocator allocator) { m_VMA = allocator; }
+    ~VBBMeshGeneratorGPU(void);
+
+    // Make the buffers and the pipeline. The shader module must come from VBBMeshGeneratorShaderSrc.
+    // getGridSize() gives the counts a shape needs.
+    VkResult init(VBBDevice* pLogicalDevice, uint32_t maxVertices, uint32_t maxIndexes, VkShaderModule hGeneratorShader);
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+    VkResult init(VBBDevice* pLogicalDevice, uint32_t maxVertices, uint32_t maxIndexes);
+#endif
+
+    // Same parameters as the *Grid() generators. Returns false (and records nothing) if the shape
+    // doesn't fit in the buffers.
+    bool makeTorus(VkCommandBuffer cmdBuffer, float majorRadius, float minorRadius, uint32_t numMajor, uint32_t numMinor,
+                   bool bStrips = false);
+    bool makeSphere(VkCommandBuffer cmdBuffer, float radius, uint32_t iSlices, uint32_t iStacks, bool bStrips = false);
+    bool makeCylinder(VkCommandBuffer cmdBuffer, float baseRadius, float topRadius, float fLength, uint32_t numSlices,
+                      uint32_t numStacks, uint32_t degrees = 360, bool bStrips = false);
+    bool makeDisk(VkCommandBuffer cmdBuffer, float innerRadius, float outerRadius, uint32_t nSlices, uint32_t nStacks,
+                  uint32_t degrees = 360, bool bStrips = false);
+
+    // Vertices and indexes for a grid of columns x rows quads
+    static void getGridSize(uint32_t columns, uint32_t rows, bool bStrips, uint32_t& vertexCount, uint32_t& indexCount);
+
+    // What was made last. Set the pipeline up with getLayout(), getTopology() and getPrimitiveRestartEnable().
+    const VBBInterleavedLayout& getLayout(void) { return m_layout; }
+    uint32_t getVertexCount(void) { return m_vertexCount; }
+    uint32_t getIndexCount(void) { return m_indexCount; }
+    VkPrimitiveTopology getTopology(void) { return m_topology; }
+    VkBool32 getPrimitiveRestartEnable(void) { return (m_topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP) ? VK_TRUE : VK_FALSE; }
+
+    // Vertex buffer at the binding and the index buffer, then the draw
+    void bind(VkCommandBuffer cmdBuffer, uint32_t binding = 0);
+    void draw(VkCommandBuffer cmdBuffer, uint32_t instanceCount = 1);
+
+    VkBuffer getVertexBuffer(void) { return (m_pVertexBuffer != nullptr) ? m_pVertexBuffer->getBuffer() : VK_NULL_HANDLE; }
+    VkBuffer getIndexBuffer(void) { return (m_pIndexBuffer != nullptr) ? m_pIndexBuffer->getBuffer() : VK_NULL_HANDLE; }
+
+    // Copy the last mesh back into a VBBSimpleIndexedMesh, to check it against the CPU generators.
+    // Waits for the GPU, so this is for testing, not for every frame.
+    bool readback(VBBDevice* pLogicalDevice, VBBSimpleIndexedMesh& mesh);
+
+  protected:
+    VmaAllocator m_VMA = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_maxVertices = 0;
+    uint32_t m_maxIndexes = 0;
+
+    VBBInterleavedLayout m_layout;
+    uint32_t m_vertexCount = 0;
+    uint32_t m_indexCount = 0;
+    VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VBBBufferStatic* m_pVertexBuffer = nullptr;
+    VBBBufferStatic* m_pIndexBuffer = nullptr;
+
+    VBBDescriptors m_descriptors;
+    VkDescriptorSetLayout m_descriptorLayout = VK_NULL_HANDLE;
+    VkPushConstantRange m_pushConstant = {};
+    VBBPipelineCompute m_pipeline;
+
+    bool dispatch(VkCommandBuffer cmdBuffer, uint32_t shape, uint32_t columns, uint32_t rows, uint32_t flags, const float params[8]);
+};
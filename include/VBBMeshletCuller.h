@@ -0,0 +1,101 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    GPU culling for meshlets made with vbbBuildMeshlets() (VBBUtils.h).
+
+    VBBMeshletCuller runs a compute shader over the meshlets every frame and writes one
+    VkDrawIndexedIndirectCommand per meshlet, with an instance count of 0 for anything outside
+    the frustum or facing completely away from the camera. Those never get vertex shaded. Call
+    cull() outside of the render pass, then draw() inside it with the mesh's vertex and index
+    buffers bound.
+
+    Everything is in model space. The planes come from the model-view-projection matrix, and the
+    camera position has to be given in model space too.
+
+    If the device has pipelineStatisticsQuery, draw() counts vertex shader invocations. Drawing with
+    bCulled false draws every meshlet instead, into its own count, so getVertexInvocations() can show
+    what the culling saved. cull() resets both counts, so do the two draws between the same culls.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include <vector>
+#include "VBBUtils.h"
+#include "VBBDevice.h"
+#include "VBBBufferStatic.h"
+#include "VBBDescriptors.h"
+#include "VBBPipelineCompute.h"
+
+// GLSL source of the cull shader, compute, 64 meshlets per workgroup
+extern const char* VBBMeshletCullShaderSrc;
+
+class VBBMeshletCuller {
+  public:
+    VBBMeshletCuller(VmaAllocator allocator) { m_VMA = allocator; }
+    ~VBBMeshletCuller(void);
+
+    // Upload the meshlets and make the pipeline. The shader module must come from VBBMeshletCullShaderSrc.
+    VkResult init(VBBDevice* pLogicalDevice, const VBBMeshlet* pMeshlets, uint32_t meshletCount, VkShaderModule hCullShader);
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+    VkResult init(VBBDevice* pLogicalDevice, const VBBMeshlet* pMeshlets, uint32_t meshletCount);
+#endif
+
+    // Record the culling dispatch, with barriers on both sides of it (the last draw, and the next)
+    void cull(VkCommandBuffer cmdBuffer, const float mvp[16], const float cameraPosition[3]);
+
+    // One indirect draw for all of the meshlets. Bind the pipeline, vertex and index buffers first.
+    // Unculled draws everything, whatever cull() said.
+    void draw(VkCommandBuffer cmdBuffer, bool bCulled = true);
+
+    // Vertex shader invocations from the last draws, culled and not. False if there's no query pool,
+    // or either one isn't ready (or wasn't drawn).
+    bool getVertexInvocations(uint64_t& culled, uint64_t& unculled);
+    bool hasStatistics(void) { return m_queryPool != VK_NULL_HANDLE; }
+
+    VkBuffer getDrawBuffer(void) { return (m_pDrawBuffer != nullptr) ? m_pDrawBuffer->getBuffer() : VK_NULL_HANDLE; }
+    uint32_t getMeshletCount(void) { return m_meshletCount; }
+
+  protected:
+    VmaAllocator m_VMA = VK_NULL_HANDLE;
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_meshletCount = 0;
+    bool m_bMultiDrawIndirect = false;
+
+    VBBBufferStatic* m_pMeshletBuffer = nullptr;
+    VBBBufferStatic* m_pDrawBuffer = nullptr;     // VkDrawIndexedIndirectCommand for each meshlet
+    VBBBufferStatic* m_pUnculledBuffer = nullptr;  // Same, all visible
+
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;  // Culled, then unculled
+
+    VBBDescriptors m_descriptors;
+    VkDescriptorSetLayout m_descriptorLayout = VK_NULL_HANDLE;
+    VkPushConstantRange m_pushConstant = {};
+    VBBPipelineCompute m_pipeline;
+};
@@ -0,0 +1,95 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Mipmaps made on the GPU with a compute shader, for formats vkCmdBlitImage can't filter (no
+    VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, most 32-bit float formats for example).
+    VBBTexture uses one of these when it's given one, and blits when it can.
+
+    Each level is a 2x2 average of the one before. With an odd size the last row or column is
+    folded into the one before it (a 3 wide box there), and a size of 1 just stays 1.
+    The image needs sampled and storage usage, and the device has to be able to write storage
+    images without a format in the shader (shaderStorageImageWriteWithoutFormat). Integer formats
+    don't work. isFormatSupported() checks the rest.
+
+    One of these can be shared by any number of textures. record() makes image views and a
+    descriptor pool for the image it's working on. They're kept until release(), call that once
+    the command buffer has finished.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include <vector>
+#include "VBBDevice.h"
+#include "VBBDescriptors.h"
+#include "VBBPipelineCompute.h"
+
+// GLSL source of the downsample shader, compute, 8 x 8 texels per workgroup
+extern const char* VBBMipDownsampleShaderSrc;
+
+class VBBMipDownsampler {
+  public:
+    VBBMipDownsampler(void) {}
+    ~VBBMipDownsampler(void);
+
+    // Make the pipeline. The shader module must come from VBBMipDownsampleShaderSrc.
+    VkResult init(VBBDevice* pLogicalDevice, VkShaderModule hDownsampleShader);
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+    VkResult init(VBBDevice* pLogicalDevice);
+#endif
+
+    bool isFormatSupported(VkFormat format, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL);
+
+    // Record levels 1 to levels - 1, each from the one before. Every level has to be in
+    // TRANSFER_DST_OPTIMAL with level 0 just copied in, they all end up in finalLayout, ready
+    // for the fragment or compute shaders.
+    VkResult record(VkCommandBuffer cmdBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t levels,
+                    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // Image views and descriptor pools from every record() so far. Only once they've been executed.
+    void release(void);
+
+  protected:
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    bool m_bWriteWithoutFormat = false;
+
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VBBDescriptors m_descriptors;  // Only the layout is used, each record() needs a set per level
+    VkDescriptorSetLayout m_descriptorLayout = VK_NULL_HANDLE;
+    VkPushConstantRange m_pushConstant = {};
+    VBBPipelineCompute m_pipeline;
+
+    std::vector<VkImageView> m_views;
+    std::vector<VkDescriptorPool> m_pools;
+
+    void barrier(VkCommandBuffer cmdBuffer, VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout,
+                 VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage,
+                 VkPipelineStageFlags dstStage);
+};
@@ -37,6 +37,7 @@
 
 #include "VBBShaderModule.h"
 #include "VBBCanvas.h"
+#include "VBBUtils.h"
 
 class VBBPipelineGraphics {
   public:
@@ -55,6 +56,7 @@ class VBBPipelineGraphics {
      */
 
     void setPrimitiveTopology(VkPrimitiveTopology topo) { m_primitiveTopology = topo; }
+    void setPrimitiveRestartEnable(VkBool32 flag) { m_primitiveRestartFlag = flag; }
     void setFrontFace(VkFrontFace face) { m_frontFace = face; }
     void setCullMode(VkCullModeFlags mode) { m_cullMode = mode; }
     void setPolygonMode(VkPolygonMode mode) { m_polygonMode = mode; }
@@ -95,6 +97,14 @@ class VBBPipelineGraphics {
 
     void addVertexAttributeBinding(uint32_t stride, uint32_t offset, VkVertexInputRate inputRate, uint32_t location, VkFormat format);
 
+    // Several attributes can share one binding (interleaved vertices). Add the binding, then the attributes in it.
+    uint32_t addVertexBinding(uint32_t stride, VkVertexInputRate inputRate);
+    void addVertexAttribute(uint32_t binding, uint32_t location, VkFormat format, uint32_t offset);
+
+    // One binding for an interleaved mesh layout. Locations default to 0, 1, 2... in layout order.
+    uint32_t addInterleavedVertexBinding(const VBBInterleavedLayout& layout, const uint32_t* pLocations = nullptr,
+                                         VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX);
+
   protected:
     VkResult m_lastResult;
 
@@ -130,6 +140,7 @@ class VBBPipelineGraphics {
     // ********************************************************************************
     // Pipeline options, all of these must be set before pipeline creation
     VkPrimitiveTopology m_primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkBool32 m_primitiveRestartFlag = VK_FALSE;
     VkFrontFace m_frontFace = VK_FRONT_FACE_CLOCKWISE;
     VkCullModeFlags m_cullMode = VK_CULL_MODE_BACK_BIT;
     VkPolygonMode m_polygonMode = VK_POLYGON_MODE_FILL;
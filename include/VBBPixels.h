@@ -0,0 +1,70 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Pixel conversions for texture uploads. Everything is 8 bits per channel and works on whole
+    pixels, so mip chains (one level after another) convert in one call. SSE2 or NEON does 4 to
+    16 pixels at a time when the compiler has it, like VBBMath.
+
+    pDest is only ever written, never read, so it can be mapped (write combined) staging memory.
+    The 32-bit to 32-bit conversions can be done in place.
+
+    Mip chains come out in the layout VBBTexture::loadRawTexture() takes: level 0, then each
+    level after it, half the size (but never less than 1), no padding.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum VBBPixelConversion {
+    VBB_PIXELS_COPY = 0,      // Nothing to do
+    VBB_PIXELS_SWAP_RB,       // BGRA <-> RGBA
+    VBB_PIXELS_RGB_TO_RGBA,   // Alpha is 255
+    VBB_PIXELS_BGR_TO_RGBA,   // And BGR to BGRA, it's the same thing
+    VBB_PIXELS_GREY_TO_RGBA   // Grey in each color channel, alpha 255
+};
+
+// Bytes per pixel going in and coming out
+uint32_t vbbGetPixelConversionSizes(VBBPixelConversion conversion, uint32_t* pDestSize = nullptr);
+
+// Convert pixelCount pixels. bPremultiply also multiplies the color by alpha on the way through
+// (the output needs to have four channels).
+void vbbConvertPixels(VBBPixelConversion conversion, const void* pSource, void* pDest, size_t pixelCount, bool bPremultiply = false);
+
+// The individual conversions
+void vbbSwapRB32(const void* pSource, void* pDest, size_t pixelCount);
+void vbbExpandRGB24(const void* pSource, void* pDest, size_t pixelCount, bool bSwapRB);
+void vbbExpandGrey8(const void* pSource, void* pDest, size_t pixelCount);
+void vbbPremultiplyAlpha(const void* pSource, void* pDest, size_t pixelCount);  // Alpha is the fourth byte
+
+// Mip chains, 8 bits per channel, 1 to 4 channels. Box is a 2x2 average, Kaiser is sharper and costs
+// more. bSRGB filters the color in linear light, alpha (the fourth channel) is always linear. Rows are
+// split across nThreads threads (0 = all of them). Level 0 is copied to pDest too.
+enum VBBMipFilter { VBB_MIP_FILTER_BOX = 0, VBB_MIP_FILTER_KAISER };
+
+uint32_t vbbGetMipLevelCount(uint32_t width, uint32_t height);  // All the way down to 1x1
+size_t vbbGetMipChainSize(uint32_t width, uint32_t height, uint32_t levels, uint32_t bytesPerPixel);
+bool vbbGenerateMipChain(const void* pSource, void* pDest, uint32_t width, uint32_t height, uint32_t channels, uint32_t levels,
+                         VBBMipFilter filter = VBB_MIP_FILTER_BOX, bool bSRGB = false, uint32_t nThreads = 0);
@@ -36,6 +36,10 @@ class VBBSingleShotCommand {
         m_graphicsQueue = gQueue;
     }
 
+    // Anything submitted and never waited on (or that timed out) is waited on here, so the fence
+    // and command buffer aren't leaked
+    ~VBBSingleShotCommand() { wait(); }
+
     VkCommandBuffer start(void) {
         VkCommandBufferAllocateInfo allocInfo = {};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -53,23 +57,56 @@ class VBBSingleShotCommand {
         return m_commandBuffer;
     }
 
+    // Submit and wait for it to finish. Only waits on this submission, not the whole queue.
     void end(void) {
+        if (submit() == VK_SUCCESS) wait();
+    }
+
+    // Or submit now and wait() later. A timeout of 0 just checks, VK_TIMEOUT means it's still running.
+    // If the submit fails the command buffer is freed, there's nothing to wait for.
+    VkResult submit(void) {
         vkEndCommandBuffer(m_commandBuffer);
 
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkResult result = vkCreateFence(m_logicalDevice, &fenceInfo, nullptr, &m_fence);
+        if (result != VK_SUCCESS) {
+            m_fence = VK_NULL_HANDLE;
+            vkFreeCommandBuffers(m_logicalDevice, m_commandPool, 1, &m_commandBuffer);
+            return result;
+        }
+
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &m_commandBuffer;
 
-        vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(m_graphicsQueue);
+        result = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_fence);
+        if (result != VK_SUCCESS) {
+            vkDestroyFence(m_logicalDevice, m_fence, nullptr);
+            vkFreeCommandBuffers(m_logicalDevice, m_commandPool, 1, &m_commandBuffer);
+            m_fence = VK_NULL_HANDLE;
+        }
+        return result;
+    }
+
+    VkResult wait(uint64_t timeout = UINT64_MAX) {
+        if (m_fence == VK_NULL_HANDLE) return VK_SUCCESS;
+
+        VkResult result = vkWaitForFences(m_logicalDevice, 1, &m_fence, VK_TRUE, timeout);
+        if (result == VK_TIMEOUT) return result;
+
+        vkDestroyFence(m_logicalDevice, m_fence, nullptr);
         vkFreeCommandBuffers(m_logicalDevice, m_commandPool, 1, &m_commandBuffer);
+        m_fence = VK_NULL_HANDLE;
+        return result;
     }
 
     VkCommandBuffer getCommandBuffer(void) { return m_commandBuffer; }
 
   protected:
-    VkCommandBuffer m_commandBuffer;
+    VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+    VkFence m_fence = VK_NULL_HANDLE;
 
     VkDevice m_logicalDevice;
     VkCommandPool m_commandPool;
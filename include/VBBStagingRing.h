@@ -0,0 +1,154 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Staging memory for uploads, shared by everything that uploads. It's one persistently mapped
+    buffer used as a ring: allocate() takes space off the head, and free() hands it back along with
+    the fence of the submission that reads it. Space comes back to the tail once its fence has
+    signaled (or straight away, if there's no fence because the GPU is already done with it), and
+    allocation wraps round to the start when it runs off the end.
+
+    When the ring is full allocate() waits on the oldest fence (that's a stall). A request bigger
+    than the ring, or one that can't wait because what's in the way hasn't been freed yet, gets a
+    buffer of its own, which is deleted when its fence signals.
+
+    Set it on the device (VBBDevice::setStagingRing()) and VBBTexture, VBBBufferStatic,
+    VBBTextureUploadBatch and VBBUploadService all stage through it. Without one they make a
+    buffer for each upload, like they used to (the upload service makes a ring of its own). It's
+    thread safe.
+
+    Fences passed to free() must have been submitted already, and are still the caller's. Don't
+    destroy one until it has signaled and retire() has been called, so the ring has let go of it.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#define VMA_STATIC_VULKAN_FUNCTIONS 0
+#define VMA_DYNAMIC_VULKAN_FUNCTIONS 1
+#include "vma/vk_mem_alloc.h"
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <mutex>
+
+#include "VBBDevice.h"
+#include "VBBBufferDynamic.h"
+
+#define VBB_STAGING_RING_SIZE (64 * 1024 * 1024)  // Default size
+#define VBB_STAGING_ALIGNMENT 16                   // Of every allocation, at least
+#define VBB_STAGING_WAIT_SLICE 100000             // Nanoseconds allocate() waits on a fence with the lock held
+
+class VBBStagingRing;
+
+// A piece of staging memory. pData is mapped and write combined, don't read it.
+struct VBBStagingAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    unsigned char* pData = nullptr;
+
+    VBBStagingRing* pRing = nullptr;     // Where it came from, nullptr if it's on its own
+    VBBBufferDynamic* pBuffer = nullptr;  // Set if it has its own buffer
+    uint64_t id = 0;
+};
+
+struct VBBStagingStats {
+    uint64_t bytesStaged;   // Everything allocate() has handed out
+    uint64_t allocations;
+    uint64_t stalls;        // Times allocate() had to wait for the GPU
+    uint64_t wraparounds;   // Times the head went back to the start
+    uint64_t dedicated;     // Allocations that got a buffer of their own
+};
+
+class VBBStagingRing {
+  public:
+    VBBStagingRing(void) {}
+    ~VBBStagingRing(void) { shutdown(); }
+
+    VkResult init(VBBDevice* pLogicalDevice, VmaAllocator allocator, VkDeviceSize size = VBB_STAGING_RING_SIZE);
+
+    // Waits for anything that's been freed with a fence. Everything should have been freed by now.
+    void shutdown(void);
+
+    // size bytes of staging. If the ring's full this waits for the GPU, or makes a buffer just for it.
+    // With bWait false it does neither and fails instead.
+    bool allocate(VkDeviceSize size, VBBStagingAllocation& allocation, VkDeviceSize alignment = VBB_STAGING_ALIGNMENT,
+                  bool bWait = true);
+
+    // Give it back, see above. fence is VK_NULL_HANDLE if the GPU has already finished with it.
+    void free(VBBStagingAllocation& allocation, VkFence fence = VK_NULL_HANDLE);
+
+    // Take back everything the GPU has finished with. allocate() does this itself.
+    void retire(void);
+
+    VkDeviceSize getSize(void) { return m_size; }
+    void getStats(VBBStagingStats& stats);
+    void resetStats(void);
+
+    // Image copies need offsets that are a multiple of the texel size (which can be 12)
+    static VkDeviceSize getAlignment(uint32_t texelSize);
+
+  protected:
+    // A piece of the ring, or a buffer of its own. Done once it's been freed and its fence has signaled.
+    struct Region {
+        uint64_t id;
+        VkDeviceSize start;
+        VkDeviceSize end;
+        VkFence fence;
+        bool bFreed;
+        bool bDone;
+        VBBBufferDynamic* pBuffer;
+    };
+
+    bool place(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    bool allocateDedicated(VkDeviceSize size, VBBStagingAllocation& allocation);
+    void checkFence(Region& region);
+    void retireLocked(void);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VmaAllocator m_VMA = VK_NULL_HANDLE;
+    VBBBufferDynamic* m_pBuffer = nullptr;
+    unsigned char* m_pData = nullptr;
+    VkDeviceSize m_size = 0;
+
+    // All under m_mutex. The tail is the start of the oldest region, head is where the next one goes.
+    std::mutex m_mutex;
+    std::deque<Region> m_regions;
+    std::vector<Region> m_dedicated;
+    VkDeviceSize m_head = 0;
+    uint64_t m_nextID = 1;
+    VBBStagingStats m_stats = {};
+};
+
+// For code that might not have a ring. Without one the allocation gets a buffer of its own, and
+// vbbFreeStaging() deletes it right away, so only free it once the GPU is done with it.
+bool vbbAllocateStaging(VBBStagingRing* pRing, VmaAllocator allocator, VkDeviceSize size, VBBStagingAllocation& allocation,
+                        VkDeviceSize alignment = VBB_STAGING_ALIGNMENT);
+void vbbFreeStaging(VBBStagingAllocation& allocation, VkFence fence = VK_NULL_HANDLE);
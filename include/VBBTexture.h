@@ -34,6 +34,11 @@
 
 #include "VBBDevice.h"
 #include "VBBBufferDynamic.h"
+#include "VBBStagingRing.h"
+#include "VBBPixels.h"
+#include "VBBMipDownsampler.h"
+#include "VBBTextureUploadBatch.h"
+#include "VBBUploadService.h"
 
 #include <stdio.h>
 #include <iostream>
@@ -54,15 +59,46 @@ class VBBTexture {
 
     uint32_t getWidth() { return textureWidth; }
     uint32_t getHeight() { return textureHeight; }
+    uint32_t getDepth() { return textureDepth; }
+    uint32_t getLayerCount() { return arrayLayers; }
+    VkImageViewType getViewType(void) { return imageViewType; }
 
-    // Create a texture from raw data
+    // Create a texture from raw data. format says what the data is. If the device can't sample that
+    // it's converted on the way into the staging buffer (see chooseUploadFormat()), and getFormat()
+    // says what the image ended up as.
     bool loadRawTexture(const void* pImageData, VkFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t totalBytes,
                         int mipLevels = 1);
 
-    // Create a texture from an existing buffer
+    // Create a texture from an existing buffer. This one is uploaded as is. If it's going in a batch
+    // the buffer has to stay around until the batch has finished.
     bool loadRawTexture(VBBBufferDynamic& imageBuffer, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
                         uint32_t totalBytes, int mipLevels = 1);
 
+    // Load a targa. The file is mapped and decoded straight into the staging buffer, which goes to
+    // the loader above, so the pixels are only ever copied once on the CPU. Unless they need
+    // converting or mipmapping, then they go through the first loader.
+    bool loadTGATexture(const char* szFileName);
+
+    // Or in the background. Returns as soon as the image is made, the pixels follow on the uploader's
+    // worker thread. Don't use the texture (or delete it) until the ticket is complete. 0 if it
+    // couldn't get that far. GPU mips don't happen here, CPU ones do.
+    VBBUploadTicket loadTGATexture(const char* szFileName, VBBUploadService& uploader);
+
+    // Arrays, cube maps and volumes. viewType is VK_IMAGE_VIEW_TYPE_2D_ARRAY, _CUBE (6 layers, +X -X +Y -Y
+    // +Z -Z), _CUBE_ARRAY (6 per cube), or _3D, where layers is the depth. Array layers are packed one after
+    // another, each with its mips like loadRawTexture() takes them. A volume is packed a level at a time, with
+    // all of that level's slices. Every layer goes up in the one copy.
+    bool loadRawTextureLayers(const void* pImageData, VkFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t layers,
+                              uint32_t totalBytes, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY, int mipLevels = 1);
+
+    // A targa for each layer (or face, or slice). They all have to be the same size and format.
+    bool loadTGATextureLayers(const char* const* szFileNames, uint32_t count, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+
+    // What data in sourceFormat gets uploaded as. The format itself if the device can sample it,
+    // otherwise the nearest four channel format it can. VK_FORMAT_UNDEFINED if there isn't one.
+    VkFormat chooseUploadFormat(VkFormat sourceFormat, VBBPixelConversion& conversion);
+    bool isFormatSupported(VkFormat format, VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
     // ******************************************************************
     // Defaults, override before loading texture
     VkFilter minFilter = VK_FILTER_LINEAR;
@@ -70,13 +106,31 @@ class VBBTexture {
     VkImageTiling imageTiling = VK_IMAGE_TILING_OPTIMAL;
     VkBool32        m_useAnistotropy = VK_FALSE;
     float           m_maxAnisotropy = 1.0;
+    bool            m_premultiplyAlpha = false;    // Only for formats with alpha, when they're copied to staging
+    bool            m_generateMips = false;        // Build the whole chain on the CPU when given one level
+    VBBMipFilter    m_mipFilter = VBB_MIP_FILTER_BOX;
+    bool            m_generateMipsOnGPU = false;   // Or on the GPU, blitting if the format can be filtered
+    VBBMipDownsampler* m_pMipDownsampler = nullptr;  // And with this if it can't. Not owned, can be shared.
+    VBBTextureUploadBatch* m_pUploadBatch = nullptr;   // Record into this instead of submitting, see VBBTextureUploadBatch.h
 
   protected:
     void createTextureImageView(void);
-    void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
-
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize offset = 0,
-                           int nMipLevel = 0);
+    void transitionImageLayout(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+                               uint32_t baseLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS);
+
+    void copyBufferToImage(VkCommandBuffer cmdBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width,
+                           uint32_t height, uint32_t levels = 1);
+
+    bool createImage(VkFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t totalBytes, int mipLevels,
+                     VkImageUsageFlags extraUsage, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t layers = 1);
+    bool uploadImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
+                     uint32_t totalBytes, int copiedLevels, int mipLevels, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D,
+                     uint32_t layers = 1);
+    bool canBlitMips(VkFormat format);
+    uint32_t getGPUMipLevels(VkFormat format, uint32_t width, uint32_t height);
+    void recordBlitMips(VkCommandBuffer cmdBuffer);
+    bool allocateStaging(VkDeviceSize size, VkFormat format, VBBStagingAllocation& staging);
+    void doneWithStaging(VBBStagingAllocation& staging);
 
     void createSampler(void);
 
@@ -84,11 +138,15 @@ class VBBTexture {
     uint32_t textureHeight;
     uint32_t textureChannels;
     uint32_t mipMapLevels;
+    uint32_t textureDepth = 1;    // Slices of a volume
+    uint32_t arrayLayers = 1;     // Or layers of anything else
+    VkImageViewType imageViewType = VK_IMAGE_VIEW_TYPE_2D;
 
     VkDeviceSize imageSize;
 
     VmaAllocator  m_VMA = VK_NULL_HANDLE;
     VmaAllocation m_allocation;
+    VBBDevice*    m_pDevice = nullptr;
 
     VkImage textureImage = VK_NULL_HANDLE;
     VkImageView textureImageView = VK_NULL_HANDLE;
@@ -0,0 +1,92 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Upload a pile of textures with one submission. Without one of these each texture records its
+    own command buffer, submits it and waits on a fence before the load returns. With one, set
+    VBBTexture::m_pUploadBatch on each texture before loading it, and the copies, transitions and
+    mip generation all go into the batch's command buffer instead. Then submit() once.
+
+        VBBTextureUploadBatch batch(pDevice);
+        batch.begin();
+        for (...) {
+            pTexture->m_pUploadBatch = &batch;
+            pTexture->loadTGATexture(szFile);
+        }
+        batch.submit();     // And waits, unless told not to
+
+    The textures can't be used until the batch has finished. Staging the textures allocate for
+    themselves (from the device's staging ring, if it has one) is kept here and freed by wait(). A
+    buffer passed to VBBTexture::loadRawTexture() is the caller's, and has to stay around until then too.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#include <vector>
+#include "VBBDevice.h"
+#include "VBBSingleShotCommand.h"
+#include "VBBStagingRing.h"
+#include "VBBMipDownsampler.h"
+
+class VBBTextureUploadBatch {
+  public:
+    VBBTextureUploadBatch(VBBDevice* pLogicalDevice);
+    ~VBBTextureUploadBatch(void);  // Waits for it, if it's still going
+
+    // Start recording. Anything still in flight from last time is waited on first.
+    VkCommandBuffer begin(void);
+    VkCommandBuffer getCommandBuffer(void) { return m_bRecording ? m_command.getCommandBuffer() : VK_NULL_HANDLE; }
+    bool isRecording(void) { return m_bRecording; }
+
+    // One vkQueueSubmit for everything recorded since begin()
+    VkResult submit(bool bWait = true);
+
+    // Wait for the batch, then free the staging. A timeout of 0 just checks, VK_TIMEOUT means
+    // it's still running.
+    VkResult wait(uint64_t timeout = UINT64_MAX);
+
+    // VBBTexture hands these over while it's recording. Staging is freed, downsamplers are
+    // released, once the batch has finished.
+    void keepStaging(const VBBStagingAllocation& staging) { m_staging.push_back(staging); }
+    void releaseAfter(VBBMipDownsampler* pDownsampler);
+    void addTexture(void) { m_textureCount++; }
+
+    uint32_t getTextureCount(void) { return m_textureCount; }
+
+  protected:
+    void cleanup(void);
+
+    VBBSingleShotCommand m_command;
+    bool m_bRecording = false;
+    bool m_bSubmitted = false;
+    uint32_t m_textureCount = 0;
+
+    std::vector<VBBStagingAllocation> m_staging;
+    std::vector<VBBMipDownsampler*> m_downsamplers;
+};
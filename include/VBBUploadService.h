@@ -0,0 +1,185 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+/*
+    Uploads in the background. Requests are queued from any thread and a worker thread does the rest:
+    it fills staging memory (the fill callback runs on the worker, so file decoding and pixel
+    conversion happen there too), records the copies, and submits them to the device's transfer
+    queue. Each request gets a ticket that says when it's done. Nothing here waits on the graphics
+    queue, so the render loop carries on while things stream in.
+
+    If the transfer queue is in a different family than the graphics queue the resources have to
+    change hands when they arrive. The worker records the release, and update() records the acquire
+    into a graphics command buffer. So call update() once a frame, from the thread that submits to
+    the graphics queue, with a command buffer that's recording. A ticket is complete once update()
+    has picked it up, and the resource can be used from there on in that command buffer. When the
+    device only has the one queue the worker records the copies, and update() submits them too.
+    (Either way, don't wait() on the thread that calls update().)
+
+    Staging comes from the device's staging ring (VBBStagingRing.h), or one of the service's own if the
+    device doesn't have one. Space comes back as each submission's fence signals. When the ring fills
+    up the worker submits what it has and waits for the oldest submission to finish.
+
+    Resources being uploaded to need to be created with VK_SHARING_MODE_EXCLUSIVE (the default in
+    VBB) and must not be used until their ticket is complete.
+*/
+
+#pragma once
+
+#ifdef VK_NO_PROTOTYPES
+#include <volk/volk.h>
+#else
+#include <vulkan/vulkan.h>
+#endif
+
+#define VMA_STATIC_VULKAN_FUNCTIONS 0
+#define VMA_DYNAMIC_VULKAN_FUNCTIONS 1
+#include "vma/vk_mem_alloc.h"
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <set>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "VBBDevice.h"
+#include "VBBStagingRing.h"
+
+// 0 is never a ticket, it's what comes back when a request can't be queued
+typedef uint64_t VBBUploadTicket;
+
+// Write size bytes of data to pStaging (which is write combined memory, don't read it). Runs on the worker
+// thread. Return false if it couldn't, the ticket completes but reports failure.
+typedef std::function<bool(void* pStaging)> VBBUploadFill;
+
+class VBBUploadService {
+  public:
+    VBBUploadService(void) {}
+    ~VBBUploadService(void) { shutdown(); }
+
+    // stagingSize is for the service's own ring, if the device doesn't have one to share
+    VkResult init(VBBDevice* pLogicalDevice, VmaAllocator allocator, VkDeviceSize stagingSize = VBB_STAGING_RING_SIZE);
+
+    // Finish everything queued and stop the worker. Anything update() hasn't acquired yet is dropped.
+    void shutdown(void);
+
+    // Queue up some work. The destination buffer needs TRANSFER_DST usage.
+    VBBUploadTicket uploadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VBBUploadFill fill);
+    VBBUploadTicket uploadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void* pData);  // pData has to stay around
+
+    // Levels packed one after another, like VBBTexture::loadRawTexture() takes them. The image can be
+    // in any layout, the old contents are thrown away. It ends up in finalLayout.
+    VBBUploadTicket uploadImage(VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t levels, VkDeviceSize size,
+                                VBBUploadFill fill, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // Once a frame on the render thread, see above. cmdBuffer can be VK_NULL_HANDLE if there isn't one
+    // this time, nothing is acquired then.
+    void update(VkCommandBuffer cmdBuffer);
+
+    bool isComplete(VBBUploadTicket ticket);
+    bool hasFailed(VBBUploadTicket ticket);
+
+    // Block until it's complete, false if it failed
+    bool wait(VBBUploadTicket ticket);
+
+    bool isRunning(void) { return m_worker.joinable(); }
+    bool needsOwnershipTransfer(void) { return m_transferFamily != m_graphicsFamily; }
+
+  protected:
+    struct Request {
+        VBBUploadTicket ticket;
+        VkBuffer buffer;
+        VkImage image;
+        VkFormat format;
+        VkDeviceSize offset;  // Into the buffer
+        VkDeviceSize size;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        VkImageLayout finalLayout;
+        VBBUploadFill fill;
+    };
+
+    // Waiting for update() to acquire it
+    struct Acquire {
+        VBBUploadTicket ticket;
+        VkBuffer buffer;
+        VkImage image;
+        VkImageLayout finalLayout;
+    };
+
+    // One command buffer's worth, and what it's holding on to
+    struct Submission {
+        VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        bool bSubmitted = false;  // Under m_mutex, update() submits it when the queue is shared
+        bool bSubmitFailed = false;
+        std::vector<Acquire> uploads;
+        std::vector<VBBUploadTicket> failed;
+        std::vector<VBBStagingAllocation> staging;  // Freed with the fence once it's submitted
+    };
+
+    VBBUploadTicket queueRequest(Request& request);
+    void workerThread(void);
+    void processRequests(std::deque<Request>& requests);
+    bool beginSubmission(Submission& submission);
+    void recordRequest(Submission& submission, Request& request, VkBuffer staging, VkDeviceSize stagingOffset, bool bFilled);
+    void submit(Submission& submission);
+    void retire(uint64_t timeout);
+    void finishSubmission(Submission& submission, bool bFailed);
+    void freeStaging(Submission& submission, VkFence fence);
+
+    void completeTickets(const std::vector<Acquire>& uploads);
+    static void getAccess(const Acquire& upload, VkAccessFlags& access);
+
+    VBBDevice* m_pDevice = nullptr;
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
+    uint32_t m_transferFamily = 0;
+    uint32_t m_graphicsFamily = 0;
+    bool m_bSharedQueue = false;
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;  // Only the worker touches it
+
+    VBBStagingRing* m_pRing = nullptr;
+    VBBStagingRing* m_pOwnRing = nullptr;  // If the device didn't have one
+    std::deque<Submission> m_inFlight;     // Only the worker touches it
+
+    // Everything below is shared, under m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWorker;
+    std::condition_variable m_ticketDone;
+    std::thread m_worker;
+    std::atomic<bool> m_bWorkerDone{false};
+    bool m_bStop = false;
+
+    std::deque<Request> m_requests;
+    std::vector<Submission*> m_toSubmit;  // Shared queue, update() submits these
+    std::vector<Acquire> m_acquires;
+    VBBUploadTicket m_nextTicket = 1;
+    VBBUploadTicket m_completedTicket = 0;  // Everything up to here is done
+    std::set<VBBUploadTicket> m_failed;
+};
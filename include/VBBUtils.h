@@ -35,8 +35,11 @@
 
 
 #include <vector>
+#include <unordered_map>
+#include <functional>
 #include <stdint.h>
 #include <math.h>
+#include <float.h>
 #include <stdio.h>
 
 // Define targa header. This is only used locally.
@@ -57,7 +60,53 @@ typedef struct {
 } TGAHEADER;
 #pragma pack()
 
+// Attributes a mesh can hold, used to describe an interleaved vertex
+enum VBBMeshAttribute { VBB_MESH_ATTRIBUTE_POSITION = 0, VBB_MESH_ATTRIBUTE_NORMAL, VBB_MESH_ATTRIBUTE_TEXCOORD, VBB_MESH_ATTRIBUTE_COUNT };
+
+// How an attribute is stored in an interleaved vertex. Everything but FLOAT is quantized.
+enum VBBMeshEncoding {
+    VBB_MESH_ENCODING_FLOAT = 0,   // 32-bit floats, any attribute
+    VBB_MESH_ENCODING_HALF,        // 16-bit floats, positions (w = 1) and texcoords
+    VBB_MESH_ENCODING_SNORM16,     // Positions only, -1 to 1 across the mesh bounds (w = 1)
+    VBB_MESH_ENCODING_OCTAHEDRAL,  // Normals only, octahedral mapped into two 16-bit snorms
+    VBB_MESH_ENCODING_UNORM16      // Texcoords only, clamped to 0 - 1
+};
+
+// Where each attribute lives in one interleaved vertex. Fill this in with
+// VBBSimpleIndexedMesh::makeInterleavedLayout().
+struct VBBInterleavedLayout {
+    uint32_t attributeCount = 0;
+    VBBMeshAttribute attributes[VBB_MESH_ATTRIBUTE_COUNT];
+    VBBMeshEncoding encodings[VBB_MESH_ATTRIBUTE_COUNT];
+    VkFormat formats[VBB_MESH_ATTRIBUTE_COUNT];
+    uint32_t offsets[VBB_MESH_ATTRIBUTE_COUNT];
+    uint32_t stride = 0;
+
+    // SNORM16 positions are stored as (position - offset) / scale. See vbbGetDequantizeMatrix().
+    float positionScale[3] = {1.0f, 1.0f, 1.0f};
+    float positionOffset[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// Strip meshes separate the strips with this index. It comes out as 0xFFFF in 16-bit index data.
+#define VBB_PRIMITIVE_RESTART_INDEX 0xFFFFFFFF
+
+// Bounding volumes
+struct VBBBoundingBox {
+    float min[3];
+    float max[3];
+};
+
+struct VBBBoundingSphere {
+    float center[3];
+    float radius;
+};
+
+class VBBMeshFile;
+
 class VBBSimpleIndexedMesh {
+    // Mesh files store the bounds, no need to work them out again
+    friend class VBBMeshFile;
+
   public:
     struct VBBSimpleVertex {
         float x;
@@ -79,76 +128,131 @@ class VBBSimpleIndexedMesh {
     void startBuilding(uint32_t estimatedVertexCount, float epsilon = 0.0000001);
     void addVertex(VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord, uint32_t searchOnlyLast = 0);
     void addVertex(void* pVertex, void* pNormal, void* pTexCoord, uint32_t searchOnlyLast = 0);
+    void endBuilding(void);
+
+    // Skip welding entirely and fill in the arrays yourself through the get*Pointer() functions.
+    // Anything already in the mesh is thrown away.
+    void allocateMesh(uint32_t vertexCount, uint32_t indexCount, bool bNormals = true, bool bTexCoords = true);
+
+    // Meshes are triangle lists unless a generator was asked for strips. Strip meshes have
+    // VBB_PRIMITIVE_RESTART_INDEX between the strips, so set the pipeline up with
+    // setPrimitiveTopology(getTopology()) and setPrimitiveRestartEnable(getPrimitiveRestartEnable()).
+    // Welding, optimizeVertexCache(), meshlets and simplification only work on lists.
+    void setTopology(VkPrimitiveTopology topology) { m_topology = topology; }
+    VkPrimitiveTopology getTopology(void) { return m_topology; }
+    VkBool32 getPrimitiveRestartEnable(void) { return (m_topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP) ? VK_TRUE : VK_FALSE; }
+    uint32_t getTriangleCount(void);
+
+    // Welding uses a spatial hash by default. Turn it off to get the old linear search (mostly for benchmarking).
+    void setUseSpatialHash(bool bUseHash) { m_useSpatialHash = bUseHash; }
+    bool getUseSpatialHash(void) { return m_useSpatialHash; }
+
+    // Reorder for the GPU. optimizeVertexCache() sorts triangles for post-transform cache hits (Forsyth),
+    // optimizeVertexFetch() renumbers vertices in the order they are first used. optimize() does both.
+    // Set optimize on build to have endBuilding() do this for you.
+    void optimizeVertexCache(uint32_t cacheSize = 32);
+    void optimizeVertexFetch(void);
+    void optimize(uint32_t cacheSize = 32) {
+        optimizeVertexCache(cacheSize);
+        optimizeVertexFetch();
+    }
+    void setOptimizeOnBuild(bool bOptimize) { m_optimizeOnBuild = bOptimize; }
 
-    VBBSimpleVertex* getVertexPointer(void) { return m_vertices.data(); }
+    // Simulated FIFO post-transform cache. Average cache miss ratio (misses per triangle, 0.5 is ideal)
+    // and average transform to vertex ratio (misses per vertex, 1.0 is ideal).
+    float getACMR(uint32_t cacheSize = 32);
+    float getATVR(uint32_t cacheSize = 32);
+
+    // Anything could be done to the vertices through this, so the bounds are worked out again next time they are asked for
+    VBBSimpleVertex* getVertexPointer(void) {
+        m_boundsValid = false;
+        return m_vertices.data();
+    }
     VBBSimpleNormal* getNormalPointer(void) { return m_normals.data(); }
     VBBSimpleTexCoord* getTexCoordPointer(void) { return m_texCoords.data(); }
     uint32_t* getIndexPointer(void) { return m_indexes.data(); }
     uint32_t getIndexCount(void) { return static_cast<uint32_t>(m_indexes.size()); }
     uint32_t getAttributeCount(void) { return static_cast<uint32_t>(m_vertices.size()); }
+    bool hasNormals(void) { return !m_normals.empty(); }
+    bool hasTexCoords(void) { return !m_texCoords.empty(); }
 
-    bool saveMesh(const char* szMeshFile) {
-        if(szMeshFile != nullptr) {
-            FILE *pFile;
-            pFile = fopen(szMeshFile, "wb");
-            if(pFile == NULL)
-                return false; // Fail gracefully
-
-            uint32_t nIndexCount = (uint32_t)m_indexes.size();
-            uint32_t nVertexCount = (uint32_t)m_vertices.size();
-            fwrite(&nIndexCount, sizeof(uint32_t), 1, pFile);
-            fwrite(&nVertexCount, sizeof(uint32_t), 1, pFile);
-
-            fwrite(m_indexes.data(), sizeof(uint32_t), nIndexCount, pFile);
-            fwrite(m_vertices.data(), sizeof(VBBSimpleVertex), nVertexCount, pFile);
-            fwrite(m_normals.data(), sizeof(VBBSimpleNormal), nVertexCount, pFile);
-            fwrite(m_texCoords.data(), sizeof(VBBSimpleTexCoord), nVertexCount, pFile);
-            fclose(pFile);
-            return true;
-            }
-
-        return false;
+    // Small meshes can use 16-bit indexes, which halves the index fetch cost. 0xFFFF is never used as
+    // an index, it's the primitive restart value (VBB_PRIMITIVE_RESTART_INDEX comes out as 0xFFFF). Upload getIndexData() and bind with getIndexType().
+    VkIndexType getIndexType(void) { return (m_vertices.size() <= 0xFFFF) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32; }
+    void* getIndexData(void);
+    uint32_t getIndexDataSize(void) {
+        return getIndexCount() * ((getIndexType() == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t));
     }
 
+    // Interleaved (one buffer, one binding) export. Attributes are packed in the order given,
+    // each aligned to alignment bytes. Stride is rounded up to the alignment, pass a bigger
+    // one to pad each vertex out. pEncodings (one per attribute) picks quantized formats,
+    // the default is all floats. SNORM16 positions, OCTAHEDRAL normals and UNORM16 texcoords
+    // make a 16 byte vertex instead of 32. Decode the normals with StockShader_FakeLightQ.vert.
+    bool makeInterleavedLayout(VBBInterleavedLayout& layout, uint32_t attributeCount, const VBBMeshAttribute* pAttributes,
+                               uint32_t alignment = 4, uint32_t stride = 0, const VBBMeshEncoding* pEncodings = nullptr);
+    uint32_t getInterleavedSize(const VBBInterleavedLayout& layout) { return layout.stride * getAttributeCount(); }
+    void copyInterleaved(const VBBInterleavedLayout& layout, void* pDest);
 
-    bool loadMesh(const char* szMeshFile) {
-        FILE *pFile;
-        pFile = fopen(szMeshFile, "rb");
-        if(pFile != NULL) { // Falls through to build
-
-            // Get counts
-            uint32_t nIndexCount;
-            uint32_t nVertexCount;
-            fread(&nIndexCount, sizeof(uint32_t), 1, pFile);
-            fread(&nVertexCount, sizeof(uint32_t), 1, pFile);
-
-            // Allocate memory
-            m_indexes.resize(nIndexCount);
-            m_vertices.resize(nVertexCount);
-            m_normals.resize(nVertexCount);
-            m_texCoords.resize(nVertexCount);
-
-            // Read it in
-            fread(m_indexes.data(), sizeof(uint32_t), nIndexCount, pFile);
-            fread(m_vertices.data(), sizeof(VBBSimpleVertex), nVertexCount, pFile);
-            fread(m_normals.data(), sizeof(VBBSimpleNormal), nVertexCount, pFile);
-            fread(m_texCoords.data(), sizeof(VBBSimpleTexCoord), nVertexCount, pFile);
+    // Bounds are kept up to date as vertices are added, and endBuilding() tightens the sphere. Filling the
+    // mesh in any other way (allocateMesh(), getVertexPointer()) means they get worked out from scratch
+    // when next asked for. Call updateBounds() to do that right away.
+    const VBBBoundingBox& getBoundingBox(void) {
+        if (!m_boundsValid) updateBounds();
+        return m_boundingBox;
+    }
+    const VBBBoundingSphere& getBoundingSphere(void) {
+        if (!m_boundsValid) updateBounds();
+        return m_boundingSphere;
+    }
+    void updateBounds(void);
 
-            fclose(pFile);
-            return true;
-            }
+    // Bake a matrix (column major, like glm) into the positions and normals. A matrix that mirrors also
+    // turns the triangles around, so front faces stay front faces.
+    void transform(const float matrix[16]);
 
-        return false;
-    }
+    // Mesh files. saveMesh() writes the versioned format in VBBMeshFile.h, compressed or not, loadMesh() reads
+    // that or the older raw format. Use VBBMeshFile directly to get at the file without copying it.
+    bool saveMesh(const char* szMeshFile, bool bOptimize = false, bool bCompress = false);
+    bool loadMesh(const char* szMeshFile);
 
   protected:
     std::vector<VBBSimpleVertex> m_vertices;
     std::vector<VBBSimpleNormal> m_normals;
     std::vector<VBBSimpleTexCoord> m_texCoords;
     std::vector<uint32_t> m_indexes;
+    std::vector<uint16_t> m_indexes16;  // Only filled in by getIndexData()
 
     float m_epsilon = 0.0000001;
 
+    void growBounds(const float* pPoint);
+    static void growSphere(VBBBoundingSphere& sphere, const float* pPoint);
+
+    VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VBBBoundingBox m_boundingBox = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+    VBBBoundingSphere m_boundingSphere = {{0.0f, 0.0f, 0.0f}, 0.0f};
+    bool m_boundsValid = true;  // Empty mesh, empty bounds
+
+    // Spatial hash used to find matching vertices. Every attribute is quantized into cells
+    // a few epsilons wide, and each chain holds the vertex indexes that land in a cell.
+    enum : uint32_t { HASH_NORMALS = 1, HASH_TEXCOORDS = 2, HASH_END = 0xFFFFFFFF };
+    bool m_useSpatialHash = true;
+    bool m_hashDisabled = false;  // Attributes changed partway through a build
+    bool m_optimizeOnBuild = false;
+    uint32_t m_hashAttributes = 0;
+    double m_cellSize = 0.0;
+    std::unordered_map<uint64_t, uint32_t> m_hashHeads;
+    std::vector<uint32_t> m_hashNext;
+
+    void rebuildHash(void);
+    void insertHash(uint32_t index);
+    bool searchHash(VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord, uint32_t& index);
+    bool searchLinear(VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord, uint32_t startIndex,
+                      uint32_t& index);
+    bool isMatch(uint32_t index, VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord);
+    uint32_t countCacheMisses(uint32_t cacheSize);
+
     // Comparing floats is messy, use this instead of "==" and allow "close enough" to be equivalent
     inline bool closeEnough(float first, float second) { return (fabs(first - second) < m_epsilon) ? true : false; }
 };
@@ -162,9 +266,110 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
 void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outerRadius, uint32_t nSlices, uint32_t nStacks,
                  uint32_t degrees = 360);
 
+// Same shapes, but the vertex grid is written once and the indexes are worked out directly instead
+// of welding. Linear time, and the mesh is allocated exactly once. Seams are duplicated so texture
+// coordinates wrap properly. Each vertex depends only on its row and column, so the rows can be
+// split across nThreads threads (0 = all of them) and the result is the same bit for bit.
+// bStrips makes one triangle strip per row joined by primitive restarts instead of a triangle list,
+// about a third of the indexes.
+void VBBMakeTorusGrid(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float minorRadius, uint32_t numMajor, uint32_t numMinor,
+                      uint32_t nThreads = 1, bool bStrips = false);
+void VBBMakeSphereGrid(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iSlices, uint32_t iStacks, uint32_t nThreads = 1,
+                       bool bStrips = false);
+void VBBMakeCylinderGrid(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, float topRadius, float fLength, uint32_t numSlices,
+                         uint32_t numStacks, uint32_t degrees = 360, uint32_t nThreads = 1, bool bStrips = false);
+void VBBMakeDiskGrid(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outerRadius, uint32_t nSlices, uint32_t nStacks,
+                     uint32_t degrees = 360, uint32_t nThreads = 1, bool bStrips = false);
+
+// Meshlets (clusters) for culling. vbbBuildMeshlets() sorts the triangles so each meshlet is one
+// contiguous run of indexes, grown across shared edges so they stay compact. Each carries a
+// bounding sphere and a normal cone. See VBBMeshletCuller for doing the culling on the GPU.
+// Laid out to match the std430 struct in the cull shader
+struct VBBMeshlet {
+    float center[3];     // Bounding sphere
+    float radius;
+    float coneAxis[3];   // Average facing direction
+    float coneCutoff;    // Sine of the cone's half angle, 1.0 means don't cull by facing
+    uint32_t firstIndex; // Where the meshlet's triangles start in the index buffer
+    uint32_t indexCount;
+    uint32_t vertexCount;  // Unique vertices used
+    uint32_t reserved;
+};
+
+// Sort the mesh's triangles into meshlets. The vertices don't move, only the triangle order changes.
+// Run optimizeVertexCache() first if you want, meshlets are seeded in triangle order.
+bool vbbBuildMeshlets(VBBSimpleIndexedMesh& mesh, std::vector<VBBMeshlet>& meshlets, uint32_t maxVertices = 64,
+                      uint32_t maxTriangles = 124);
+
+// Frustum planes (a, b, c, d) x 6 from a column major model-view-projection matrix, normalized.
+// Vulkan clip space, so the near plane is z = 0.
+void vbbExtractFrustumPlanes(const float mvp[16], float planes[24]);
+
+// Same test the cull shader does, on the CPU
+bool vbbIsMeshletVisible(const VBBMeshlet& meshlet, const float planes[24], const float cameraPosition[3]);
+
+// Frustum culling of world space bounds, planes from vbbExtractFrustumPlanes(). The array versions do
+// four at a time with SSE or NEON where there is one, set pVisible[i] to 1 or 0, and return how many
+// are visible.
+bool vbbIsSphereVisible(const float planes[24], const VBBBoundingSphere& sphere);
+bool vbbIsBoxVisible(const float planes[24], const VBBBoundingBox& box);
+uint32_t vbbCullSpheres(const float planes[24], const VBBBoundingSphere* pSpheres, uint32_t count, uint8_t* pVisible);
+uint32_t vbbCullBoxes(const float planes[24], const VBBBoundingBox* pBoxes, uint32_t count, uint8_t* pVisible);
+
+// Model to world. The box is the box around the transformed box, the sphere radius is scaled by the
+// largest scale in the matrix.
+void vbbTransformBoundingBox(const VBBBoundingBox& box, const float matrix[16], VBBBoundingBox& result);
+void vbbTransformBoundingSphere(const VBBBoundingSphere& sphere, const float matrix[16], VBBBoundingSphere& result);
+
+// Level of detail. Simplification only drops triangles and reuses vertices, so every LOD shares the
+// mesh's vertex buffer and is just a range in one index buffer. Error is how far (model units, roughly
+// RMS) the surface moved, and is never smaller than the level before it.
+struct VBBMeshLOD {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+// Quadric error metric edge collapse. Stops at targetIndexCount or when the next collapse would be worse
+// than targetError, whichever comes first. Open edges stay put along the border, and vertices split for
+// normals or texture coordinates only move along their seam, with every copy moving together.
+uint32_t vbbSimplifyMesh(VBBSimpleIndexedMesh& mesh, std::vector<uint32_t>& indexes, uint32_t targetIndexCount,
+                         float targetError = FLT_MAX, float* pResultError = nullptr);
+
+// LOD 0 is the mesh as is, each level after that aims for reduction times as many triangles. Stops early
+// if it can't get there without going over maxError. All levels end up in indexes (32-bit).
+bool vbbBuildLODChain(VBBSimpleIndexedMesh& mesh, std::vector<uint32_t>& indexes, std::vector<VBBMeshLOD>& lods,
+                      uint32_t maxLevels = 5, float reduction = 0.5f, float maxError = FLT_MAX);
+
+// Error in pixels at this distance. pixelsPerUnit is viewport height / (2 * tan(fovY / 2)). Pick the
+// cheapest level that's under the pixel threshold.
+inline float vbbGetLODScreenError(const VBBMeshLOD& lod, float distance, float pixelsPerUnit) {
+    return (distance > 0.0f) ? lod.error * pixelsPerUnit / distance : FLT_MAX;
+}
+uint32_t vbbSelectLOD(const std::vector<VBBMeshLOD>& lods, float distance, float pixelsPerUnit, float maxPixelError = 1.0f);
+
+// Run work(first, end) over count items split into nThreads pieces. Blocks until they are all done.
+void vbbParallelFor(uint32_t count, uint32_t nThreads, const std::function<void(uint32_t, uint32_t)>& work);
+
+// Quantizing helpers. The half conversion rounds to nearest even. The dequantize matrix (column major)
+// turns SNORM16 positions back into model space, multiply it onto the right of the model matrix.
+uint16_t vbbFloatToHalf(float value);
+float vbbHalfToFloat(uint16_t value);
+void vbbOctahedralEncode(const float normal[3], int16_t encoded[2]);
+void vbbOctahedralDecode(const int16_t encoded[2], float normal[3]);
+void vbbGetDequantizeMatrix(const VBBInterleavedLayout& layout, float matrix[16]);
+
 // ******************************
 // Other little tidbits
+// Targas can be RLE compressed, paletted, or 16-bit. format says what the bytes are (BGR for color).
 unsigned char* vbbReadTGABits(const char* szFileName, uint32_t* iWidth, uint32_t* iHeight, uint32_t* iComponents, VkFormat* format,
                               unsigned char* pMemoryBuffer = nullptr);
 
+// Targas already in memory, a VBBMappedFile say. vbbGetTGAInfo() only looks at the header, vbbDecodeTGA()
+// writes *pImageSize bytes of pixels to pDest (which can be mapped staging memory) and nothing else.
+bool vbbGetTGAInfo(const void* pFileData, size_t fileSize, uint32_t* iWidth, uint32_t* iHeight, uint32_t* iComponents,
+                   VkFormat* format, size_t* pImageSize = nullptr);
+bool vbbDecodeTGA(const void* pFileData, size_t fileSize, void* pDest);
+const void* vbbGetTGAPixels(const void* pFileData, size_t fileSize);  // nullptr unless the pixels can be used as they are
+
 int getBytesPerPixel(VkFormat format);
@@ -31,6 +31,7 @@
 
 #include "VBBBufferStatic.h"
 #include "VBBPipelineGraphics.h"
+#include "VBBGeometryPool.h"
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -66,36 +67,20 @@ class VBBUtilsUnitAxes {
     VkResult            lastResult = VK_SUCCESS;
     VBBCanvas*          m_pCanvas = nullptr;
 
+    // All four shapes share one vertex and index buffer
+    VBBGeometryPool     *pGeometry = nullptr;
+
     float               sphereSize = 0.07f;
-    uint32_t            indexCountSphere = 0;
-    uint32_t            attribCountSphere = 0;
-    VBBBufferStatic     *pVertexBufferSphere = nullptr;
-    VBBBufferStatic     *pNormalBufferSphere = nullptr;
-    VBBBufferStatic     *pIndexBufferSphere = nullptr;
+    uint32_t            rangeSphere = 0;
 
     float               cylinderRadius = 0.04f;
     float               cylinderLength = 0.9f;
-    uint32_t            indexCountCylinder = 0;
-    uint32_t            attribCountCylinder = 0;
-    VBBBufferStatic     *pVertexBufferCylinder = nullptr;
-    VBBBufferStatic     *pNormalBufferCylinder = nullptr;
-    VBBBufferStatic     *pIndexBufferCylinder = nullptr;
+    uint32_t            rangeCylinder = 0;
 
     float               diskRadius = 0.06f;
-    uint32_t            indexCountDisk = 0;
-    uint32_t            attribCountDisk = 0;
-    VBBBufferStatic     *pVertexBufferDisk = nullptr;
-    VBBBufferStatic     *pNormalBufferDisk = nullptr;
-    VBBBufferStatic     *pIndexBufferDisk = nullptr;
+    uint32_t            rangeDisk = 0;
 
     float               coneBottomRadius = 0.07f;
     float               coneHeight = 0.1f;
-    uint32_t            indexCountCone = 0;
-    uint32_t            attribCountCone = 0;
-    VBBBufferStatic     *pVertexBufferCone = nullptr;
-    VBBBufferStatic     *pNormalBufferCone = nullptr;
-    VBBBufferStatic     *pIndexBufferCone = nullptr;
-
-
-
+    uint32_t            rangeCone = 0;
 };
@@ -44,7 +44,8 @@ VkResult VBBBufferStatic::createBuffer(VkDeviceSize size) {
 
     // I can be used for lots of things
     bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                       VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -90,17 +91,33 @@ bool VBBBufferStatic::updateBuffer(VBBBufferDynamic& dynamicBuffer, VBBDevice* p
     return VK_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Through the device's staging ring, or a buffer just for this if it doesn't have one
 bool VBBBufferStatic::updateBuffer(void* pData, VkDeviceSize size, VBBDevice* pLogicalDevice) {
-    VBBBufferDynamic temp(m_VMA);
-    temp.createBuffer(size);
-    void* p = temp.mapMemory();
-    memcpy(p, pData, size);
-    temp.unmapMemory();
+    if (size > m_bufferSize) return false;
+
+    VBBStagingAllocation staging;
+    if (!vbbAllocateStaging(pLogicalDevice->getStagingRing(), m_VMA, size, staging)) return false;
+    memcpy(staging.pData, pData, size);
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = staging.offset;
+    copyRegion.size = size;
 
-    updateBuffer(temp, pLogicalDevice);
+    VBBSingleShotCommand singleShot(pLogicalDevice->getDevice(), pLogicalDevice->getCommandPool(), pLogicalDevice->getQueue());
+    vkCmdCopyBuffer(singleShot.start(), staging.buffer, m_buffer, 1, &copyRegion);
+    singleShot.end();
+
+    vbbFreeStaging(staging);
     return true;
 }
 
+VBBUploadTicket VBBBufferStatic::updateBuffer(const void* pData, VkDeviceSize size, VBBUploadService& uploader, VkDeviceSize dstOffset) {
+    if (dstOffset > m_bufferSize || size > m_bufferSize - dstOffset) return 0;
+
+    return uploader.uploadBuffer(m_buffer, dstOffset, size, pData);
+}
+
 VkResult VBBBufferStatic::createBuffer(void* pData, VkDeviceSize size, VBBDevice* pLogicalDevice) {
     VkResult result = createBuffer(size);
     if (result == VK_SUCCESS) updateBuffer(pData, size, pLogicalDevice);
@@ -0,0 +1,182 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBGeometryPool.h"
+
+#include <string.h>
+
+// *********************************************************************************************************
+VBBGeometryPool::~VBBGeometryPool(void) { free(); }
+
+// *********************************************************************************************************
+void VBBGeometryPool::free(void) {
+    delete m_pVertexBuffer;
+    delete m_pIndexBuffer;
+    delete m_pDrawBuffer;
+    m_pVertexBuffer = nullptr;
+    m_pIndexBuffer = nullptr;
+    m_pDrawBuffer = nullptr;
+    m_drawSpans.clear();
+}
+
+// *********************************************************************************************************
+// An empty mesh is enough to work out the formats and offsets
+bool VBBGeometryPool::setLayout(uint32_t attributeCount, const VBBMeshAttribute* pAttributes, const VBBMeshEncoding* pEncodings,
+                                uint32_t alignment) {
+    if (!m_ranges.empty()) return false;  // Too late
+
+    VBBSimpleIndexedMesh empty;
+    if (!empty.makeInterleavedLayout(m_layout, attributeCount, pAttributes, alignment, 0, pEncodings)) return false;
+
+    m_alignment = alignment;
+    return true;
+}
+
+// *********************************************************************************************************
+// Vertices go on the end in the pool's layout, indexes go on the end unchanged
+uint32_t VBBGeometryPool::addMesh(VBBSimpleIndexedMesh& mesh) {
+    if (m_layout.attributeCount == 0 || mesh.getAttributeCount() == 0 || mesh.getIndexCount() == 0) return VBB_GEOMETRY_POOL_INVALID;
+
+    // Same layout, but with this mesh's quantization
+    VBBInterleavedLayout layout;
+    if (!mesh.makeInterleavedLayout(layout, m_layout.attributeCount, m_layout.attributes, m_alignment, m_layout.stride,
+                                    m_layout.encodings))
+        return VBB_GEOMETRY_POOL_INVALID;
+
+    VBBGeometryRange range;
+    range.firstIndex = static_cast<uint32_t>(m_indexes.size());
+    range.indexCount = mesh.getIndexCount();
+    range.vertexOffset = static_cast<int32_t>(m_vertices.size() / m_layout.stride);
+    range.vertexCount = mesh.getAttributeCount();
+    range.topology = mesh.getTopology();
+    for (int k = 0; k < 3; k++) {
+        range.positionScale[k] = layout.positionScale[k];
+        range.positionOffset[k] = layout.positionOffset[k];
+    }
+
+    size_t vertexStart = m_vertices.size();
+    m_vertices.resize(vertexStart + mesh.getInterleavedSize(layout));
+    mesh.copyInterleaved(layout, &m_vertices[vertexStart]);
+
+    const uint32_t* pIndexes = mesh.getIndexPointer();
+    m_indexes.insert(m_indexes.end(), pIndexes, pIndexes + range.indexCount);
+
+    if (range.vertexCount > m_maxMeshVertices) m_maxMeshVertices = range.vertexCount;
+
+    m_ranges.push_back(range);
+    return static_cast<uint32_t>(m_ranges.size() - 1);
+}
+
+// *********************************************************************************************************
+// Three buffers for everything, vertices, indexes, and the indirect draws
+VkResult VBBGeometryPool::createBuffers(VBBDevice* pLogicalDevice) {
+    if (pLogicalDevice == nullptr || m_ranges.empty()) return VK_ERROR_INITIALIZATION_FAILED;
+
+    free();
+
+    m_bMultiDrawIndirect = (pLogicalDevice->getEnabledFeatures().multiDrawIndirect == VK_TRUE);
+
+    m_pVertexBuffer = new VBBBufferStatic(m_VMA);
+    VkResult result = m_pVertexBuffer->createBuffer(m_vertices.data(), m_vertices.size(), pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    // Mesh local indexes, so half the size if every mesh is small enough
+    m_indexType = (m_maxMeshVertices <= 0xFFFF) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    m_pIndexBuffer = new VBBBufferStatic(m_VMA);
+    if (m_indexType == VK_INDEX_TYPE_UINT16) {
+        std::vector<uint16_t> shortIndexes(m_indexes.size());
+        for (size_t i = 0; i < m_indexes.size(); i++)
+            shortIndexes[i] = (m_indexes[i] == VBB_PRIMITIVE_RESTART_INDEX) ? 0xFFFF : static_cast<uint16_t>(m_indexes[i]);
+        result = m_pIndexBuffer->createBuffer(shortIndexes.data(), sizeof(uint16_t) * shortIndexes.size(), pLogicalDevice);
+    } else
+        result = m_pIndexBuffer->createBuffer(m_indexes.data(), sizeof(uint32_t) * m_indexes.size(), pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    // Each topology's draws together, in the order the topologies first show up
+    std::vector<VkDrawIndexedIndirectCommand> draws;
+    draws.reserve(m_ranges.size());
+    for (size_t i = 0; i < m_ranges.size(); i++) {
+        bool bSeen = false;
+        for (size_t s = 0; s < m_drawSpans.size(); s++) bSeen = bSeen || (m_drawSpans[s].topology == m_ranges[i].topology);
+        if (bSeen) continue;
+
+        DrawSpan span = {m_ranges[i].topology, static_cast<uint32_t>(draws.size()), 0};
+        for (size_t j = i; j < m_ranges.size(); j++) {
+            if (m_ranges[j].topology != span.topology) continue;
+
+            VkDrawIndexedIndirectCommand draw;
+            draw.indexCount = m_ranges[j].indexCount;
+            draw.instanceCount = 1;
+            draw.firstIndex = m_ranges[j].firstIndex;
+            draw.vertexOffset = m_ranges[j].vertexOffset;
+            draw.firstInstance = 0;
+            draws.push_back(draw);
+            span.count++;
+        }
+        m_drawSpans.push_back(span);
+    }
+
+    m_pDrawBuffer = new VBBBufferStatic(m_VMA);
+    result = m_pDrawBuffer->createBuffer(draws.data(), sizeof(VkDrawIndexedIndirectCommand) * draws.size(), pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    m_allocationCount = 3;
+    return VK_SUCCESS;
+}
+
+// *********************************************************************************************************
+void VBBGeometryPool::bind(VkCommandBuffer cmdBuffer, uint32_t binding) {
+    VkBuffer vertexBuffers[] = {m_pVertexBuffer->getBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(cmdBuffer, binding, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(cmdBuffer, m_pIndexBuffer->getBuffer(), 0, m_indexType);
+    m_bindCount++;
+}
+
+// *********************************************************************************************************
+void VBBGeometryPool::draw(VkCommandBuffer cmdBuffer, uint32_t range, uint32_t instanceCount, uint32_t firstInstance) {
+    const VBBGeometryRange& r = m_ranges[range];
+    vkCmdDrawIndexed(cmdBuffer, r.indexCount, instanceCount, r.firstIndex, r.vertexOffset, firstInstance);
+    m_drawCount++;
+}
+
+// *********************************************************************************************************
+// Without multiDrawIndirect each indirect draw can only be one command
+void VBBGeometryPool::drawAll(VkCommandBuffer cmdBuffer, VkPrimitiveTopology topology) {
+    const DrawSpan* pSpan = nullptr;
+    for (size_t s = 0; s < m_drawSpans.size(); s++)
+        if (m_drawSpans[s].topology == topology) pSpan = &m_drawSpans[s];
+    if (pSpan == nullptr) return;
+
+    VkDeviceSize offset = pSpan->first * sizeof(VkDrawIndexedIndirectCommand);
+    if (m_bMultiDrawIndirect) {
+        vkCmdDrawIndexedIndirect(cmdBuffer, m_pDrawBuffer->getBuffer(), offset, pSpan->count, sizeof(VkDrawIndexedIndirectCommand));
+        m_drawCount++;
+        return;
+    }
+
+    for (uint32_t i = 0; i < pSpan->count; i++)
+        vkCmdDrawIndexedIndirect(cmdBuffer, m_pDrawBuffer->getBuffer(), offset + i * sizeof(VkDrawIndexedIndirectCommand), 1,
+                                 sizeof(VkDrawIndexedIndirectCommand));
+    m_drawCount += pSpan->count;
+}
@@ -0,0 +1,112 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// *********************************************************************************************************
+bool VBBMappedFile::open(const char* szFileName, size_t minSize) {
+    close();
+
+    if (szFileName == nullptr) return false;
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart < (LONGLONG)minSize) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (pView == NULL) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_hFile = hFile;
+    m_hMapping = hMapping;
+    m_pData = static_cast<const unsigned char*>(pView);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(szFileName, O_RDONLY);
+    if (fd < 0) return false;
+
+    // Zero length files can't be mapped
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0 || fileStat.st_size < (off_t)minSize) {
+        ::close(fd);
+        return false;
+    }
+
+    // Everything that maps a file reads all of it, so fault it all in at once where that's possible
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void* pView = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, flags, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (pView == MAP_FAILED) return false;
+
+    m_pData = static_cast<const unsigned char*>(pView);
+    m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+// *********************************************************************************************************
+void VBBMappedFile::close(void) {
+    if (m_pData == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_pData);
+    CloseHandle(static_cast<HANDLE>(m_hMapping));
+    CloseHandle(static_cast<HANDLE>(m_hFile));
+    m_hMapping = nullptr;
+    m_hFile = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(m_pData), m_size);
+#endif
+
+    m_pData = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,202 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMath.h"
+
+#include <math.h>
+
+// *********************************************************************************************************
+// Four packed float[3] in three registers, out to x, y, z registers and back again
+#if defined(VBB_SIMD_SSE)
+static inline void load3x4(const float* p, __m128& x, __m128& y, __m128& z) {
+    __m128 a = _mm_loadu_ps(p);      // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(p + 4);  // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(p + 8);  // z2 x3 y3 z3
+
+    __m128 t0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+    __m128 t1 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+    x = _mm_shuffle_ps(a, t1, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(t0, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+static inline void store3x4(float* p, __m128 x, __m128 y, __m128 z) {
+    __m128 xy0 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 0, 1, 0));  // x0 x1 y0 y1
+    __m128 zx0 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));  // z0 z0 x1 x1
+    __m128 yz1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));  // y1 y1 z1 z1
+    __m128 xy2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));  // x2 x2 y2 y2
+    __m128 zx3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));  // z2 z2 x3 x3
+    __m128 yz3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));  // y3 y3 z3 z3
+
+    _mm_storeu_ps(p, _mm_shuffle_ps(xy0, zx0, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz1, xy2, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx3, yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+// *********************************************************************************************************
+static inline void normalizeOne(float* v) {
+    float lengthSq = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    if (lengthSq <= 0.0f) return;
+
+    float scale = 1.0f / sqrtf(lengthSq);
+    v[0] *= scale;
+    v[1] *= scale;
+    v[2] *= scale;
+}
+
+void vbbNormalizeArray(float* pVectors, uint32_t count) {
+    uint32_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load3x4(pVectors + i * 3, x, y, z);
+
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 scale = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));  // Full precision, rsqrt is only 12 bits
+        scale = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(lengthSq, _mm_setzero_ps()), scale),
+                          _mm_andnot_ps(_mm_cmpgt_ps(lengthSq, _mm_setzero_ps()), one));
+
+        store3x4(pVectors + i * 3, _mm_mul_ps(x, scale), _mm_mul_ps(y, scale), _mm_mul_ps(z, scale));
+    }
+#elif defined(VBB_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(pVectors + i * 3);
+
+        float32x4_t lengthSq = vmulq_f32(v.val[0], v.val[0]);
+        lengthSq = vmlaq_f32(lengthSq, v.val[1], v.val[1]);
+        lengthSq = vmlaq_f32(lengthSq, v.val[2], v.val[2]);
+
+        // Estimate plus two Newton steps gets close to full precision, and works on 32-bit ARM too
+        float32x4_t scale = vrsqrteq_f32(lengthSq);
+        scale = vmulq_f32(scale, vrsqrtsq_f32(vmulq_f32(lengthSq, scale), scale));
+        scale = vmulq_f32(scale, vrsqrtsq_f32(vmulq_f32(lengthSq, scale), scale));
+        scale = vbslq_f32(vcgtq_f32(lengthSq, vdupq_n_f32(0.0f)), scale, vdupq_n_f32(1.0f));
+
+        v.val[0] = vmulq_f32(v.val[0], scale);
+        v.val[1] = vmulq_f32(v.val[1], scale);
+        v.val[2] = vmulq_f32(v.val[2], scale);
+        vst3q_f32(pVectors + i * 3, v);
+    }
+#endif
+
+    for (; i < count; i++) normalizeOne(pVectors + i * 3);
+}
+
+// *********************************************************************************************************
+// The 3x3 is passed as columns with a stride, so the same code does both
+static inline void transformOne(const float* c0, const float* c1, const float* c2, const float* translate, const float* in, float* out) {
+    float x = in[0], y = in[1], z = in[2];
+    out[0] = c0[0] * x + c1[0] * y + c2[0] * z + translate[0];
+    out[1] = c0[1] * x + c1[1] * y + c2[1] * z + translate[1];
+    out[2] = c0[2] * x + c1[2] * y + c2[2] * z + translate[2];
+}
+
+static void transformArray(const float* c0, const float* c1, const float* c2, const float* translate, const float* pIn, float* pOut,
+                           uint32_t count) {
+    uint32_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    __m128 m[12];
+    const float* columns[4] = {c0, c1, c2, translate};
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 3; r++) m[c * 3 + r] = _mm_set1_ps(columns[c][r]);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load3x4(pIn + i * 3, x, y, z);
+
+        __m128 outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[3], y)), _mm_add_ps(_mm_mul_ps(m[6], z), m[9]));
+        __m128 outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1], x), _mm_mul_ps(m[4], y)), _mm_add_ps(_mm_mul_ps(m[7], z), m[10]));
+        __m128 outZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2], x), _mm_mul_ps(m[5], y)), _mm_add_ps(_mm_mul_ps(m[8], z), m[11]));
+
+        store3x4(pOut + i * 3, outX, outY, outZ);
+    }
+#elif defined(VBB_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t v = vld3q_f32(pIn + i * 3);
+        float32x4x3_t out;
+
+        for (int r = 0; r < 3; r++) {
+            float32x4_t sum = vmlaq_n_f32(vdupq_n_f32(translate[r]), v.val[0], c0[r]);
+            sum = vmlaq_n_f32(sum, v.val[1], c1[r]);
+            out.val[r] = vmlaq_n_f32(sum, v.val[2], c2[r]);
+        }
+
+        vst3q_f32(pOut + i * 3, out);
+    }
+#endif
+
+    for (; i < count; i++) transformOne(c0, c1, c2, translate, pIn + i * 3, pOut + i * 3);
+}
+
+void vbbTransformPoints(const float matrix[16], const float* pIn, float* pOut, uint32_t count) {
+    transformArray(&matrix[0], &matrix[4], &matrix[8], &matrix[12], pIn, pOut, count);
+}
+
+void vbbTransformVectors(const float matrix[9], const float* pIn, float* pOut, uint32_t count) {
+    static const float zero[3] = {0.0f, 0.0f, 0.0f};
+    transformArray(&matrix[0], &matrix[3], &matrix[6], zero, pIn, pOut, count);
+}
+
+// *********************************************************************************************************
+// The cofactor matrix is the inverse transpose times the determinant. Column j of the cofactor matrix
+// is the cross product of the other two columns of the original.
+float vbbGetNormalMatrix(const float matrix[16], float normalMatrix[9]) {
+    const float* a = &matrix[0];
+    const float* b = &matrix[4];
+    const float* c = &matrix[8];
+
+    normalMatrix[0] = b[1] * c[2] - b[2] * c[1];
+    normalMatrix[1] = b[2] * c[0] - b[0] * c[2];
+    normalMatrix[2] = b[0] * c[1] - b[1] * c[0];
+
+    normalMatrix[3] = c[1] * a[2] - c[2] * a[1];
+    normalMatrix[4] = c[2] * a[0] - c[0] * a[2];
+    normalMatrix[5] = c[0] * a[1] - c[1] * a[0];
+
+    normalMatrix[6] = a[1] * b[2] - a[2] * b[1];
+    normalMatrix[7] = a[2] * b[0] - a[0] * b[2];
+    normalMatrix[8] = a[0] * b[1] - a[1] * b[0];
+
+    float determinant = a[0] * normalMatrix[0] + a[1] * normalMatrix[1] + a[2] * normalMatrix[2];
+
+    // Mirrored, flip them back around so normals still point out
+    if (determinant < 0.0f)
+        for (int i = 0; i < 9; i++) normalMatrix[i] = -normalMatrix[i];
+
+    return determinant;
+}
+
+// *********************************************************************************************************
+// Straight calls, not a recurrence, so the table is exactly what calling sin() and cos() in the loop
+// would have given.
+void vbbMakeSinCosTable(uint32_t count, double step, double* pSin, double* pCos, bool bWrap) {
+    for (uint32_t i = 0; i < count; i++) {
+        double angle = (bWrap && i == count - 1) ? 0.0 : double(i) * step;
+        pSin[i] = sin(angle);
+        pCos[i] = cos(angle);
+    }
+}
@@ -0,0 +1,626 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMeshFile.h"
+#include "VBBUtils.h"
+#include "VBBMath.h"
+
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+
+
+static_assert(sizeof(VBBMeshFileHeader) == 88, "VBBMeshFileHeader is part of the file format, don't change its size");
+static_assert(sizeof(VBBMeshFileSection) == 32, "VBBMeshFileSection is part of the file format, don't change its size");
+
+static uint64_t vbbAlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+VBBMeshFile::~VBBMeshFile(void) { close(); }
+
+// *********************************************************************************************************
+// The zlib CRC32, eight bytes at a time (slicing by 8)
+struct VBBCRC32Tables {
+    uint32_t table[8][256];
+
+    VBBCRC32Tables(void) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+            for (int t = 1; t < 8; t++) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+    }
+};
+
+uint32_t VBBMeshFile::crc32(const void* pData, size_t size, uint32_t crc) {
+    static const VBBCRC32Tables tables;  // Made the first time through
+    const uint32_t(*table)[256] = tables.table;
+
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+    crc = ~crc;
+
+    while (size >= 8) {
+        uint32_t lo = crc ^ (uint32_t(pBytes[0]) | uint32_t(pBytes[1]) << 8 | uint32_t(pBytes[2]) << 16 | uint32_t(pBytes[3]) << 24);
+        uint32_t hi = uint32_t(pBytes[4]) | uint32_t(pBytes[5]) << 8 | uint32_t(pBytes[6]) << 16 | uint32_t(pBytes[7]) << 24;
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+        pBytes += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0) crc = table[0][(crc ^ *pBytes++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+// *********************************************************************************************************
+// Mesh codec. Values are 1, 2, or 4 bytes, whatever evenly divides the stride.
+static inline uint32_t vbbCodecElementSize(uint32_t stride) { return (stride % 4 == 0) ? 4 : ((stride % 2 == 0) ? 2 : 1); }
+
+static inline uint32_t vbbCodecBlockRows(uint32_t stride) {
+    uint32_t rows = VBB_MESH_CODEC_BLOCK_SIZE / stride;
+    return (rows > 0) ? rows : 1;
+}
+
+// Runs of zeros and literals. A token under 0x80 is followed by token + 1 literal bytes, 0x80 and up is
+// (token & 0x7F) + 1 zeros. Short runs of zeros are cheaper left in with the literals.
+static void vbbCodecPackRuns(const unsigned char* pBytes, size_t size, std::vector<unsigned char>& encoded) {
+    size_t literalStart = 0;
+    size_t i = 0;
+
+    while (i <= size) {
+        size_t zeros = 0;
+        if (i < size && pBytes[i] != 0) {
+            i++;
+            continue;
+        }
+
+        while (i + zeros < size && pBytes[i + zeros] == 0) zeros++;
+        if (i < size && zeros < 3 && i + zeros < size) {
+            i += zeros;
+            continue;
+        }
+
+        // Flush the literals so far, then the zeros
+        for (size_t start = literalStart; start < i;) {
+            size_t run = (i - start > 128) ? 128 : i - start;
+            encoded.push_back(static_cast<unsigned char>(run - 1));
+            encoded.insert(encoded.end(), pBytes + start, pBytes + start + run);
+            start += run;
+        }
+
+        for (size_t left = zeros; left > 0;) {
+            size_t run = (left > 128) ? 128 : left;
+            encoded.push_back(static_cast<unsigned char>(0x80 | (run - 1)));
+            left -= run;
+        }
+
+        i += zeros;
+        literalStart = i;
+        if (i == size) break;
+    }
+}
+
+// Returns how much of the encoded data it used, or 0 if it ran off either end
+static size_t vbbCodecUnpackRuns(const unsigned char* pEncoded, size_t encodedSize, unsigned char* pBytes, size_t size) {
+    const unsigned char* pSource = pEncoded;
+    const unsigned char* pEnd = pEncoded + encodedSize;
+    size_t written = 0;
+
+    while (written < size) {
+        if (pSource >= pEnd) return 0;
+
+        uint32_t token = *pSource++;
+        size_t run = (token & 0x7F) + 1;
+        if (run > size - written) return 0;
+
+        if (token & 0x80)
+            memset(pBytes + written, 0, run);
+        else {
+            if (run > size_t(pEnd - pSource)) return 0;
+            memcpy(pBytes + written, pSource, run);
+            pSource += run;
+        }
+        written += run;
+    }
+
+    return static_cast<size_t>(pSource - pEncoded);
+}
+
+template <typename T>
+static void vbbCodecFilter(const unsigned char* pSource, uint32_t rows, uint32_t stride, unsigned char* pPlanes) {
+    const uint32_t components = stride / sizeof(T);
+    const size_t planeSize = size_t(rows) * components;
+    const T signShift = T(sizeof(T) * 8 - 1);
+
+    T previous[VBB_MESH_CODEC_MAX_STRIDE];
+    memset(previous, 0, sizeof(previous));
+
+    size_t element = 0;
+    for (uint32_t r = 0; r < rows; r++)
+        for (uint32_t c = 0; c < components; c++, element++) {
+            T value;
+            memcpy(&value, pSource + size_t(r) * stride + c * sizeof(T), sizeof(T));
+            T delta = T(value - previous[c]);
+            previous[c] = value;
+
+            T zigzag = T(T(delta << 1) ^ T(0 - T(delta >> signShift)));
+            for (uint32_t p = 0; p < sizeof(T); p++) pPlanes[p * planeSize + element] = static_cast<unsigned char>(zigzag >> (p * 8));
+        }
+}
+
+// Put the bytes back together and undo the ZigZag, sixteen values at a time when there's SIMD
+static inline void vbbCodecJoinPlanes(const unsigned char* pPlanes, size_t count, uint8_t* pValues) {
+    for (size_t e = 0; e < count; e++) pValues[e] = uint8_t((pPlanes[e] >> 1) ^ (0 - (pPlanes[e] & 1)));
+}
+
+static inline void vbbCodecJoinPlanes(const unsigned char* pPlanes, size_t count, uint16_t* pValues) {
+    const unsigned char* p0 = pPlanes;
+    const unsigned char* p1 = pPlanes + count;
+    size_t e = 0;
+
+#if defined(VBB_SIMD_SSE)
+    const __m128i one = _mm_set1_epi16(1);
+    for (; e + 16 <= count; e += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + e));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + e));
+        __m128i z[2] = {_mm_unpacklo_epi8(b0, b1), _mm_unpackhi_epi8(b0, b1)};
+        for (int k = 0; k < 2; k++) {
+            __m128i v = _mm_xor_si128(_mm_srli_epi16(z[k], 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(z[k], one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pValues + e + k * 8), v);
+        }
+    }
+#elif defined(VBB_SIMD_NEON)
+    const uint16x8_t one = vdupq_n_u16(1);
+    for (; e + 16 <= count; e += 16) {
+        uint8x16x2_t z = vzipq_u8(vld1q_u8(p0 + e), vld1q_u8(p1 + e));
+        for (int k = 0; k < 2; k++) {
+            uint16x8_t w = vreinterpretq_u16_u8(z.val[k]);
+            vst1q_u16(pValues + e + k * 8, veorq_u16(vshrq_n_u16(w, 1), vsubq_u16(vdupq_n_u16(0), vandq_u16(w, one))));
+        }
+    }
+#endif
+
+    for (; e < count; e++) {
+        uint16_t zigzag = uint16_t(p0[e] | (p1[e] << 8));
+        pValues[e] = uint16_t((zigzag >> 1) ^ (0 - (zigzag & 1)));
+    }
+}
+
+static inline void vbbCodecJoinPlanes(const unsigned char* pPlanes, size_t count, uint32_t* pValues) {
+    const unsigned char* p0 = pPlanes;
+    const unsigned char* p1 = pPlanes + count;
+    const unsigned char* p2 = pPlanes + count * 2;
+    const unsigned char* p3 = pPlanes + count * 3;
+    size_t e = 0;
+
+#if defined(VBB_SIMD_SSE)
+    const __m128i one = _mm_set1_epi32(1);
+    for (; e + 16 <= count; e += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + e));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + e));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2 + e));
+        __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p3 + e));
+        __m128i lo01 = _mm_unpacklo_epi8(b0, b1), hi01 = _mm_unpackhi_epi8(b0, b1);
+        __m128i lo23 = _mm_unpacklo_epi8(b2, b3), hi23 = _mm_unpackhi_epi8(b2, b3);
+        __m128i z[4] = {_mm_unpacklo_epi16(lo01, lo23), _mm_unpackhi_epi16(lo01, lo23), _mm_unpacklo_epi16(hi01, hi23),
+                        _mm_unpackhi_epi16(hi01, hi23)};
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_xor_si128(_mm_srli_epi32(z[k], 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z[k], one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pValues + e + k * 4), v);
+        }
+    }
+#elif defined(VBB_SIMD_NEON)
+    const uint32x4_t one = vdupq_n_u32(1);
+    for (; e + 16 <= count; e += 16) {
+        uint8x16x2_t b01 = vzipq_u8(vld1q_u8(p0 + e), vld1q_u8(p1 + e));
+        uint8x16x2_t b23 = vzipq_u8(vld1q_u8(p2 + e), vld1q_u8(p3 + e));
+        for (int h = 0; h < 2; h++) {
+            uint16x8x2_t w = vzipq_u16(vreinterpretq_u16_u8(b01.val[h]), vreinterpretq_u16_u8(b23.val[h]));
+            for (int k = 0; k < 2; k++) {
+                uint32x4_t z = vreinterpretq_u32_u16(w.val[k]);
+                vst1q_u32(pValues + e + h * 8 + k * 4, veorq_u32(vshrq_n_u32(z, 1), vsubq_u32(vdupq_n_u32(0), vandq_u32(z, one))));
+            }
+        }
+    }
+#endif
+
+    for (; e < count; e++) {
+        uint32_t zigzag = uint32_t(p0[e]) | uint32_t(p1[e]) << 8 | uint32_t(p2[e]) << 16 | uint32_t(p3[e]) << 24;
+        pValues[e] = (zigzag >> 1) ^ (0 - (zigzag & 1));
+    }
+}
+
+// Then add each value to the one a row back. All of it in a block sized scratch buffer, then one
+// copy out, mapped memory likes big sequential writes.
+template <typename T>
+static void vbbCodecUnfilter(const unsigned char* pPlanes, uint32_t rows, uint32_t stride, unsigned char* pDest) {
+    const uint32_t components = stride / sizeof(T);
+    const size_t count = size_t(rows) * components;
+
+    T values[VBB_MESH_CODEC_BLOCK_SIZE / sizeof(T)];
+    vbbCodecJoinPlanes(pPlanes, count, values);
+
+    // One component at a time keeps the running total in a register
+    for (uint32_t c = 0; c < components; c++) {
+        T total = 0;
+        for (size_t e = c; e < count; e += components) {
+            total = T(total + values[e]);
+            values[e] = total;
+        }
+    }
+
+    memcpy(pDest, values, count * sizeof(T));
+}
+
+void VBBMeshFile::encodeStream(const void* pSource, uint32_t count, uint32_t stride, std::vector<unsigned char>& encoded) {
+    if (pSource == nullptr || count == 0 || stride == 0 || stride > VBB_MESH_CODEC_MAX_STRIDE) return;
+
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pSource);
+    const uint32_t elementSize = vbbCodecElementSize(stride);
+    const uint32_t blockRows = vbbCodecBlockRows(stride);
+    unsigned char planes[VBB_MESH_CODEC_BLOCK_SIZE];
+
+    // Blocks start over from zero, so any of them can be decoded on its own
+    for (uint32_t row = 0; row < count; row += blockRows) {
+        uint32_t rows = (count - row < blockRows) ? count - row : blockRows;
+        const unsigned char* pBlock = pBytes + size_t(row) * stride;
+
+        if (elementSize == 4)
+            vbbCodecFilter<uint32_t>(pBlock, rows, stride, planes);
+        else if (elementSize == 2)
+            vbbCodecFilter<uint16_t>(pBlock, rows, stride, planes);
+        else
+            vbbCodecFilter<uint8_t>(pBlock, rows, stride, planes);
+
+        vbbCodecPackRuns(planes, size_t(rows) * stride, encoded);
+    }
+}
+
+bool VBBMeshFile::decodeStream(const void* pEncoded, size_t encodedSize, uint32_t count, uint32_t stride, void* pDest) {
+    if (count == 0) return encodedSize == 0;
+    if (pEncoded == nullptr || pDest == nullptr || stride == 0 || stride > VBB_MESH_CODEC_MAX_STRIDE) return false;
+
+    const unsigned char* pSource = static_cast<const unsigned char*>(pEncoded);
+    unsigned char* pBytes = static_cast<unsigned char*>(pDest);
+    const uint32_t elementSize = vbbCodecElementSize(stride);
+    const uint32_t blockRows = vbbCodecBlockRows(stride);
+    unsigned char planes[VBB_MESH_CODEC_BLOCK_SIZE];
+
+    for (uint32_t row = 0; row < count; row += blockRows) {
+        uint32_t rows = (count - row < blockRows) ? count - row : blockRows;
+
+        size_t used = vbbCodecUnpackRuns(pSource, encodedSize, planes, size_t(rows) * stride);
+        if (used == 0) return false;
+        pSource += used;
+        encodedSize -= used;
+
+        unsigned char* pBlock = pBytes + size_t(row) * stride;
+        if (elementSize == 4)
+            vbbCodecUnfilter<uint32_t>(planes, rows, stride, pBlock);
+        else if (elementSize == 2)
+            vbbCodecUnfilter<uint16_t>(planes, rows, stride, pBlock);
+        else
+            vbbCodecUnfilter<uint8_t>(planes, rows, stride, pBlock);
+    }
+
+    return encodedSize == 0;  // Anything left over means it wasn't what we thought it was
+}
+
+// *********************************************************************************************************
+// Map the whole file and check it out. Nothing is copied, the section pointers point into the mapping.
+bool VBBMeshFile::open(const char* szFileName, bool bVerifyChecksum) {
+    close();
+
+    if (!m_file.open(szFileName, sizeof(VBBMeshFileHeader))) return false;
+
+    m_pData = m_file.getData();
+    m_size = m_file.getSize();
+
+    // Is this really one of ours?
+    const VBBMeshFileHeader* pHeader = reinterpret_cast<const VBBMeshFileHeader*>(m_pData);
+    if (pHeader->magic != VBB_MESH_FILE_MAGIC || pHeader->version != VBB_MESH_FILE_VERSION ||
+        pHeader->headerSize < sizeof(VBBMeshFileHeader) || pHeader->fileSize != m_size) {
+        close();
+        return false;
+    }
+
+    uint64_t tableEnd = uint64_t(pHeader->headerSize) + uint64_t(pHeader->sectionCount) * sizeof(VBBMeshFileSection);
+    if (tableEnd > m_size) {
+        close();
+        return false;
+    }
+
+    // Every section has to be inside the file and big enough for what it claims to hold. Compressed
+    // ones can't be checked for size until they're decoded.
+    const VBBMeshFileSection* pSections = reinterpret_cast<const VBBMeshFileSection*>(m_pData + pHeader->headerSize);
+    bool bCompressed = (pHeader->flags & VBB_MESH_FILE_FLAG_COMPRESSED) != 0;
+    for (uint32_t i = 0; i < pHeader->sectionCount; i++) {
+        const VBBMeshFileSection& section = pSections[i];
+        if (section.offset % VBB_MESH_FILE_ALIGNMENT != 0 || section.offset > m_size || section.size > m_size - section.offset ||
+            (!bCompressed && uint64_t(section.stride) * section.count > section.size)) {
+            close();
+            return false;
+        }
+    }
+
+    // The checksum covers the whole file, with the checksum itself taken as zero
+    if (bVerifyChecksum) {
+        VBBMeshFileHeader header = *pHeader;
+        header.checksum = 0;
+        uint32_t crc = crc32(&header, sizeof(header));
+        crc = crc32(m_pData + sizeof(VBBMeshFileHeader), m_size - sizeof(VBBMeshFileHeader), crc);
+        if (crc != pHeader->checksum) {
+            close();
+            return false;
+        }
+    }
+
+    m_pHeader = pHeader;
+    m_pSections = pSections;
+    return true;
+}
+
+// *********************************************************************************************************
+void VBBMeshFile::close(void) {
+    if (m_pData == nullptr) return;
+
+    m_file.close();
+
+    m_pData = nullptr;
+    m_size = 0;
+    m_pHeader = nullptr;
+    m_pSections = nullptr;
+}
+
+// *********************************************************************************************************
+VkIndexType VBBMeshFile::getIndexType(void) {
+    const VBBMeshFileSection* pSection = findSection(VBB_MESH_SECTION_INDEXES);
+    if (pSection != nullptr && pSection->format == VK_FORMAT_R16_UINT) return VK_INDEX_TYPE_UINT16;
+
+    return VK_INDEX_TYPE_UINT32;
+}
+
+// *********************************************************************************************************
+const VBBMeshFileSection* VBBMeshFile::findSection(VBBMeshSectionType type) {
+    if (m_pHeader == nullptr) return nullptr;
+
+    for (uint32_t i = 0; i < m_pHeader->sectionCount; i++)
+        if (m_pSections[i].type == uint32_t(type)) return &m_pSections[i];
+
+    return nullptr;
+}
+
+// *********************************************************************************************************
+// Pointer straight into the mapped file. Good until close().
+const void* VBBMeshFile::getSectionData(VBBMeshSectionType type, uint64_t* pSize, VkFormat* pFormat) {
+    const VBBMeshFileSection* pSection = findSection(type);
+    if (pSection == nullptr) return nullptr;
+
+    if (pSize != nullptr) *pSize = pSection->size;
+    if (pFormat != nullptr) *pFormat = VkFormat(pSection->format);
+
+    return m_pData + pSection->offset;
+}
+
+// *********************************************************************************************************
+uint64_t VBBMeshFile::getDecodedSize(VBBMeshSectionType type) {
+    const VBBMeshFileSection* pSection = findSection(type);
+    return (pSection != nullptr) ? uint64_t(pSection->stride) * pSection->count : 0;
+}
+
+// *********************************************************************************************************
+// Uncompressed sections are just copied
+bool VBBMeshFile::decodeSection(VBBMeshSectionType type, void* pDest) {
+    const VBBMeshFileSection* pSection = findSection(type);
+    if (pSection == nullptr || pDest == nullptr) return false;
+
+    if (!isCompressed()) {
+        memcpy(pDest, m_pData + pSection->offset, static_cast<size_t>(uint64_t(pSection->stride) * pSection->count));
+        return true;
+    }
+
+    return decodeStream(m_pData + pSection->offset, static_cast<size_t>(pSection->size), pSection->count, pSection->stride, pDest);
+}
+
+// *********************************************************************************************************
+// Copy the file contents into a mesh. Indexes are widened back to 32-bit if they were stored as 16.
+bool VBBMeshFile::copyToMesh(VBBSimpleIndexedMesh& mesh) {
+    if (m_pHeader == nullptr) return false;
+
+    const VBBMeshFileSection* pPositions = findSection(VBB_MESH_SECTION_POSITIONS);
+    const VBBMeshFileSection* pNormals = findSection(VBB_MESH_SECTION_NORMALS);
+    const VBBMeshFileSection* pTexCoords = findSection(VBB_MESH_SECTION_TEXCOORDS);
+    const VBBMeshFileSection* pIndexes = findSection(VBB_MESH_SECTION_INDEXES);
+
+    uint32_t vertexCount = m_pHeader->vertexCount;
+    uint32_t indexCount = m_pHeader->indexCount;
+
+    // Only the layouts we write are understood. Strides too, everything is decoded straight into the mesh.
+    if (pPositions == nullptr || pPositions->format != VK_FORMAT_R32G32B32_SFLOAT || pPositions->count != vertexCount ||
+        pPositions->stride != sizeof(VBBSimpleIndexedMesh::VBBSimpleVertex))
+        return false;
+    if (pNormals != nullptr && (pNormals->format != VK_FORMAT_R32G32B32_SFLOAT || pNormals->count != vertexCount ||
+                                pNormals->stride != sizeof(VBBSimpleIndexedMesh::VBBSimpleNormal)))
+        return false;
+    if (pTexCoords != nullptr && (pTexCoords->format != VK_FORMAT_R32G32_SFLOAT || pTexCoords->count != vertexCount ||
+                                  pTexCoords->stride != sizeof(VBBSimpleIndexedMesh::VBBSimpleTexCoord)))
+        return false;
+    if (pIndexes == nullptr || pIndexes->count != indexCount) return false;
+    if (pIndexes->format != VK_FORMAT_R16_UINT && pIndexes->format != VK_FORMAT_R32_UINT) return false;
+    if (pIndexes->stride != ((pIndexes->format == VK_FORMAT_R16_UINT) ? sizeof(uint16_t) : sizeof(uint32_t))) return false;
+
+    mesh.allocateMesh(vertexCount, indexCount, pNormals != nullptr, pTexCoords != nullptr);
+    mesh.setTopology(getTopology());
+    bool bStrips = (mesh.getTopology() == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+
+    bool bOK = decodeSection(VBB_MESH_SECTION_POSITIONS, mesh.getVertexPointer());
+    if (bOK && pNormals != nullptr) bOK = decodeSection(VBB_MESH_SECTION_NORMALS, mesh.getNormalPointer());
+    if (bOK && pTexCoords != nullptr) bOK = decodeSection(VBB_MESH_SECTION_TEXCOORDS, mesh.getTexCoordPointer());
+
+    // 16-bit indexes go in the front half and get widened from the back, so nothing is overwritten before it's read
+    uint32_t* pDest = mesh.getIndexPointer();
+    if (bOK) bOK = decodeSection(VBB_MESH_SECTION_INDEXES, pDest);
+    if (bOK && pIndexes->format == VK_FORMAT_R16_UINT) {
+        const unsigned char* pSource = reinterpret_cast<const unsigned char*>(pDest);
+        for (uint32_t i = indexCount; i-- > 0;) {
+            uint16_t index;
+            memcpy(&index, pSource + i * sizeof(uint16_t), sizeof(uint16_t));
+            pDest[i] = (bStrips && index == 0xFFFF) ? VBB_PRIMITIVE_RESTART_INDEX : index;
+        }
+    }
+
+    if (!bOK) {
+        mesh.allocateMesh(0, 0);
+        return false;
+    }
+
+    // Don't trust the file to have sane indexes
+    for (uint32_t i = 0; i < indexCount; i++)
+        if (pDest[i] >= vertexCount && !(bStrips && pDest[i] == VBB_PRIMITIVE_RESTART_INDEX)) {
+            mesh.allocateMesh(0, 0);
+            return false;
+        }
+
+    // Bounds were worked out when the file was saved
+    for (int k = 0; k < 3; k++) {
+        mesh.m_boundingBox.min[k] = m_pHeader->boundsMin[k];
+        mesh.m_boundingBox.max[k] = m_pHeader->boundsMax[k];
+        mesh.m_boundingSphere.center[k] = m_pHeader->sphereCenter[k];
+    }
+    mesh.m_boundingSphere.radius = m_pHeader->sphereRadius;
+    mesh.m_boundsValid = true;
+
+    return true;
+}
+
+// *********************************************************************************************************
+// The whole file is put together in memory and written in one go. Bounds come from the mesh.
+bool VBBMeshFile::save(const char* szFileName, VBBSimpleIndexedMesh& mesh, bool bCompress) {
+    if (szFileName == nullptr) return false;
+
+    uint32_t vertexCount = mesh.getAttributeCount();
+    uint32_t indexCount = mesh.getIndexCount();
+
+    struct SectionSource {
+        VBBMeshSectionType type;
+        VkFormat format;
+        uint32_t stride;
+        const void* pData;
+    };
+
+    SectionSource sources[4];
+    uint32_t sectionCount = 0;
+
+    bool bShortIndexes = (mesh.getIndexType() == VK_INDEX_TYPE_UINT16);
+    sources[sectionCount++] = {VBB_MESH_SECTION_INDEXES, bShortIndexes ? VK_FORMAT_R16_UINT : VK_FORMAT_R32_UINT,
+                               bShortIndexes ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t)), mesh.getIndexData()};
+    sources[sectionCount++] = {VBB_MESH_SECTION_POSITIONS, VK_FORMAT_R32G32B32_SFLOAT,
+                               uint32_t(sizeof(VBBSimpleIndexedMesh::VBBSimpleVertex)), mesh.m_vertices.data()};
+    if (mesh.hasNormals())
+        sources[sectionCount++] = {VBB_MESH_SECTION_NORMALS, VK_FORMAT_R32G32B32_SFLOAT,
+                                   uint32_t(sizeof(VBBSimpleIndexedMesh::VBBSimpleNormal)), mesh.getNormalPointer()};
+    if (mesh.hasTexCoords())
+        sources[sectionCount++] = {VBB_MESH_SECTION_TEXCOORDS, VK_FORMAT_R32G32_SFLOAT,
+                                   uint32_t(sizeof(VBBSimpleIndexedMesh::VBBSimpleTexCoord)), mesh.getTexCoordPointer()};
+
+    // Lay it out
+    VBBMeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = VBB_MESH_FILE_MAGIC;
+    header.version = VBB_MESH_FILE_VERSION;
+    header.headerSize = sizeof(VBBMeshFileHeader);
+    header.sectionCount = sectionCount;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    if (mesh.getTopology() == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP) header.flags |= VBB_MESH_FILE_FLAG_TRIANGLE_STRIP;
+    if (bCompress) header.flags |= VBB_MESH_FILE_FLAG_COMPRESSED;
+
+    VBBMeshFileSection sections[4];
+    std::vector<unsigned char> encoded[4];  // Only when compressing
+    memset(sections, 0, sizeof(sections));
+    uint64_t offset = sizeof(VBBMeshFileHeader) + sectionCount * sizeof(VBBMeshFileSection);
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        uint32_t count = (sources[i].type == VBB_MESH_SECTION_INDEXES) ? indexCount : vertexCount;
+        offset = vbbAlignUp(offset, VBB_MESH_FILE_ALIGNMENT);
+        sections[i].type = sources[i].type;
+        sections[i].format = sources[i].format;
+        sections[i].stride = sources[i].stride;
+        sections[i].count = count;
+        sections[i].offset = offset;
+        sections[i].size = uint64_t(count) * sources[i].stride;
+
+        if (bCompress) {
+            encodeStream(sources[i].pData, count, sources[i].stride, encoded[i]);
+            sources[i].pData = encoded[i].data();
+            sections[i].size = encoded[i].size();
+        }
+        offset += sections[i].size;
+    }
+    header.fileSize = vbbAlignUp(offset, VBB_MESH_FILE_ALIGNMENT);
+
+    // Bounds. Not getVertexPointer() above, that would throw away the ones the mesh has.
+    const VBBBoundingBox& box = mesh.getBoundingBox();
+    const VBBBoundingSphere& sphere = mesh.getBoundingSphere();
+    for (int k = 0; k < 3; k++) {
+        header.boundsMin[k] = box.min[k];
+        header.boundsMax[k] = box.max[k];
+        header.sphereCenter[k] = sphere.center[k];
+    }
+    header.sphereRadius = sphere.radius;
+
+    // Checksum the pieces where they are, then write them out. Nothing gets copied into one big
+    // buffer first. Padding is zero so the checksum is repeatable, and so is the header's checksum
+    // field while it's being computed.
+    static const unsigned char zeros[VBB_MESH_FILE_ALIGNMENT] = {0};
+    uint64_t padding[4];
+    uint64_t tableEnd = sizeof(VBBMeshFileHeader) + sectionCount * sizeof(VBBMeshFileSection);
+    for (uint32_t i = 0; i < sectionCount; i++)
+        padding[i] = sections[i].offset - ((i == 0) ? tableEnd : sections[i - 1].offset + sections[i - 1].size);
+    uint64_t tailPadding = header.fileSize - offset;
+
+    uint32_t checksum = crc32(&header, sizeof(header));
+    checksum = crc32(sections, sectionCount * sizeof(VBBMeshFileSection), checksum);
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        checksum = crc32(zeros, static_cast<size_t>(padding[i]), checksum);
+        checksum = crc32(sources[i].pData, static_cast<size_t>(sections[i].size), checksum);
+    }
+    header.checksum = crc32(zeros, static_cast<size_t>(tailPadding), checksum);
+
+    FILE* pFile = fopen(szFileName, "wb");
+    if (pFile == nullptr) return false;
+
+    bool bWritten = (fwrite(&header, sizeof(header), 1, pFile) == 1) &&
+                    (fwrite(sections, sizeof(VBBMeshFileSection), sectionCount, pFile) == sectionCount);
+    for (uint32_t i = 0; bWritten && i < sectionCount; i++) {
+        size_t size = static_cast<size_t>(sections[i].size);
+        bWritten = (fwrite(zeros, 1, static_cast<size_t>(padding[i]), pFile) == padding[i]) &&
+                   (size == 0 || fwrite(sources[i].pData, 1, size, pFile) == size);
+    }
+    if (bWritten) bWritten = (fwrite(zeros, 1, static_cast<size_t>(tailPadding), pFile) == tailPadding);
+
+    if (fclose(pFile) != 0) bWritten = false;
+
+    return bWritten;
+}
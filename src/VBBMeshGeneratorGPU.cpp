@@ -0,0 +1,420 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMeshGeneratorGPU.h"
+#include "VBBBufferDynamic.h"
+#include "VBBSingleShotCommand.h"
+#include "VBBShaderModule.h"
+
+#include <string.h>
+#include <math.h>
+
+static const double VBB_PI = 3.14159265358979323846;
+
+const char* VBBMeshGeneratorShaderSrc = R"(#version 450
+// One invocation per vertex of the grid, x is the column and y the row. Each vertex also writes
+// the indexes for the quad (or the piece of strip) that starts at it.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(std430, set = 0, binding = 0) writeonly buffer Vertices { float vertices[]; };  // Position, normal, texcoord
+layout(std430, set = 0, binding = 1) writeonly buffer Indexes { uint indexes[]; };
+
+layout(push_constant) uniform PC {
+    uint shape;     // 0 torus, 1 sphere, 2 cylinder, 3 disk
+    uint columns;
+    uint rows;
+    uint flags;     // 1 strips, 2 split quads on the ad diagonal, 4 the last column is the first again
+    vec4 params0;   // See VBBMeshGeneratorGPU::make*()
+    vec4 params1;
+} pc;
+
+void main(void) {
+    uint j = gl_GlobalInvocationID.x;
+    uint i = gl_GlobalInvocationID.y;
+    if (j > pc.columns || i > pc.rows) return;
+
+    float fi = float(i);
+    float fj = float(j);
+    float angle = ((pc.flags & 4u) != 0u && j == pc.columns) ? 0.0 : fj * pc.params0.z;  // Seams line up exactly
+    vec3 position;
+    vec3 normal;
+    vec2 texCoord;
+
+    if (pc.shape == 0u) {
+        float a = (i == pc.rows) ? 0.0 : fi * pc.params0.z;
+        float b = (j == pc.columns) ? 0.0 : fj * pc.params0.w;
+        float x = cos(a);
+        float y = sin(a);
+        float c = cos(b);
+        float sb = sin(b);
+        float r = pc.params0.y * c + pc.params0.x;
+        position = vec3(x * r, y * r, pc.params0.y * sb);
+        normal = vec3(x * c, y * c, sb);
+        texCoord = vec2(fi / float(pc.rows), fj / float(pc.columns));
+    } else if (pc.shape == 1u) {
+        float rho = fi * pc.params0.y;
+        float srho = sin(rho);
+        normal = vec3(-sin(angle) * srho, cos(angle) * srho, cos(rho));
+        position = normal * pc.params0.x;
+        texCoord = vec2(fj / float(pc.columns), 1.0 - fi / float(pc.rows));
+    } else if (pc.shape == 2u) {
+        float radius = pc.params0.x + pc.params0.y * fi;
+        float c = cos(angle);
+        float s = sin(angle);
+        position = vec3(c * radius, s * radius, fi * pc.params0.w);
+        normal = vec3(c * pc.params1.x, s * pc.params1.x, pc.params1.y);
+        texCoord = vec2(fj / float(pc.columns), fi / float(pc.rows));
+    } else {
+        float radius = pc.params0.x + fi * pc.params0.y;
+        float x = cos(angle) * radius;
+        float y = sin(angle) * radius;
+        position = vec3(x, y, 0.0);
+        normal = vec3(0.0, 0.0, 1.0);
+        texCoord = (vec2(x, y) * pc.params0.w + 1.0) * 0.5;
+    }
+
+    uint rowWidth = pc.columns + 1u;
+    uint a = i * rowWidth + j;
+    uint v = a * 8u;
+    vertices[v + 0u] = position.x;
+    vertices[v + 1u] = position.y;
+    vertices[v + 2u] = position.z;
+    vertices[v + 3u] = normal.x;
+    vertices[v + 4u] = normal.y;
+    vertices[v + 5u] = normal.z;
+    vertices[v + 6u] = texCoord.x;
+    vertices[v + 7u] = texCoord.y;
+
+    if (i == pc.rows) return;
+
+    bool bDiagonalAD = (pc.flags & 2u) != 0u;
+    uint b = a + rowWidth;
+
+    if ((pc.flags & 1u) != 0u) {
+        uint s = i * (2u * rowWidth + 1u) + 2u * j;
+        indexes[s] = bDiagonalAD ? b : a;
+        indexes[s + 1u] = bDiagonalAD ? a : b;
+        if (j == pc.columns && i + 1u < pc.rows) indexes[s + 2u] = 0xFFFFFFFFu;
+        return;
+    }
+
+    if (j == pc.columns) return;
+
+    uint c = a + 1u;
+    uint d = b + 1u;
+    uint q = (i * pc.columns + j) * 6u;
+    if (bDiagonalAD) {
+        indexes[q + 0u] = b;
+        indexes[q + 1u] = a;
+        indexes[q + 2u] = d;
+        indexes[q + 3u] = a;
+        indexes[q + 4u] = c;
+        indexes[q + 5u] = d;
+    } else {
+        indexes[q + 0u] = a;
+        indexes[q + 1u] = b;
+        indexes[q + 2u] = c;
+        indexes[q + 3u] = b;
+        indexes[q + 4u] = d;
+        indexes[q + 5u] = c;
+    }
+}
+)";
+
+// Push constants for the generator shader
+struct VBBMeshGeneratorConstants {
+    uint32_t shape;
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t flags;
+    float params[8];
+};
+
+#define VBB_GENERATOR_TORUS 0
+#define VBB_GENERATOR_SPHERE 1
+#define VBB_GENERATOR_CYLINDER 2
+#define VBB_GENERATOR_DISK 3
+
+#define VBB_GENERATOR_FLAG_STRIPS 1
+#define VBB_GENERATOR_FLAG_DIAGONAL_AD 2
+#define VBB_GENERATOR_FLAG_WRAP 4
+
+// *********************************************************************************************************
+VBBMeshGeneratorGPU::~VBBMeshGeneratorGPU(void) {
+    delete m_pVertexBuffer;
+    delete m_pIndexBuffer;
+}
+
+// *********************************************************************************************************
+// The buffers are made big enough once, every shape after that is just a dispatch
+VkResult VBBMeshGeneratorGPU::init(VBBDevice* pLogicalDevice, uint32_t maxVertices, uint32_t maxIndexes,
+                                   VkShaderModule hGeneratorShader) {
+    if (pLogicalDevice == nullptr || maxVertices == 0 || maxIndexes == 0) return VK_ERROR_INITIALIZATION_FAILED;
+
+    m_device = pLogicalDevice->getDevice();
+    m_maxVertices = maxVertices;
+    m_maxIndexes = maxIndexes;
+
+    // Same layout the CPU meshes export with all floats
+    VBBMeshAttribute attributes[3] = {VBB_MESH_ATTRIBUTE_POSITION, VBB_MESH_ATTRIBUTE_NORMAL, VBB_MESH_ATTRIBUTE_TEXCOORD};
+    VBBSimpleIndexedMesh empty;
+    if (!empty.makeInterleavedLayout(m_layout, 3, attributes)) return VK_ERROR_INITIALIZATION_FAILED;
+
+    m_pVertexBuffer = new VBBBufferStatic(m_VMA);
+    VkResult result = m_pVertexBuffer->createBuffer(VkDeviceSize(m_layout.stride) * maxVertices);
+    if (result != VK_SUCCESS) return result;
+
+    m_pIndexBuffer = new VBBBufferStatic(m_VMA);
+    result = m_pIndexBuffer->createBuffer(VkDeviceSize(sizeof(uint32_t)) * maxIndexes);
+    if (result != VK_SUCCESS) return result;
+
+    // Two storage buffers, vertices and indexes out
+    result = m_descriptors.init(m_device, 1, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, VK_SHADER_STAGE_COMPUTE_BIT,
+                                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    if (result != VK_SUCCESS) return result;
+
+    VkDescriptorBufferInfo bufferInfo[2] = {};
+    bufferInfo[0].buffer = m_pVertexBuffer->getBuffer();
+    bufferInfo[0].range = VK_WHOLE_SIZE;
+    bufferInfo[1].buffer = m_pIndexBuffer->getBuffer();
+    bufferInfo[1].range = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet descriptorWrites[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = m_descriptors.getDescriptorSet();
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pBufferInfo = &bufferInfo[i];
+    }
+    vkUpdateDescriptorSets(m_device, 2, descriptorWrites, 0, nullptr);
+
+    m_descriptorLayout = m_descriptors.getLayout();
+    m_pipeline.setDescriptorSetLayouts(1, &m_descriptorLayout);
+
+    m_pushConstant.offset = 0;
+    m_pushConstant.size = sizeof(VBBMeshGeneratorConstants);
+    m_pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    m_pipeline.setPushConstants(1, &m_pushConstant);
+
+    return m_pipeline.createPipeline(m_device, hGeneratorShader);
+}
+
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+// *********************************************************************************************************
+// Compile the stock generator shader and use that
+VkResult VBBMeshGeneratorGPU::init(VBBDevice* pLogicalDevice, uint32_t maxVertices, uint32_t maxIndexes) {
+    if (pLogicalDevice == nullptr) return VK_ERROR_INITIALIZATION_FAILED;
+
+    VBBShaderModule generatorShader;
+    VkResult result =
+        generatorShader.loadGLSLANGSrc(pLogicalDevice->getDevice(), VBBMeshGeneratorShaderSrc, shaderc_glsl_compute_shader);
+    if (result != VK_SUCCESS) return result;
+
+    return init(pLogicalDevice, maxVertices, maxIndexes, generatorShader.getShaderModule());
+}
+#endif
+
+// *********************************************************************************************************
+// Same counts as the grid generators in VBBUtils.cpp
+void VBBMeshGeneratorGPU::getGridSize(uint32_t columns, uint32_t rows, bool bStrips, uint32_t& vertexCount, uint32_t& indexCount) {
+    vertexCount = (columns + 1) * (rows + 1);
+    indexCount = bStrips ? rows * (2 * (columns + 1) + 1) - 1 : columns * rows * 6;
+}
+
+// *********************************************************************************************************
+// The steps are worked out here in double, like the CPU generators, and the shader only multiplies
+bool VBBMeshGeneratorGPU::makeTorus(VkCommandBuffer cmdBuffer, float majorRadius, float minorRadius, uint32_t numMajor,
+                                    uint32_t numMinor, bool bStrips) {
+    if (numMajor == 0 || numMinor == 0) return false;
+
+    float params[8] = {};
+    params[0] = majorRadius;
+    params[1] = minorRadius;
+    params[2] = float(2.0 * VBB_PI / double(numMajor));
+    params[3] = float(2.0 * VBB_PI / double(numMinor));
+
+    return dispatch(cmdBuffer, VBB_GENERATOR_TORUS, numMinor, numMajor, bStrips ? VBB_GENERATOR_FLAG_STRIPS : 0, params);
+}
+
+// *********************************************************************************************************
+bool VBBMeshGeneratorGPU::makeSphere(VkCommandBuffer cmdBuffer, float radius, uint32_t iSlices, uint32_t iStacks, bool bStrips) {
+    if (iSlices == 0 || iStacks == 0) return false;
+
+    float params[8] = {};
+    params[0] = radius;
+    params[1] = float(VBB_PI / double(iStacks));
+    params[2] = float(2.0 * VBB_PI / double(iSlices));
+
+    return dispatch(cmdBuffer, VBB_GENERATOR_SPHERE, iSlices, iStacks,
+                    VBB_GENERATOR_FLAG_WRAP | (bStrips ? VBB_GENERATOR_FLAG_STRIPS : 0), params);
+}
+
+// *********************************************************************************************************
+bool VBBMeshGeneratorGPU::makeCylinder(VkCommandBuffer cmdBuffer, float baseRadius, float topRadius, float fLength,
+                                       uint32_t numSlices, uint32_t numStacks, uint32_t degrees, bool bStrips) {
+    if (numSlices == 0 || numStacks == 0) return false;
+
+    // Normal is (cos * length, sin * length, base - top) normalized
+    double slopeLength = sqrt(double(fLength) * double(fLength) + double(baseRadius - topRadius) * double(baseRadius - topRadius));
+
+    float params[8] = {};
+    params[0] = baseRadius;
+    params[1] = float((topRadius - baseRadius) / double(numStacks));
+    params[2] = float((double(degrees) * (VBB_PI / 180.0)) / double(numSlices));
+    params[3] = float(fLength / double(numStacks));
+    params[4] = (slopeLength > 0.0) ? float(fLength / slopeLength) : 1.0f;
+    params[5] = (slopeLength > 0.0) ? float((baseRadius - topRadius) / slopeLength) : 0.0f;
+
+    uint32_t flags = VBB_GENERATOR_FLAG_DIAGONAL_AD;
+    if (degrees == 360) flags |= VBB_GENERATOR_FLAG_WRAP;
+    if (bStrips) flags |= VBB_GENERATOR_FLAG_STRIPS;
+
+    return dispatch(cmdBuffer, VBB_GENERATOR_CYLINDER, numSlices, numStacks, flags, params);
+}
+
+// *********************************************************************************************************
+bool VBBMeshGeneratorGPU::makeDisk(VkCommandBuffer cmdBuffer, float innerRadius, float outerRadius, uint32_t nSlices,
+                                   uint32_t nStacks, uint32_t degrees, bool bStrips) {
+    if (nSlices == 0 || nStacks == 0) return false;
+
+    float params[8] = {};
+    params[0] = innerRadius;
+    params[1] = float(fabs(double(outerRadius) - double(innerRadius)) / double(nStacks));
+    params[2] = float((double(degrees) * (VBB_PI / 180.0)) / double(nSlices));
+    params[3] = float(1.0 / outerRadius);
+
+    uint32_t flags = 0;
+    if (degrees == 360) flags |= VBB_GENERATOR_FLAG_WRAP;
+    if (bStrips) flags |= VBB_GENERATOR_FLAG_STRIPS;
+
+    return dispatch(cmdBuffer, VBB_GENERATOR_DISK, nSlices, nStacks, flags, params);
+}
+
+// *********************************************************************************************************
+// Whatever drew the last mesh has to be done reading before it gets overwritten, and the new one
+// has to be written before anything reads it.
+bool VBBMeshGeneratorGPU::dispatch(VkCommandBuffer cmdBuffer, uint32_t shape, uint32_t columns, uint32_t rows, uint32_t flags,
+                                   const float params[8]) {
+    if (m_pVertexBuffer == nullptr) return false;
+
+    uint32_t vertexCount, indexCount;
+    getGridSize(columns, rows, (flags & VBB_GENERATOR_FLAG_STRIPS) != 0, vertexCount, indexCount);
+    if (vertexCount > m_maxVertices || indexCount > m_maxIndexes) return false;
+
+    m_vertexCount = vertexCount;
+    m_indexCount = indexCount;
+    m_topology = (flags & VBB_GENERATOR_FLAG_STRIPS) ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VBBMeshGeneratorConstants constants;
+    constants.shape = shape;
+    constants.columns = columns;
+    constants.rows = rows;
+    constants.flags = flags;
+    memcpy(constants.params, params, sizeof(constants.params));
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 0, nullptr);
+
+    VkDescriptorSet descriptorSet = m_descriptors.getDescriptorSet();
+    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipeline());
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipelineLayout(), 0, 1, &descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(cmdBuffer, m_pipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmdBuffer, (columns + 1 + 7) / 8, (rows + 1 + 7) / 8, 1);
+
+    VkBufferMemoryBarrier barriers[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        barriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barriers[i].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[i].offset = 0;
+        barriers[i].size = VK_WHOLE_SIZE;
+    }
+    barriers[0].dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[0].buffer = m_pVertexBuffer->getBuffer();
+    barriers[1].dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[1].buffer = m_pIndexBuffer->getBuffer();
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 2, barriers, 0, nullptr);
+
+    return true;
+}
+
+// *********************************************************************************************************
+void VBBMeshGeneratorGPU::bind(VkCommandBuffer cmdBuffer, uint32_t binding) {
+    VkBuffer vertexBuffers[] = {m_pVertexBuffer->getBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(cmdBuffer, binding, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(cmdBuffer, m_pIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+// *********************************************************************************************************
+void VBBMeshGeneratorGPU::draw(VkCommandBuffer cmdBuffer, uint32_t instanceCount) {
+    if (m_indexCount == 0) return;
+
+    vkCmdDrawIndexed(cmdBuffer, m_indexCount, instanceCount, 0, 0, 0);
+}
+
+// *********************************************************************************************************
+// Copy both buffers down through one host visible buffer and unpack the vertices
+bool VBBMeshGeneratorGPU::readback(VBBDevice* pLogicalDevice, VBBSimpleIndexedMesh& mesh) {
+    if (pLogicalDevice == nullptr || m_indexCount == 0) return false;
+
+    VkDeviceSize vertexSize = VkDeviceSize(m_layout.stride) * m_vertexCount;
+    VkDeviceSize indexSize = VkDeviceSize(sizeof(uint32_t)) * m_indexCount;
+
+    VBBBufferDynamic temp(m_VMA);
+    if (temp.createBuffer(vertexSize + indexSize) != VK_SUCCESS) return false;
+
+    VkBufferCopy copyRegions[2] = {};
+    copyRegions[0].size = vertexSize;
+    copyRegions[1].dstOffset = vertexSize;
+    copyRegions[1].size = indexSize;
+
+    VBBSingleShotCommand singleShot(pLogicalDevice->getDevice(), pLogicalDevice->getCommandPool(), pLogicalDevice->getQueue());
+    VkCommandBuffer cmdBuffer = singleShot.start();
+    vkCmdCopyBuffer(cmdBuffer, m_pVertexBuffer->getBuffer(), temp.getBuffer(), 1, &copyRegions[0]);
+    vkCmdCopyBuffer(cmdBuffer, m_pIndexBuffer->getBuffer(), temp.getBuffer(), 1, &copyRegions[1]);
+    singleShot.end();
+
+    const unsigned char* pData = static_cast<const unsigned char*>(temp.mapMemory());
+    mesh.allocateMesh(m_vertexCount, m_indexCount);
+    mesh.setTopology(m_topology);
+
+    VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = mesh.getVertexPointer();
+    VBBSimpleIndexedMesh::VBBSimpleNormal* pNormals = mesh.getNormalPointer();
+    VBBSimpleIndexedMesh::VBBSimpleTexCoord* pTexCoords = mesh.getTexCoordPointer();
+    for (uint32_t i = 0; i < m_vertexCount; i++) {
+        const unsigned char* pVertex = pData + VkDeviceSize(m_layout.stride) * i;
+        memcpy(&pVertices[i], pVertex + m_layout.offsets[0], sizeof(VBBSimpleIndexedMesh::VBBSimpleVertex));
+        memcpy(&pNormals[i], pVertex + m_layout.offsets[1], sizeof(VBBSimpleIndexedMesh::VBBSimpleNormal));
+        memcpy(&pTexCoords[i], pVertex + m_layout.offsets[2], sizeof(VBBSimpleIndexedMesh::VBBSimpleTexCoord));
+    }
+    memcpy(mesh.getIndexPointer(), pData + vertexSize, indexSize);
+
+    temp.unmapMemory();
+    return true;
+}
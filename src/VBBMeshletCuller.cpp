@@ -0,0 +1,254 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMeshletCuller.h"
+#include "VBBShaderModule.h"
+
+#include <string.h>
+#include <math.h>
+
+const char* VBBMeshletCullShaderSrc = R"(#version 450
+// One invocation per meshlet. Writes a draw for every meshlet, culled ones get no instances.
+layout(local_size_x = 64) in;
+
+struct Meshlet {
+    vec4 sphere;    // Center, radius
+    vec4 cone;      // Axis, cutoff
+    uint firstIndex;
+    uint indexCount;
+    uint vertexCount;
+    uint reserved;
+};
+
+struct DrawCommand {    // VkDrawIndexedIndirectCommand
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Meshlets { Meshlet meshlets[]; };
+layout(std430, set = 0, binding = 1) writeonly buffer Draws { DrawCommand draws[]; };
+
+layout(push_constant) uniform PC {
+    vec4 planes[6];         // Model space frustum
+    vec3 cameraPosition;    // Model space
+    uint meshletCount;
+} pc;
+
+void main(void) {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= pc.meshletCount) return;
+
+    vec4 sphere = meshlets[i].sphere;
+    vec4 cone = meshlets[i].cone;
+
+    bool visible = true;
+    for (int p = 0; p < 6; p++)
+        if (dot(pc.planes[p].xyz, sphere.xyz) + pc.planes[p].w < -sphere.w) visible = false;
+
+    vec3 v = sphere.xyz - pc.cameraPosition;
+    if (dot(v, cone.xyz) > cone.w * length(v) + sphere.w) visible = false;
+
+    draws[i].indexCount = meshlets[i].indexCount;
+    draws[i].instanceCount = visible ? 1 : 0;
+    draws[i].firstIndex = meshlets[i].firstIndex;
+    draws[i].vertexOffset = 0;
+    draws[i].firstInstance = 0;
+}
+)";
+
+// Push constants for the cull shader
+struct VBBMeshletCullConstants {
+    float planes[24];
+    float cameraPosition[3];
+    uint32_t meshletCount;
+};
+
+// *********************************************************************************************************
+VBBMeshletCuller::~VBBMeshletCuller(void) {
+    delete m_pMeshletBuffer;
+    delete m_pDrawBuffer;
+    delete m_pUnculledBuffer;
+
+    if (m_queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+}
+
+// *********************************************************************************************************
+// Meshlets go up once. The draws start out with everything visible so draw() works before the first cull().
+VkResult VBBMeshletCuller::init(VBBDevice* pLogicalDevice, const VBBMeshlet* pMeshlets, uint32_t meshletCount,
+                                VkShaderModule hCullShader) {
+    if (pLogicalDevice == nullptr || pMeshlets == nullptr || meshletCount == 0) return VK_ERROR_INITIALIZATION_FAILED;
+
+    m_device = pLogicalDevice->getDevice();
+    m_meshletCount = meshletCount;
+
+    const VkPhysicalDeviceFeatures& features = pLogicalDevice->getEnabledFeatures();
+    m_bMultiDrawIndirect = (features.multiDrawIndirect == VK_TRUE);
+
+    m_pMeshletBuffer = new VBBBufferStatic(m_VMA);
+    VkResult result = m_pMeshletBuffer->createBuffer((void*)pMeshlets, sizeof(VBBMeshlet) * meshletCount, pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    std::vector<VkDrawIndexedIndirectCommand> draws(meshletCount);
+    for (uint32_t i = 0; i < meshletCount; i++) {
+        draws[i].indexCount = pMeshlets[i].indexCount;
+        draws[i].instanceCount = 1;
+        draws[i].firstIndex = pMeshlets[i].firstIndex;
+        draws[i].vertexOffset = 0;
+        draws[i].firstInstance = 0;
+    }
+
+    m_pDrawBuffer = new VBBBufferStatic(m_VMA);
+    result = m_pDrawBuffer->createBuffer(draws.data(), sizeof(VkDrawIndexedIndirectCommand) * meshletCount, pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    m_pUnculledBuffer = new VBBBufferStatic(m_VMA);
+    result = m_pUnculledBuffer->createBuffer(draws.data(), sizeof(VkDrawIndexedIndirectCommand) * meshletCount, pLogicalDevice);
+    if (result != VK_SUCCESS) return result;
+
+    // Nothing to count with, but the culling still works
+    if (features.pipelineStatisticsQuery == VK_TRUE) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryInfo.queryCount = 2;
+        queryInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT;
+        result = vkCreateQueryPool(m_device, &queryInfo, nullptr, &m_queryPool);
+        if (result != VK_SUCCESS) return result;
+    }
+
+    // Two storage buffers, meshlets in and draws out
+    result = m_descriptors.init(m_device, 1, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, VK_SHADER_STAGE_COMPUTE_BIT,
+                                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    if (result != VK_SUCCESS) return result;
+
+    VkDescriptorBufferInfo bufferInfo[2] = {};
+    bufferInfo[0].buffer = m_pMeshletBuffer->getBuffer();
+    bufferInfo[0].range = VK_WHOLE_SIZE;
+    bufferInfo[1].buffer = m_pDrawBuffer->getBuffer();
+    bufferInfo[1].range = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet descriptorWrites[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = m_descriptors.getDescriptorSet();
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pBufferInfo = &bufferInfo[i];
+    }
+    vkUpdateDescriptorSets(m_device, 2, descriptorWrites, 0, nullptr);
+
+    m_descriptorLayout = m_descriptors.getLayout();
+    m_pipeline.setDescriptorSetLayouts(1, &m_descriptorLayout);
+
+    m_pushConstant.offset = 0;
+    m_pushConstant.size = sizeof(VBBMeshletCullConstants);
+    m_pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    m_pipeline.setPushConstants(1, &m_pushConstant);
+
+    return m_pipeline.createPipeline(m_device, hCullShader);
+}
+
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+// *********************************************************************************************************
+// Compile the stock cull shader and use that
+VkResult VBBMeshletCuller::init(VBBDevice* pLogicalDevice, const VBBMeshlet* pMeshlets, uint32_t meshletCount) {
+    if (pLogicalDevice == nullptr) return VK_ERROR_INITIALIZATION_FAILED;
+
+    VBBShaderModule cullShader;
+    VkResult result = cullShader.loadGLSLANGSrc(pLogicalDevice->getDevice(), VBBMeshletCullShaderSrc, shaderc_glsl_compute_shader);
+    if (result != VK_SUCCESS) return result;
+
+    return init(pLogicalDevice, pMeshlets, meshletCount, cullShader.getShaderModule());
+}
+#endif
+
+// *********************************************************************************************************
+void VBBMeshletCuller::cull(VkCommandBuffer cmdBuffer, const float mvp[16], const float cameraPosition[3]) {
+    VBBMeshletCullConstants constants;
+    vbbExtractFrustumPlanes(mvp, constants.planes);
+    memcpy(constants.cameraPosition, cameraPosition, sizeof(float) * 3);
+    constants.meshletCount = m_meshletCount;
+
+    // Last frame's indirect draws may still be reading the buffer this writes
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 0, nullptr);
+
+    // Has to be outside the render pass too
+    if (m_queryPool != VK_NULL_HANDLE) vkCmdResetQueryPool(cmdBuffer, m_queryPool, 0, 2);
+
+    VkDescriptorSet descriptorSet = m_descriptors.getDescriptorSet();
+    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipeline());
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipelineLayout(), 0, 1, &descriptorSet, 0,
+                            nullptr);
+    vkCmdPushConstants(cmdBuffer, m_pipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmdBuffer, (m_meshletCount + 63) / 64, 1, 1);
+
+    // Draws are read by the indirect draw
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = m_pDrawBuffer->getBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1,
+                         &barrier, 0, nullptr);
+}
+
+// *********************************************************************************************************
+// Without multiDrawIndirect each indirect draw can only be one command
+void VBBMeshletCuller::draw(VkCommandBuffer cmdBuffer, bool bCulled) {
+    VkBuffer drawBuffer = bCulled ? m_pDrawBuffer->getBuffer() : m_pUnculledBuffer->getBuffer();
+    uint32_t query = bCulled ? 0 : 1;
+    if (m_queryPool != VK_NULL_HANDLE) vkCmdBeginQuery(cmdBuffer, m_queryPool, query, 0);
+
+    if (m_bMultiDrawIndirect)
+        vkCmdDrawIndexedIndirect(cmdBuffer, drawBuffer, 0, m_meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+    else
+        for (uint32_t i = 0; i < m_meshletCount; i++)
+            vkCmdDrawIndexedIndirect(cmdBuffer, drawBuffer, i * sizeof(VkDrawIndexedIndirectCommand), 1,
+                                     sizeof(VkDrawIndexedIndirectCommand));
+
+    if (m_queryPool != VK_NULL_HANDLE) vkCmdEndQuery(cmdBuffer, m_queryPool, query);
+}
+
+// *********************************************************************************************************
+// Doesn't wait, call it once the frame's fence has signaled
+bool VBBMeshletCuller::getVertexInvocations(uint64_t& culled, uint64_t& unculled) {
+    if (m_queryPool == VK_NULL_HANDLE) return false;
+
+    uint64_t counts[2];
+    if (vkGetQueryPoolResults(m_device, m_queryPool, 0, 2, sizeof(counts), counts, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) !=
+        VK_SUCCESS)
+        return false;
+
+    culled = counts[0];
+    unculled = counts[1];
+    return true;
+}
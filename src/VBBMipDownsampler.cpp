@@ -0,0 +1,260 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBMipDownsampler.h"
+#include "VBBShaderModule.h"
+
+const char* VBBMipDownsampleShaderSrc = R"(#version 450
+// One invocation per texel of the level being made, from the four under it in the level before.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1) writeonly uniform image2D dest;
+
+layout(push_constant) uniform PC {
+    ivec2 sourceSize;
+    ivec2 destSize;
+} pc;
+
+void main(void) {
+    ivec2 d = ivec2(gl_GlobalInvocationID.xy);
+    if (d.x >= pc.destSize.x || d.y >= pc.destSize.y) return;
+
+    // The last row and column of an odd size take in the one left over, so it's up to 3x3
+    ivec2 s0 = d * 2;
+    ivec2 s1 = min(s0 + 1 + ivec2(equal(d, pc.destSize - 1)) * (pc.sourceSize & 1), pc.sourceSize - 1);
+    vec4 sum = vec4(0.0);
+    for (int y = s0.y; y <= s1.y; y++)
+        for (int x = s0.x; x <= s1.x; x++) sum += texelFetch(source, ivec2(x, y), 0);
+    imageStore(dest, d, sum / float((s1.x - s0.x + 1) * (s1.y - s0.y + 1)));
+}
+)";
+
+// Push constants for the downsample shader
+struct VBBMipDownsampleConstants {
+    int32_t sourceSize[2];
+    int32_t destSize[2];
+};
+
+// *********************************************************************************************************
+VBBMipDownsampler::~VBBMipDownsampler(void) {
+    release();
+    if (m_sampler != VK_NULL_HANDLE) vkDestroySampler(m_device, m_sampler, nullptr);
+}
+
+// *********************************************************************************************************
+// The source level is read with texelFetch(), so the sampler doesn't filter anything
+VkResult VBBMipDownsampler::init(VBBDevice* pLogicalDevice, VkShaderModule hDownsampleShader) {
+    if (pLogicalDevice == nullptr) return VK_ERROR_INITIALIZATION_FAILED;
+
+    m_device = pLogicalDevice->getDevice();
+    m_physicalDevice = pLogicalDevice->getPhysicalDeviceHandle();
+
+    m_bWriteWithoutFormat = (pLogicalDevice->getEnabledFeatures().shaderStorageImageWriteWithoutFormat == VK_TRUE);
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    VkResult result = vkCreateSampler(m_device, &samplerInfo, nullptr, &m_sampler);
+    if (result != VK_SUCCESS) return result;
+
+    // The level before, and the level being made
+    result = m_descriptors.init(m_device, 1, 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, VK_SHADER_STAGE_COMPUTE_BIT,
+                                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    if (result != VK_SUCCESS) return result;
+
+    m_descriptorLayout = m_descriptors.getLayout();
+    m_pipeline.setDescriptorSetLayouts(1, &m_descriptorLayout);
+
+    m_pushConstant.offset = 0;
+    m_pushConstant.size = sizeof(VBBMipDownsampleConstants);
+    m_pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    m_pipeline.setPushConstants(1, &m_pushConstant);
+
+    return m_pipeline.createPipeline(m_device, hDownsampleShader);
+}
+
+#ifdef VBB_USE_SHADER_TOOLCHAIN
+// *********************************************************************************************************
+// Compile the stock downsample shader and use that
+VkResult VBBMipDownsampler::init(VBBDevice* pLogicalDevice) {
+    if (pLogicalDevice == nullptr) return VK_ERROR_INITIALIZATION_FAILED;
+
+    VBBShaderModule downsampleShader;
+    VkResult result =
+        downsampleShader.loadGLSLANGSrc(pLogicalDevice->getDevice(), VBBMipDownsampleShaderSrc, shaderc_glsl_compute_shader);
+    if (result != VK_SUCCESS) return result;
+
+    return init(pLogicalDevice, downsampleShader.getShaderModule());
+}
+#endif
+
+// *********************************************************************************************************
+bool VBBMipDownsampler::isFormatSupported(VkFormat format, VkImageTiling tiling) {
+    if (m_pipeline.getPipeline() == VK_NULL_HANDLE || !m_bWriteWithoutFormat) return false;
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &properties);
+    VkFormatFeatureFlags supported = (tiling == VK_IMAGE_TILING_OPTIMAL) ? properties.optimalTilingFeatures : properties.linearTilingFeatures;
+    VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    return (supported & needed) == needed;
+}
+
+// *********************************************************************************************************
+void VBBMipDownsampler::barrier(VkCommandBuffer cmdBuffer, VkImage image, uint32_t baseLevel, uint32_t levelCount,
+                                VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmdBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// *********************************************************************************************************
+// One view per level, each one is written as storage and then read (sampled) to make the next.
+// Levels are made one after another with a barrier between each.
+VkResult VBBMipDownsampler::record(VkCommandBuffer cmdBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height,
+                                   uint32_t levels, VkImageLayout finalLayout) {
+    if (m_pipeline.getPipeline() == VK_NULL_HANDLE || levels < 2) return VK_ERROR_INITIALIZATION_FAILED;
+
+    size_t firstView = m_views.size();
+    for (uint32_t m = 0; m < levels; m++) {
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = m;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView view = VK_NULL_HANDLE;
+        VkResult result = vkCreateImageView(m_device, &viewInfo, nullptr, &view);
+        if (result != VK_SUCCESS) return result;
+        m_views.push_back(view);
+    }
+
+    VkDescriptorPoolSize poolSizes[2] = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levels - 1},
+                                         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels - 1}};
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = levels - 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &pool);
+    if (result != VK_SUCCESS) return result;
+    m_pools.push_back(pool);
+
+    std::vector<VkDescriptorSetLayout> layouts(levels - 1, m_descriptorLayout);
+    std::vector<VkDescriptorSet> sets(levels - 1);
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = levels - 1;
+    allocInfo.pSetLayouts = layouts.data();
+    result = vkAllocateDescriptorSets(m_device, &allocInfo, sets.data());
+    if (result != VK_SUCCESS) return result;
+
+    for (uint32_t m = 1; m < levels; m++) {
+        VkDescriptorImageInfo imageInfo[2] = {};
+        imageInfo[0].sampler = m_sampler;
+        imageInfo[0].imageView = m_views[firstView + m - 1];
+        imageInfo[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo[1].imageView = m_views[firstView + m];
+        imageInfo[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet descriptorWrites[2] = {};
+        for (uint32_t i = 0; i < 2; i++) {
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = sets[m - 1];
+            descriptorWrites[i].dstBinding = i;
+            descriptorWrites[i].descriptorType = (i == 0) ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pImageInfo = &imageInfo[i];
+        }
+        vkUpdateDescriptorSets(m_device, 2, descriptorWrites, 0, nullptr);
+    }
+
+    // Level 0 was just copied in, the rest are about to be written
+    barrier(cmdBuffer, image, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    barrier(cmdBuffer, image, 1, levels - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipeline());
+
+    VBBMipDownsampleConstants constants;
+    for (uint32_t m = 1; m < levels; m++) {
+        constants.sourceSize[0] = int32_t(width);
+        constants.sourceSize[1] = int32_t(height);
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+        constants.destSize[0] = int32_t(width);
+        constants.destSize[1] = int32_t(height);
+
+        vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline.getPipelineLayout(), 0, 1, &sets[m - 1], 0,
+                                nullptr);
+        vkCmdPushConstants(cmdBuffer, m_pipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(cmdBuffer, (width + 7) / 8, (height + 7) / 8, 1);
+
+        barrier(cmdBuffer, image, m, 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT,
+                VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+
+    // Everything is readable by compute now, the last barrier is for whoever samples it
+    barrier(cmdBuffer, image, 0, levels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, finalLayout, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    return VK_SUCCESS;
+}
+
+// *********************************************************************************************************
+void VBBMipDownsampler::release(void) {
+    for (VkImageView view : m_views) vkDestroyImageView(m_device, view, nullptr);
+    m_views.clear();
+
+    for (VkDescriptorPool pool : m_pools) vkDestroyDescriptorPool(m_device, pool, nullptr);
+    m_pools.clear();
+}
@@ -127,6 +127,41 @@ VkResult VBBPhysicalDevices::createLogicalDevice(VBBDevice* pLogicalDevice, VkQu
     // What if we didn't find a queue?
     if (found == VK_FALSE) return VK_ERROR_UNKNOWN;  // We don't really have a good "Vulkan" error message for this
 
+    // And one for uploads. A family that only does transfers is best (that's the copy engine on most
+    // discrete cards), then any other family, then a second queue in the one above. It has to be able
+    // to copy images of any size. Failing all that, uploads share the primary queue.
+    const float queuePriorities[2] = {1.0f, 1.0f};
+    VkDeviceQueueCreateInfo queueCreateInfos[2] = {queueCreateInfo, queueCreateInfo};
+    uint32_t queueCreateCount = 1;
+    uint32_t transferFamily = queueCreateInfo.queueFamilyIndex;
+    uint32_t transferIndex = 0;
+    int otherFamily = -1;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_deviceQueueFamilyProperties.size()); i++) {
+        const VkQueueFamilyProperties& family = m_deviceQueueFamilyProperties[i];
+        VkQueueFlags copyFlags = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+        if (i == queueCreateInfo.queueFamilyIndex || !(family.queueFlags & copyFlags) || family.queueCount == 0) continue;
+        if (family.minImageTransferGranularity.width != 1 || family.minImageTransferGranularity.height != 1 ||
+            family.minImageTransferGranularity.depth != 1)
+            continue;
+
+        if (!(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            otherFamily = int(i);
+            break;
+        }
+        if (otherFamily < 0) otherFamily = int(i);
+    }
+
+    if (otherFamily >= 0) {
+        transferFamily = uint32_t(otherFamily);
+        queueCreateInfos[1].queueFamilyIndex = transferFamily;
+        queueCreateCount = 2;
+    } else if (m_deviceQueueFamilyProperties[queueCreateInfo.queueFamilyIndex].queueCount > 1) {
+        queueCreateInfos[0].queueCount = 2;
+        queueCreateInfos[0].pQueuePriorities = queuePriorities;
+        transferIndex = 1;
+    }
+    pLogicalDevice->m_transferQueueFamilyIndex = transferFamily;
+
     // Enable optional features? Etc. Etc. Etc.
     VkPhysicalDeviceFeatures2KHR physicalDeviceFeatures2 = {};
     physicalDeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -148,8 +183,8 @@ VkResult VBBPhysicalDevices::createLogicalDevice(VBBDevice* pLogicalDevice, VkQu
 
     vkGetPhysicalDeviceFeatures2(physicalDevice, &physicalDeviceFeatures2);
 
-    deviceCreateInfo.queueCreateInfoCount = 1;
-    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
+    deviceCreateInfo.queueCreateInfoCount = queueCreateCount;
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos;
     deviceCreateInfo.enabledExtensionCount = (uint32_t)pLogicalDevice->m_requiredDeviceExtensions.size();
     deviceCreateInfo.ppEnabledExtensionNames = pLogicalDevice->m_requiredDeviceExtensions.data();
     deviceCreateInfo.pEnabledFeatures = nullptr;
@@ -160,9 +195,11 @@ VkResult VBBPhysicalDevices::createLogicalDevice(VBBDevice* pLogicalDevice, VkQu
 
     // Logical device might want to know who it's daddy is.
     pLogicalDevice->m_physicalDevice = physicalDevice;
+    pLogicalDevice->m_enabledFeatures = physicalDeviceFeatures2.features;
 
     // Get the queue
     vkGetDeviceQueue(pLogicalDevice->m_logicalDevice, queueCreateInfo.queueFamilyIndex, 0, &pLogicalDevice->m_primaryQueue);
+    vkGetDeviceQueue(pLogicalDevice->m_logicalDevice, transferFamily, transferIndex, &pLogicalDevice->m_transferQueue);
 
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
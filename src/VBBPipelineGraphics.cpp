@@ -50,6 +50,43 @@ void VBBPipelineGraphics::addVertexAttributeBinding(uint32_t stride,  uint32_t o
     attributeDescriptions.push_back(attributeDesc);
 }
 
+// *******************************************************************************************
+// Add a binding with no attributes yet, returns the binding number
+uint32_t VBBPipelineGraphics::addVertexBinding(uint32_t stride, VkVertexInputRate inputRate) {
+    uint32_t binding = static_cast<uint32_t>(bindingDescriptions.size());
+
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = binding;
+    bindingDescription.stride = stride;
+    bindingDescription.inputRate = inputRate;
+    bindingDescriptions.push_back(bindingDescription);
+
+    return binding;
+}
+
+// *******************************************************************************************
+// Add an attribute to a binding that already exists
+void VBBPipelineGraphics::addVertexAttribute(uint32_t binding, uint32_t location, VkFormat format, uint32_t offset) {
+    VkVertexInputAttributeDescription attributeDesc;
+    attributeDesc.binding = binding;
+    attributeDesc.location = location;
+    attributeDesc.format = format;
+    attributeDesc.offset = offset;
+    attributeDescriptions.push_back(attributeDesc);
+}
+
+// *******************************************************************************************
+// Everything from one interleaved vertex buffer
+uint32_t VBBPipelineGraphics::addInterleavedVertexBinding(const VBBInterleavedLayout& layout, const uint32_t* pLocations,
+                                                          VkVertexInputRate inputRate) {
+    uint32_t binding = addVertexBinding(layout.stride, inputRate);
+
+    for (uint32_t i = 0; i < layout.attributeCount; i++)
+        addVertexAttribute(binding, (pLocations != nullptr) ? pLocations[i] : i, layout.formats[i], layout.offsets[i]);
+
+    return binding;
+}
+
 // *******************************************************************************************
 // The Canvas contains essential information for the pipeline
 // Shaders must be specified.
@@ -100,7 +137,7 @@ VkResult VBBPipelineGraphics::createPipeline(VBBCanvas* pCanvas, VkShaderModule
     // VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssembly.topology = m_primitiveTopology;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    inputAssembly.primitiveRestartEnable = m_primitiveRestartFlag;
 
     // VkPipelineRasterizationStateCreateInfo rasterizer{};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
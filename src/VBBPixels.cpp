@@ -0,0 +1,573 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include "VBBPixels.h"
+#include "VBBMath.h"  // For the SIMD defines
+#include "VBBUtils.h"  // vbbParallelFor()
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <thread>
+
+// *********************************************************************************************************
+// Red and blue are bytes 0 and 2 of each pixel, which are the low bytes of the two 16-bit halves.
+static inline uint32_t swapRB(uint32_t pixel) { return (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16); }
+
+void vbbSwapRB32(const void* pSource, void* pDest, size_t pixelCount) {
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    size_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    const __m128i agMask = _mm_set1_epi32(int(0xFF00FF00));
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pIn + i * 4));
+        __m128i rb = _mm_andnot_si128(agMask, v);
+        rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*)(pOut + i * 4), _mm_or_si128(_mm_and_si128(v, agMask), rb));
+    }
+#elif defined(VBB_SIMD_NEON)
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t v = vld4q_u8(pIn + i * 4);
+        uint8x16_t red = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = red;
+        vst4q_u8(pOut + i * 4, v);
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        uint32_t pixel;
+        memcpy(&pixel, pIn + i * 4, 4);
+        pixel = swapRB(pixel);
+        memcpy(pOut + i * 4, &pixel, 4);
+    }
+}
+
+// *********************************************************************************************************
+// SSE2 can't shuffle bytes, so each 3 byte pixel is loaded as 4 bytes and the extra one masked off.
+// That reads one byte past the pixel, so the last few are done one at a time.
+void vbbExpandRGB24(const void* pSource, void* pDest, size_t pixelCount, bool bSwapRB) {
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    size_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i gMask = _mm_set1_epi32(0x0000FF00);
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000));
+    for (; i + 5 <= pixelCount; i += 4) {
+        uint32_t p[4];
+        memcpy(&p[0], pIn + i * 3, 4);
+        memcpy(&p[1], pIn + i * 3 + 3, 4);
+        memcpy(&p[2], pIn + i * 3 + 6, 4);
+        memcpy(&p[3], pIn + i * 3 + 9, 4);
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), rgbMask);
+        if (bSwapRB) {
+            __m128i rb = _mm_andnot_si128(gMask, v);
+            rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_or_si128(_mm_and_si128(v, gMask), rb);
+        }
+        _mm_storeu_si128((__m128i*)(pOut + i * 4), _mm_or_si128(v, alpha));
+    }
+#elif defined(VBB_SIMD_NEON)
+    const uint8x16_t alpha = vdupq_n_u8(0xFF);
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x3_t in = vld3q_u8(pIn + i * 3);
+        uint8x16x4_t out;
+        out.val[0] = bSwapRB ? in.val[2] : in.val[0];
+        out.val[1] = in.val[1];
+        out.val[2] = bSwapRB ? in.val[0] : in.val[2];
+        out.val[3] = alpha;
+        vst4q_u8(pOut + i * 4, out);
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        const unsigned char* pPixel = pIn + i * 3;
+        unsigned char out[4] = {pPixel[bSwapRB ? 2 : 0], pPixel[1], pPixel[bSwapRB ? 0 : 2], 0xFF};
+        memcpy(pOut + i * 4, out, 4);
+    }
+}
+
+// *********************************************************************************************************
+void vbbExpandGrey8(const void* pSource, void* pDest, size_t pixelCount) {
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    size_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    // gg and ga pairs, then those interleaved make g g g a
+    const __m128i alpha = _mm_set1_epi8(char(0xFF));
+    for (; i + 16 <= pixelCount; i += 16) {
+        __m128i g = _mm_loadu_si128((const __m128i*)(pIn + i));
+        __m128i ggLow = _mm_unpacklo_epi8(g, g);
+        __m128i ggHigh = _mm_unpackhi_epi8(g, g);
+        __m128i gaLow = _mm_unpacklo_epi8(g, alpha);
+        __m128i gaHigh = _mm_unpackhi_epi8(g, alpha);
+        __m128i* pBlock = (__m128i*)(pOut + i * 4);
+        _mm_storeu_si128(pBlock + 0, _mm_unpacklo_epi16(ggLow, gaLow));
+        _mm_storeu_si128(pBlock + 1, _mm_unpackhi_epi16(ggLow, gaLow));
+        _mm_storeu_si128(pBlock + 2, _mm_unpacklo_epi16(ggHigh, gaHigh));
+        _mm_storeu_si128(pBlock + 3, _mm_unpackhi_epi16(ggHigh, gaHigh));
+    }
+#elif defined(VBB_SIMD_NEON)
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t out;
+        out.val[0] = vld1q_u8(pIn + i);
+        out.val[1] = out.val[0];
+        out.val[2] = out.val[0];
+        out.val[3] = vdupq_n_u8(0xFF);
+        vst4q_u8(pOut + i * 4, out);
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        unsigned char out[4] = {pIn[i], pIn[i], pIn[i], 0xFF};
+        memcpy(pOut + i * 4, out, 4);
+    }
+}
+
+// *********************************************************************************************************
+// color * alpha / 255, rounded. With t = c * a + 128 that's (t + (t >> 8)) >> 8, exact for every c and a.
+static inline unsigned char premultiply(unsigned char color, unsigned char alpha) {
+    uint32_t t = uint32_t(color) * alpha + 128;
+    return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+void vbbPremultiplyAlpha(const void* pSource, void* pDest, size_t pixelCount) {
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    size_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    // Two pixels per 16-bit register, alpha copied across each pixel's four words. Alpha itself is kept.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pIn + i * 4));
+        __m128i halves[2] = {_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)};
+        for (int h = 0; h < 2; h++) {
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], a), round);
+            t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            halves[h] = _mm_or_si128(_mm_andnot_si128(alphaMask, t), _mm_and_si128(alphaMask, halves[h]));
+        }
+        _mm_storeu_si128((__m128i*)(pOut + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+    }
+#elif defined(VBB_SIMD_NEON)
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t v = vld4q_u8(pIn + i * 4);
+        for (int c = 0; c < 3; c++) {
+            uint16x8_t low = vmull_u8(vget_low_u8(v.val[c]), vget_low_u8(v.val[3]));
+            uint16x8_t high = vmull_u8(vget_high_u8(v.val[c]), vget_high_u8(v.val[3]));
+            v.val[c] = vcombine_u8(vraddhn_u16(low, vrshrq_n_u16(low, 8)), vraddhn_u16(high, vrshrq_n_u16(high, 8)));
+        }
+        vst4q_u8(pOut + i * 4, v);
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        const unsigned char* pPixel = pIn + i * 4;
+        unsigned char out[4] = {premultiply(pPixel[0], pPixel[3]), premultiply(pPixel[1], pPixel[3]),
+                                premultiply(pPixel[2], pPixel[3]), pPixel[3]};
+        memcpy(pOut + i * 4, out, 4);
+    }
+}
+
+// *********************************************************************************************************
+uint32_t vbbGetPixelConversionSizes(VBBPixelConversion conversion, uint32_t* pDestSize) {
+    uint32_t sourceSize = 4;
+    if (conversion == VBB_PIXELS_RGB_TO_RGBA || conversion == VBB_PIXELS_BGR_TO_RGBA)
+        sourceSize = 3;
+    else if (conversion == VBB_PIXELS_GREY_TO_RGBA)
+        sourceSize = 1;
+
+    if (pDestSize != nullptr) *pDestSize = 4;
+    return sourceSize;
+}
+
+// *********************************************************************************************************
+// Premultiplying after a conversion is done a tile at a time through the stack, so pDest is
+// still only written once.
+void vbbConvertPixels(VBBPixelConversion conversion, const void* pSource, void* pDest, size_t pixelCount, bool bPremultiply) {
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    uint32_t sourceSize = vbbGetPixelConversionSizes(conversion);
+
+    if (bPremultiply && conversion == VBB_PIXELS_COPY) {
+        vbbPremultiplyAlpha(pIn, pOut, pixelCount);
+        return;
+    }
+
+    // Nothing to premultiply, alpha is always 255
+    if (conversion == VBB_PIXELS_RGB_TO_RGBA || conversion == VBB_PIXELS_BGR_TO_RGBA || conversion == VBB_PIXELS_GREY_TO_RGBA)
+        bPremultiply = false;
+
+    const size_t tileSize = 1024;
+    uint32_t tile[tileSize];
+    for (size_t first = 0; first < pixelCount; first += tileSize) {
+        size_t count = (pixelCount - first < tileSize) ? pixelCount - first : tileSize;
+        const unsigned char* pTileIn = pIn + first * sourceSize;
+        unsigned char* pTileOut = bPremultiply ? reinterpret_cast<unsigned char*>(tile) : pOut + first * 4;
+
+        switch (conversion) {
+            case VBB_PIXELS_COPY:
+                if (pTileOut != pTileIn) memcpy(pTileOut, pTileIn, count * 4);
+                break;
+            case VBB_PIXELS_SWAP_RB:
+                vbbSwapRB32(pTileIn, pTileOut, count);
+                break;
+            case VBB_PIXELS_RGB_TO_RGBA:
+                vbbExpandRGB24(pTileIn, pTileOut, count, false);
+                break;
+            case VBB_PIXELS_BGR_TO_RGBA:
+                vbbExpandRGB24(pTileIn, pTileOut, count, true);
+                break;
+            case VBB_PIXELS_GREY_TO_RGBA:
+                vbbExpandGrey8(pTileIn, pTileOut, count);
+                break;
+        }
+
+        if (bPremultiply) vbbPremultiplyAlpha(tile, pOut + first * 4, count);
+    }
+}
+
+// *********************************************************************************************************
+// Mip chains. Box is 2x2. Kaiser is a Kaiser windowed sinc, 8 taps across (two destination texels
+// each side of the center), done separably. Every level is made from the one before it, out of
+// scratch memory, so pDest is still only written.
+static const int kMaxMipTaps = 8;
+
+struct VBBMipTaps {
+    int count;
+    int first;  // Source texel of the first tap, relative to 2 * x
+    float weights[kMaxMipTaps];
+};
+
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+
+static void makeMipTaps(VBBMipFilter filter, VBBMipTaps& taps) {
+    if (filter == VBB_MIP_FILTER_BOX) {
+        taps.count = 2;
+        taps.first = 0;
+        taps.weights[0] = taps.weights[1] = 0.5f;
+        return;
+    }
+
+    // Distance from the center is in destination texels, half the source ones
+    const double alpha = 4.0, width = 2.0, pi = 3.14159265358979323846;
+    taps.count = kMaxMipTaps;
+    taps.first = 1 - kMaxMipTaps / 2;
+    double total = 0.0, weights[kMaxMipTaps];
+    for (int k = 0; k < kMaxMipTaps; k++) {
+        double t = (k + taps.first - 0.5) * 0.5;
+        double sinc = sin(pi * t) / (pi * t);
+        double window = besselI0(alpha * sqrt(1.0 - (t / width) * (t / width))) / besselI0(alpha);
+        weights[k] = sinc * window;
+        total += weights[k];
+    }
+
+    for (int k = 0; k < kMaxMipTaps; k++) taps.weights[k] = float(weights[k] / total);
+}
+
+// Byte to float (0 to 1), and back. sRGB goes through linear light, alpha never does. Going back
+// from linear is a 64K table, which is within a fraction of a step everywhere, even the dark end.
+struct VBBMipTables {
+    float toLinear[256];
+    float toFloat[256];
+    unsigned char fromLinear[65536];
+
+    VBBMipTables(void) {
+        for (int i = 0; i < 256; i++) {
+            double c = i / 255.0;
+            toFloat[i] = float(c);
+            toLinear[i] = float((c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+        }
+
+        for (int i = 0; i < 65536; i++) {
+            double l = i / 65535.0;
+            double c = (l <= 0.0031308) ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+            fromLinear[i] = (unsigned char)(c * 255.0 + 0.5);
+        }
+    }
+};
+
+static const VBBMipTables& getMipTables(void) {
+    static VBBMipTables tables;
+    return tables;
+}
+
+// One pixel in float, all four channels at once
+#if defined(VBB_SIMD_SSE)
+typedef __m128 VBBMipPixel;
+static inline VBBMipPixel mipZero(void) { return _mm_setzero_ps(); }
+static inline VBBMipPixel mipLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void mipStore(float* p, VBBMipPixel v) { _mm_storeu_ps(p, v); }
+static inline VBBMipPixel mipMultiplyAdd(VBBMipPixel sum, VBBMipPixel v, float w) { return _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(w))); }
+#elif defined(VBB_SIMD_NEON)
+typedef float32x4_t VBBMipPixel;
+static inline VBBMipPixel mipZero(void) { return vdupq_n_f32(0.0f); }
+static inline VBBMipPixel mipLoad(const float* p) { return vld1q_f32(p); }
+static inline void mipStore(float* p, VBBMipPixel v) { vst1q_f32(p, v); }
+static inline VBBMipPixel mipMultiplyAdd(VBBMipPixel sum, VBBMipPixel v, float w) { return vmlaq_n_f32(sum, v, w); }
+#else
+struct VBBMipPixel {
+    float v[4];
+};
+static inline VBBMipPixel mipZero(void) { return VBBMipPixel{{0.0f, 0.0f, 0.0f, 0.0f}}; }
+static inline VBBMipPixel mipLoad(const float* p) { return VBBMipPixel{{p[0], p[1], p[2], p[3]}}; }
+static inline void mipStore(float* p, VBBMipPixel v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline VBBMipPixel mipMultiplyAdd(VBBMipPixel sum, VBBMipPixel v, float w) {
+    for (int c = 0; c < 4; c++) sum.v[c] += v.v[c] * w;
+    return sum;
+}
+#endif
+
+// Clamped to 0 to 1, scaled per channel, and rounded
+#if defined(VBB_SIMD_SSE)
+static inline void mipQuantize(VBBMipPixel v, VBBMipPixel scale, int32_t* pOut) {
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    _mm_storeu_si128((__m128i*)pOut, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), _mm_set1_ps(0.5f))));
+}
+#elif defined(VBB_SIMD_NEON)
+static inline void mipQuantize(VBBMipPixel v, VBBMipPixel scale, int32_t* pOut) {
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    vst1q_s32(pOut, vcvtq_s32_f32(vmlaq_f32(vdupq_n_f32(0.5f), v, scale)));
+}
+#else
+static inline void mipQuantize(VBBMipPixel v, VBBMipPixel scale, int32_t* pOut) {
+    for (int c = 0; c < 4; c++) {
+        float f = (v.v[c] < 0.0f) ? 0.0f : (v.v[c] > 1.0f) ? 1.0f : v.v[c];
+        pOut[c] = int32_t(f * scale.v[c] + 0.5f);
+    }
+}
+#endif
+
+static inline uint32_t clampIndex(int i, uint32_t size) { return (i < 0) ? 0 : (uint32_t(i) >= size) ? size - 1 : uint32_t(i); }
+
+// *********************************************************************************************************
+// Plain 2x2 average, rounded, for linear data. Four channel pixels are done 2 (SSE) or 8 (NEON) at a
+// time, anything else a byte at a time. An odd last row or column is averaged with itself.
+static void boxRow(const unsigned char* pRow0, const unsigned char* pRow1, unsigned char* pOut, uint32_t sourceWidth,
+                   uint32_t width, uint32_t channels) {
+    uint32_t x = 0;
+
+    if (channels == 4) {
+#if defined(VBB_SIMD_SSE)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 2 <= width && 2 * x + 4 <= sourceWidth; x += 2) {
+            __m128i r0 = _mm_loadu_si128((const __m128i*)(pRow0 + x * 8));
+            __m128i r1 = _mm_loadu_si128((const __m128i*)(pRow1 + x * 8));
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+            low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+            high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+            __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), two), 2);
+            _mm_storel_epi64((__m128i*)(pOut + x * 4), _mm_packus_epi16(sum, zero));
+        }
+#elif defined(VBB_SIMD_NEON)
+        for (; x + 8 <= width && 2 * x + 16 <= sourceWidth; x += 8) {
+            uint8x16x4_t r0 = vld4q_u8(pRow0 + x * 8);
+            uint8x16x4_t r1 = vld4q_u8(pRow1 + x * 8);
+            uint8x8x4_t out;
+            for (int c = 0; c < 4; c++) out.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(r0.val[c]), vpaddlq_u8(r1.val[c])), 2);
+            vst4_u8(pOut + x * 4, out);
+        }
+#endif
+    }
+
+    for (; x < width; x++) {
+        uint32_t x0 = 2 * x, x1 = clampIndex(2 * x + 1, sourceWidth);
+        for (uint32_t c = 0; c < channels; c++)
+            pOut[x * channels + c] = (unsigned char)((pRow0[x0 * channels + c] + pRow0[x1 * channels + c] + pRow1[x0 * channels + c] +
+                                                      pRow1[x1 * channels + c] + 2) >> 2);
+    }
+}
+
+// *********************************************************************************************************
+// Each thread keeps the last few source rows it filtered across, so going down the destination rows
+// it only filters two more source rows each time. The tap count is a template parameter so the
+// loops over the taps unroll.
+template <int kTaps>
+static void filterLevel(const unsigned char* pSource, uint32_t sourceWidth, uint32_t sourceHeight, unsigned char* pScratch,
+                        unsigned char* pDest, uint32_t width, uint32_t height, uint32_t channels, const VBBMipTaps& taps, bool bSRGB,
+                        uint32_t nThreads) {
+    const VBBMipTables& tables = getMipTables();
+    const float* toFloat[4];
+    bool linearLight[4];
+    float scales[4];
+    for (uint32_t c = 0; c < 4; c++) {
+        linearLight[c] = bSRGB && !(channels == 4 && c == 3);
+        toFloat[c] = linearLight[c] ? tables.toLinear : tables.toFloat;
+        scales[c] = linearLight[c] ? 65535.0f : 255.0f;
+    }
+    const VBBMipPixel scale = mipLoad(scales);
+
+    float weights[kTaps];
+    for (int k = 0; k < kTaps; k++) weights[k] = taps.weights[k];
+    const int first = taps.first;
+
+    size_t rowBytes = size_t(width) * channels;
+    size_t sourceRowBytes = size_t(sourceWidth) * channels;
+
+    vbbParallelFor(height, nThreads, [&](uint32_t firstRow, uint32_t lastRow) {
+        std::vector<float> decoded(size_t(sourceWidth) * 4, 0.0f);
+        std::vector<float> filtered(kTaps * size_t(width) * 4);
+        int filteredRow[kTaps];
+        for (int k = 0; k < kTaps; k++) filteredRow[k] = -1;
+
+        for (uint32_t y = firstRow; y < lastRow; y++) {
+            const float* pRows[kTaps];
+            for (int k = 0; k < kTaps; k++) {
+                uint32_t sy = clampIndex(int(2 * y) + first + k, sourceHeight);
+                float* pFiltered = &filtered[(sy % kTaps) * width * 4];
+                pRows[k] = pFiltered;
+                if (filteredRow[sy % kTaps] == int(sy)) continue;
+
+                const unsigned char* pIn = pSource + sy * sourceRowBytes;
+                if (channels == 4)
+                    for (uint32_t x = 0; x < sourceWidth; x++, pIn += 4) {
+                        float* pDecoded = &decoded[x * 4];
+                        pDecoded[0] = toFloat[0][pIn[0]];
+                        pDecoded[1] = toFloat[1][pIn[1]];
+                        pDecoded[2] = toFloat[2][pIn[2]];
+                        pDecoded[3] = toFloat[3][pIn[3]];
+                    }
+                else
+                    for (uint32_t x = 0; x < sourceWidth; x++)
+                        for (uint32_t c = 0; c < channels; c++) decoded[x * 4 + c] = toFloat[c][pIn[x * channels + c]];
+
+                for (uint32_t x = 0; x < width; x++) {
+                    VBBMipPixel v = mipZero();
+                    int left = int(2 * x) + first;
+                    if (left >= 0 && left + kTaps <= int(sourceWidth)) {
+                        const float* pTap = &decoded[left * 4];
+                        for (int j = 0; j < kTaps; j++) v = mipMultiplyAdd(v, mipLoad(pTap + j * 4), weights[j]);
+                    } else
+                        for (int j = 0; j < kTaps; j++)
+                            v = mipMultiplyAdd(v, mipLoad(&decoded[clampIndex(left + j, sourceWidth) * 4]), weights[j]);
+                    mipStore(&pFiltered[x * 4], v);
+                }
+                filteredRow[sy % kTaps] = int(sy);
+            }
+
+            unsigned char* pOut = pScratch + y * rowBytes;
+            for (uint32_t x = 0; x < width; x++) {
+                VBBMipPixel v = mipZero();
+                for (int k = 0; k < kTaps; k++) v = mipMultiplyAdd(v, mipLoad(pRows[k] + x * 4), weights[k]);
+
+                int32_t q[4];
+                mipQuantize(v, scale, q);
+                for (uint32_t c = 0; c < channels; c++)
+                    pOut[x * channels + c] = linearLight[c] ? tables.fromLinear[q[c]] : (unsigned char)q[c];
+            }
+            memcpy(pDest + y * rowBytes, pOut, rowBytes);
+        }
+    });
+}
+
+// *********************************************************************************************************
+uint32_t vbbGetMipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t size = (width > height) ? width : height;
+    uint32_t levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+size_t vbbGetMipChainSize(uint32_t width, uint32_t height, uint32_t levels, uint32_t bytesPerPixel) {
+    size_t size = 0;
+    for (uint32_t m = 0; m < levels; m++) {
+        size += size_t(width) * height * bytesPerPixel;
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+    }
+    return size;
+}
+
+// *********************************************************************************************************
+// Small levels aren't worth starting threads for.
+bool vbbGenerateMipChain(const void* pSource, void* pDest, uint32_t width, uint32_t height, uint32_t channels, uint32_t levels,
+                         VBBMipFilter filter, bool bSRGB, uint32_t nThreads) {
+    if (channels == 0 || channels > 4 || width == 0 || height == 0 || levels == 0) return false;
+
+    const unsigned char* pIn = static_cast<const unsigned char*>(pSource);
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+    size_t levelSize = size_t(width) * height * channels;
+    memcpy(pOut, pIn, levelSize);
+    pOut += levelSize;
+
+    VBBMipTaps taps;
+    makeMipTaps(filter, taps);
+    bool bBox = (filter == VBB_MIP_FILTER_BOX && !bSRGB);
+
+    if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+
+    std::vector<unsigned char> scratch[2];
+    for (uint32_t m = 1; m < levels; m++) {
+        uint32_t sourceWidth = width, sourceHeight = height;
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+
+        std::vector<unsigned char>& level = scratch[m & 1];
+        levelSize = size_t(width) * height * channels;
+        level.resize(levelSize);
+
+        uint32_t threads = uint32_t(levelSize / 65536) + 1;
+        if (threads > nThreads) threads = nThreads;
+
+        if (bBox) {
+            unsigned char* pLevel = level.data();
+            unsigned char* pLevelDest = pOut;
+            size_t rowBytes = size_t(width) * channels, sourceRowBytes = size_t(sourceWidth) * channels;
+            vbbParallelFor(height, threads, [&](uint32_t firstRow, uint32_t lastRow) {
+                for (uint32_t y = firstRow; y < lastRow; y++) {
+                    boxRow(pIn + 2 * y * sourceRowBytes, pIn + clampIndex(2 * y + 1, sourceHeight) * sourceRowBytes, pLevel + y * rowBytes,
+                           sourceWidth, width, channels);
+                    memcpy(pLevelDest + y * rowBytes, pLevel + y * rowBytes, rowBytes);
+                }
+            });
+        } else if (taps.count == 2)
+            filterLevel<2>(pIn, sourceWidth, sourceHeight, level.data(), pOut, width, height, channels, taps, bSRGB, threads);
+        else
+            filterLevel<kMaxMipTaps>(pIn, sourceWidth, sourceHeight, level.data(), pOut, width, height, channels, taps, bSRGB, threads);
+
+        pIn = level.data();
+        pOut += levelSize;
+    }
+
+    return true;
+}
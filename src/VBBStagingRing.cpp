@@ -0,0 +1,252 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include <thread>
+#include "VBBStagingRing.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// One buffer, mapped for as long as the ring is around
+VkResult VBBStagingRing::init(VBBDevice* pLogicalDevice, VmaAllocator allocator, VkDeviceSize size) {
+    if (m_pBuffer != nullptr) return VK_SUCCESS;
+
+    m_device = pLogicalDevice->getDevice();
+    m_VMA = allocator;
+
+    m_pBuffer = new VBBBufferDynamic(m_VMA);
+    VkResult result = m_pBuffer->createBuffer(size);
+    if (result != VK_SUCCESS) {
+        delete m_pBuffer;
+        m_pBuffer = nullptr;
+        return result;
+    }
+
+    m_pData = (unsigned char*)m_pBuffer->mapMemory();
+    m_size = size;
+    m_head = 0;
+    return VK_SUCCESS;
+}
+
+void VBBStagingRing::shutdown(void) {
+    if (m_pBuffer == nullptr) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_regions.size(); i++)
+        if (m_regions[i].bFreed && !m_regions[i].bDone) vkWaitForFences(m_device, 1, &m_regions[i].fence, VK_TRUE, UINT64_MAX);
+    for (size_t i = 0; i < m_dedicated.size(); i++) {
+        if (m_dedicated[i].bFreed && !m_dedicated[i].bDone) vkWaitForFences(m_device, 1, &m_dedicated[i].fence, VK_TRUE, UINT64_MAX);
+        delete m_dedicated[i].pBuffer;
+    }
+    m_regions.clear();
+    m_dedicated.clear();
+
+    delete m_pBuffer;
+    m_pBuffer = nullptr;
+    m_pData = nullptr;
+    m_size = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Off the head if it fits, otherwise wait on the oldest fence and try again. Only the oldest region
+/// can make room, so if it hasn't been freed yet (it's still being filled, maybe by whoever's asking)
+/// there's no point waiting, it gets its own buffer instead. The fence can only be touched with the
+/// lock held, so the wait is in short pieces to let everyone else in between.
+bool VBBStagingRing::allocate(VkDeviceSize size, VBBStagingAllocation& allocation, VkDeviceSize alignment, bool bWait) {
+    if (size == 0 || m_pBuffer == nullptr) return false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    retireLocked();
+
+    VkDeviceSize offset = 0;
+    bool bPlaced = false;
+    if (size <= m_size) {
+        bool bStalled = false;
+        while (!(bPlaced = place(size, alignment, offset))) {
+            if (!bWait || m_regions.empty() || !m_regions.front().bFreed) break;
+
+            bStalled = true;
+            VkResult result = vkWaitForFences(m_device, 1, &m_regions.front().fence, VK_TRUE, VBB_STAGING_WAIT_SLICE);
+            if (result == VK_TIMEOUT) {
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            } else if (result != VK_SUCCESS)
+                break;
+            retireLocked();
+        }
+        if (bStalled) m_stats.stalls++;
+    }
+
+    if (!bPlaced) {
+        if (!bWait || !allocateDedicated(size, allocation)) return false;
+    } else {
+        Region region = {m_nextID++, offset, offset + size, VK_NULL_HANDLE, false, false, nullptr};
+        m_regions.push_back(region);
+        m_head = region.end;
+
+        allocation.buffer = m_pBuffer->getBuffer();
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.pData = m_pData + offset;
+        allocation.pRing = this;
+        allocation.pBuffer = nullptr;
+        allocation.id = region.id;
+    }
+
+    m_stats.bytesStaged += size;
+    m_stats.allocations++;
+    return true;
+}
+
+// Free from the head up to the tail, wrapping round the end. Whatever's left at the end when it wraps
+// comes back when the tail gets past it.
+bool VBBStagingRing::place(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+    if (m_regions.empty()) m_head = 0;
+    VkDeviceSize tail = m_regions.empty() ? 0 : m_regions.front().start;
+
+    offset = (m_head + alignment - 1) / alignment * alignment;
+    if (m_regions.empty() || m_head > tail) {
+        if (offset + size > m_size) {
+            if (size > tail) return false;
+            offset = 0;
+            m_stats.wraparounds++;
+        }
+    } else if (offset + size > tail)
+        return false;
+
+    return true;
+}
+
+bool VBBStagingRing::allocateDedicated(VkDeviceSize size, VBBStagingAllocation& allocation) {
+    VBBBufferDynamic* pBuffer = new VBBBufferDynamic(m_VMA);
+    if (pBuffer->createBuffer(size) != VK_SUCCESS) {
+        delete pBuffer;
+        return false;
+    }
+
+    Region region = {m_nextID++, 0, size, VK_NULL_HANDLE, false, false, pBuffer};
+    m_dedicated.push_back(region);
+    m_stats.dedicated++;
+
+    allocation.buffer = pBuffer->getBuffer();
+    allocation.offset = 0;
+    allocation.size = size;
+    allocation.pData = (unsigned char*)pBuffer->mapMemory();
+    allocation.pRing = this;
+    allocation.pBuffer = pBuffer;
+    allocation.id = region.id;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void VBBStagingRing::free(VBBStagingAllocation& allocation, VkFence fence) {
+    if (allocation.id == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Region* pRegion = nullptr;
+    for (size_t i = 0; pRegion == nullptr && i < m_regions.size(); i++)
+        if (m_regions[i].id == allocation.id) pRegion = &m_regions[i];
+    for (size_t i = 0; pRegion == nullptr && i < m_dedicated.size(); i++)
+        if (m_dedicated[i].id == allocation.id) pRegion = &m_dedicated[i];
+
+    if (pRegion != nullptr) {
+        pRegion->bFreed = true;
+        pRegion->fence = fence;
+        pRegion->bDone = (fence == VK_NULL_HANDLE);
+    }
+    allocation = VBBStagingAllocation();
+
+    retireLocked();
+}
+
+void VBBStagingRing::retire(void) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retireLocked();
+}
+
+// Every fence gets checked, not just the oldest, so the ring lets go of them as soon as they signal
+void VBBStagingRing::checkFence(Region& region) {
+    if (region.bFreed && !region.bDone && vkGetFenceStatus(m_device, region.fence) == VK_SUCCESS) {
+        region.bDone = true;
+        region.fence = VK_NULL_HANDLE;
+    }
+}
+
+void VBBStagingRing::retireLocked(void) {
+    for (size_t i = 0; i < m_regions.size(); i++) checkFence(m_regions[i]);
+    while (!m_regions.empty() && m_regions.front().bDone) m_regions.pop_front();
+
+    for (size_t i = 0; i < m_dedicated.size();) {
+        checkFence(m_dedicated[i]);
+        if (m_dedicated[i].bDone) {
+            delete m_dedicated[i].pBuffer;
+            m_dedicated.erase(m_dedicated.begin() + i);
+        } else
+            i++;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void VBBStagingRing::getStats(VBBStagingStats& stats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats = m_stats;
+}
+
+void VBBStagingRing::resetStats(void) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats = VBBStagingStats();
+}
+
+VkDeviceSize VBBStagingRing::getAlignment(uint32_t texelSize) {
+    VkDeviceSize alignment = VBB_STAGING_ALIGNMENT;
+    while (texelSize != 0 && alignment % texelSize != 0) alignment += VBB_STAGING_ALIGNMENT;
+    return alignment;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The ring if there is one, or a buffer just for this
+bool vbbAllocateStaging(VBBStagingRing* pRing, VmaAllocator allocator, VkDeviceSize size, VBBStagingAllocation& allocation,
+                        VkDeviceSize alignment) {
+    if (pRing != nullptr) return pRing->allocate(size, allocation, alignment);
+
+    VBBBufferDynamic* pBuffer = new VBBBufferDynamic(allocator);
+    if (pBuffer->createBuffer(size) != VK_SUCCESS) {
+        delete pBuffer;
+        return false;
+    }
+
+    allocation = VBBStagingAllocation();
+    allocation.buffer = pBuffer->getBuffer();
+    allocation.size = size;
+    allocation.pData = (unsigned char*)pBuffer->mapMemory();
+    allocation.pBuffer = pBuffer;
+    return true;
+}
+
+void vbbFreeStaging(VBBStagingAllocation& allocation, VkFence fence) {
+    if (allocation.pRing != nullptr)
+        allocation.pRing->free(allocation, fence);
+    else {
+        delete allocation.pBuffer;
+        allocation = VBBStagingAllocation();
+    }
+}
@@ -23,12 +23,17 @@
 
 #include <memory.h>
 #include <assert.h>
+#include <memory>
+#include <algorithm>
 
 #include "VBBTexture.h"
 #include "VBBSingleShotCommand.h"
+#include "VBBMappedFile.h"
+#include "VBBUtils.h"
 
 VBBTexture::VBBTexture(VmaAllocator allocator, VBBDevice* pLogicalDevice) {
     m_VMA = allocator;
+    m_pDevice = pLogicalDevice;
     physicalDevice = pLogicalDevice->getPhysicalDeviceHandle();
     m_Device = pLogicalDevice->getDevice();
     graphicsQueue = pLogicalDevice->getQueue();
@@ -42,32 +47,62 @@ VBBTexture::~VBBTexture() {
     vmaDestroyImage(m_VMA, textureImage, m_allocation);
 }
 
-void VBBTexture::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize offset,
-                                   int nMipLevel) {
-    VBBSingleShotCommand singleShot(m_Device, commandPool, graphicsQueue);
-    singleShot.start();
-
-    VkBufferImageCopy region = {};
-    region.bufferOffset = offset;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = nMipLevel;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(singleShot.getCommandBuffer(), buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+// Levels are packed one after another in the buffer, starting at bufferOffset, and they all go in one copy.
+// Each array layer has its own run of levels, a volume has all the slices of a level together. Layers
+// without mips are one after another anyway, so they're one region.
+void VBBTexture::copyBufferToImage(VkCommandBuffer cmdBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width,
+                                   uint32_t height, uint32_t levels) {
+    uint32_t layerRegions = (levels == 1) ? 1 : arrayLayers;
+    std::vector<VkBufferImageCopy> regions(layerRegions * levels);
+    VkDeviceSize offset = bufferOffset;
+    for (uint32_t layer = 0; layer < layerRegions; layer++) {
+        uint32_t levelWidth = width;
+        uint32_t levelHeight = height;
+        uint32_t levelDepth = textureDepth;
+        for (uint32_t m = 0; m < levels; m++) {
+            VkBufferImageCopy &region = regions[layer * levels + m];
+            region.bufferOffset = offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = m;
+            region.imageSubresource.baseArrayLayer = layer;
+            region.imageSubresource.layerCount = (levels == 1) ? arrayLayers : 1;
+
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {levelWidth, levelHeight, levelDepth};
+
+            offset += VkDeviceSize(levelWidth) * levelHeight * levelDepth * getBytesPerPixel(imageFormat);
+            if (levelWidth > 1) levelWidth /= 2;
+            if (levelHeight > 1) levelHeight /= 2;
+            if (levelDepth > 1) levelDepth /= 2;
+        }
+    }
 
-    singleShot.end();
+    vkCmdCopyBufferToImage(cmdBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(regions.size()), regions.data());
 }
 
-void VBBTexture::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VBBSingleShotCommand singleShot(m_Device, commandPool, graphicsQueue);
+// What was being done to the image in the old layout, and what will be done to it in the new one.
+// Anything that isn't a transfer is the fragment shader reading it.
+static void getLayoutAccess(VkImageLayout layout, VkAccessFlags &access, VkPipelineStageFlags &stage) {
+    if (layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+        access = 0;
+        stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    } else if (layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if (layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+        access = VK_ACCESS_TRANSFER_READ_BIT;
+        stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else {
+        access = VK_ACCESS_SHADER_READ_BIT;
+        stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+}
 
+void VBBTexture::transitionImageLayout(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                       uint32_t baseLevel, uint32_t levelCount) {
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
@@ -76,41 +111,18 @@ void VBBTexture::transitionImageLayout(VkImage image, VkImageLayout oldLayout, V
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = mipMapLevels;
+    barrier.subresourceRange.baseMipLevel = baseLevel;
+    barrier.subresourceRange.levelCount = levelCount;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    barrier.srcAccessMask = 0;  // TBD
-    barrier.dstAccessMask = 0;  // TBD
-
-    singleShot.start();
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 
     VkPipelineStageFlags sourceStage;
     VkPipelineStageFlags destinationStage;
+    getLayoutAccess(oldLayout, barrier.srcAccessMask, sourceStage);
+    getLayoutAccess(newLayout, barrier.dstAccessMask, destinationStage);
+    if (oldLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) barrier.srcAccessMask = 0;  // Only writes have to be made visible
 
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        sourceStage = 0;
-        destinationStage = 0;
-        assert(1);
-        // FAILED REALLY
-    }
-
-    vkCmdPipelineBarrier(singleShot.getCommandBuffer(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    singleShot.end();
+    vkCmdPipelineBarrier(cmdBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
 void VBBTexture::createTextureImageView(void) {
@@ -119,13 +131,13 @@ void VBBTexture::createTextureImageView(void) {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = textureImage;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = imageViewType;
     viewInfo.format = imageFormat;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = mipMapLevels;  // YES, CONFIRMED
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = arrayLayers;
 
     vkCreateImageView(m_Device, &viewInfo, nullptr, &textureImageView);
 }
@@ -155,21 +167,150 @@ void VBBTexture::createSampler() {
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Load a raw blob of data into a texture
+/// Formats that aren't sampleable, and what to try instead. The device is asked, nothing is assumed.
+struct VBBTextureFallback {
+    VkFormat source;
+    VkFormat upload;
+    VBBPixelConversion conversion;
+};
+
+static const VBBTextureFallback kTextureFallbacks[] = {
+    {VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VBB_PIXELS_BGR_TO_RGBA},
+    {VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_B8G8R8A8_UNORM, VBB_PIXELS_RGB_TO_RGBA},
+    {VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VBB_PIXELS_RGB_TO_RGBA},
+    {VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8A8_UNORM, VBB_PIXELS_BGR_TO_RGBA},
+    {VK_FORMAT_B8G8R8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VBB_PIXELS_BGR_TO_RGBA},
+    {VK_FORMAT_B8G8R8_SRGB, VK_FORMAT_B8G8R8A8_SRGB, VBB_PIXELS_RGB_TO_RGBA},
+    {VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VBB_PIXELS_RGB_TO_RGBA},
+    {VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_B8G8R8A8_SRGB, VBB_PIXELS_BGR_TO_RGBA},
+    {VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VBB_PIXELS_SWAP_RB},
+    {VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8A8_UNORM, VBB_PIXELS_SWAP_RB},
+    {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VBB_PIXELS_SWAP_RB},
+    {VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_SRGB, VBB_PIXELS_SWAP_RB},
+    {VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VBB_PIXELS_GREY_TO_RGBA},
+    {VK_FORMAT_R8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VBB_PIXELS_GREY_TO_RGBA}};
+
+bool VBBTexture::isFormatSupported(VkFormat format, VkFormatFeatureFlags features) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+
+    VkFormatFeatureFlags supported =
+        (imageTiling == VK_IMAGE_TILING_OPTIMAL) ? properties.optimalTilingFeatures : properties.linearTilingFeatures;
+    return (supported & features) == features;
+}
+
+VkFormat VBBTexture::chooseUploadFormat(VkFormat sourceFormat, VBBPixelConversion &conversion) {
+    conversion = VBB_PIXELS_COPY;
+    if (isFormatSupported(sourceFormat)) return sourceFormat;
+
+    for (const VBBTextureFallback &fallback : kTextureFallbacks)
+        if (fallback.source == sourceFormat && isFormatSupported(fallback.upload)) {
+            conversion = fallback.conversion;
+            return fallback.upload;
+        }
+
+    return VK_FORMAT_UNDEFINED;
+}
+
+// Premultiplying only means something when there's alpha in the data
+static bool hasAlpha(VkFormat format) {
+    return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB ||
+           format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+// Mips can be built on the CPU for anything that's one byte per channel
+static bool isByteFormat(VkFormat format, bool &bSRGB) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+            bSRGB = false;
+            return true;
+
+        case VK_FORMAT_R8_SRGB:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_SRGB:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+            bSRGB = true;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Source pixels into staging memory, converted and premultiplied on the way if they need to be. If
+// mipLevels is more than 1 the chain is built from them too, and level 0 is converted to scratch
+// memory first, because staging memory is slow to read back.
+static void stagePixels(const void *pSource, size_t sourceBytes, void *pDest, VBBPixelConversion conversion, bool bPremultiply,
+                        uint32_t width, uint32_t height, uint32_t bytesPerPixel, uint32_t mipLevels, VBBMipFilter filter, bool bSRGB) {
+    uint32_t destSize;
+    size_t pixelCount = sourceBytes / vbbGetPixelConversionSizes(conversion, &destSize);
+
+    if (mipLevels > 1) {
+        std::vector<unsigned char> converted;
+        const void *pLevel0 = pSource;
+        if (conversion != VBB_PIXELS_COPY || bPremultiply) {
+            converted.resize(pixelCount * destSize);
+            vbbConvertPixels(conversion, pSource, converted.data(), pixelCount, bPremultiply);
+            pLevel0 = converted.data();
+        }
+
+        vbbGenerateMipChain(pLevel0, pDest, width, height, bytesPerPixel, mipLevels, filter, bSRGB);
+    } else if (conversion == VBB_PIXELS_COPY && !bPremultiply)
+        memcpy(pDest, pSource, sourceBytes);
+    else
+        vbbConvertPixels(conversion, pSource, pDest, pixelCount, bPremultiply);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Load a raw blob of data into a texture. Any conversion happens on the way into the staging buffer,
+/// so it's still just the one pass over the data. If m_generateMips is set (and mipLevels is 1) the
+/// whole chain is built into the staging buffer instead, converted first if it has to be. Or only
+/// level 0 is staged, if the GPU is making the rest.
 /// TBD: Should be able to get channels from format... just say'n.
 bool VBBTexture::loadRawTexture(const void *pImageData, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
                                 uint32_t totalBytes, int mipLevels) {
+    VBBPixelConversion conversion;
+    VkFormat uploadFormat = chooseUploadFormat(format, conversion);
+    if (uploadFormat == VK_FORMAT_UNDEFINED) return false;
+
+    bool bPremultiply = m_premultiplyAlpha && hasAlpha(format);
+    uint32_t destSize;
+    uint32_t sourceSize = vbbGetPixelConversionSizes(conversion, &destSize);
+    uint32_t sourceBytes = totalBytes;
+    if (conversion != VBB_PIXELS_COPY) {
+        totalBytes = uint32_t(totalBytes / sourceSize * destSize);
+        channels = 4;
+    }
+
+    // The GPU makes them if it's been asked to and it can, otherwise they're made here
+    uint32_t gpuLevels = (mipLevels == 1) ? getGPUMipLevels(uploadFormat, width, height) : 1;
+    bool bSRGB = false;
+    bool bBuildMips = m_generateMips && gpuLevels == 1 && mipLevels == 1 && isByteFormat(uploadFormat, bSRGB);
+    if (bBuildMips) {
+        mipLevels = int(vbbGetMipLevelCount(width, height));
+        totalBytes = uint32_t(vbbGetMipChainSize(width, height, uint32_t(mipLevels), uint32_t(getBytesPerPixel(uploadFormat))));
+    }
+
     imageSize = totalBytes;
 
-    // Make this static (MEMBER, THAT IS, NOT A STATIC BUFFER), reserve the largest texture buffer possible, and reuse. TBD:
-    VBBBufferDynamic tempBuffer(m_VMA);
-    tempBuffer.createBuffer(imageSize);
+    VBBStagingAllocation staging;
+    if (!allocateStaging(imageSize, uploadFormat, staging)) return false;
 
-    void *pData = tempBuffer.mapMemory();
-    memcpy(pData, pImageData, imageSize);
-    tempBuffer.unmapMemory();
+    stagePixels(pImageData, sourceBytes, staging.pData, conversion, bPremultiply, width, height,
+                uint32_t(getBytesPerPixel(uploadFormat)), bBuildMips ? uint32_t(mipLevels) : 1, m_mipFilter, bSRGB);
 
-    bool ret = loadRawTexture(tempBuffer, format, channels, width, height, totalBytes, mipLevels);
+    bool ret = uploadImage(staging.buffer, staging.offset, uploadFormat, channels, width, height, totalBytes, mipLevels,
+                           (gpuLevels > 1) ? int(gpuLevels) : mipLevels);
+    doneWithStaging(staging);
     return ret;
 }
 
@@ -178,6 +319,197 @@ bool VBBTexture::loadRawTexture(const void *pImageData, VkFormat format, uint32_
 /// TBD: Should be able to get channels from format... just say'n.
 bool VBBTexture::loadRawTexture(VBBBufferDynamic &imageBuffer, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
                                 uint32_t totalBytes, int mipLevels) {
+    return uploadImage(imageBuffer.getBuffer(), 0, format, channels, width, height, totalBytes, mipLevels, mipLevels);
+}
+
+// Arrays, cubes (six faces, square) and volumes. Nothing else has layers.
+static bool isLayeredView(VkImageViewType viewType, uint32_t layers, uint32_t width, uint32_t height) {
+    switch (viewType) {
+        case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
+        case VK_IMAGE_VIEW_TYPE_3D:
+            return layers != 0;
+        case VK_IMAGE_VIEW_TYPE_CUBE:
+            return layers == 6 && width == height;
+        case VK_IMAGE_VIEW_TYPE_CUBE_ARRAY:
+            return layers != 0 && layers % 6 == 0 && width == height;
+        default:
+            return false;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Like loadRawTexture(), for a whole array, cube or volume in one image. The GPU blits the mips for every
+/// layer at once if it's been asked to and can, otherwise array layers have their chains built here one
+/// layer at a time. Volumes only get mips from the GPU (or the data).
+bool VBBTexture::loadRawTextureLayers(const void *pImageData, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
+                                      uint32_t layers, uint32_t totalBytes, VkImageViewType viewType, int mipLevels) {
+    if (!isLayeredView(viewType, layers, width, height)) return false;
+
+    VBBPixelConversion conversion;
+    VkFormat uploadFormat = chooseUploadFormat(format, conversion);
+    if (uploadFormat == VK_FORMAT_UNDEFINED) return false;
+
+    bool bPremultiply = m_premultiplyAlpha && hasAlpha(format);
+    uint32_t destSize;
+    uint32_t sourceSize = vbbGetPixelConversionSizes(conversion, &destSize);
+    uint32_t sourceBytes = totalBytes;
+    if (conversion != VBB_PIXELS_COPY) {
+        totalBytes = uint32_t(totalBytes / sourceSize * destSize);
+        channels = 4;
+    }
+
+    bool bVolume = viewType == VK_IMAGE_VIEW_TYPE_3D;
+    uint32_t bytesPerPixel = uint32_t(getBytesPerPixel(uploadFormat));
+    uint32_t gpuLevels = 1;
+    if (mipLevels == 1 && m_generateMips && m_generateMipsOnGPU && canBlitMips(uploadFormat))
+        gpuLevels = vbbGetMipLevelCount(bVolume ? std::max(width, layers) : width, height);
+
+    bool bSRGB = false;
+    bool bBuildMips = m_generateMips && gpuLevels == 1 && mipLevels == 1 && !bVolume && isByteFormat(uploadFormat, bSRGB);
+    size_t chainSize = 0;
+    if (bBuildMips) {
+        mipLevels = int(vbbGetMipLevelCount(width, height));
+        chainSize = vbbGetMipChainSize(width, height, uint32_t(mipLevels), bytesPerPixel);
+        totalBytes = uint32_t(chainSize * layers);
+    }
+
+    VBBStagingAllocation staging;
+    if (!allocateStaging(totalBytes, uploadFormat, staging)) return false;
+
+    if (bBuildMips) {
+        size_t layerBytes = sourceBytes / layers;
+        for (uint32_t layer = 0; layer < layers; layer++)
+            stagePixels(static_cast<const unsigned char *>(pImageData) + layerBytes * layer, layerBytes, staging.pData + chainSize * layer,
+                        conversion, bPremultiply, width, height, bytesPerPixel, uint32_t(mipLevels), m_mipFilter, bSRGB);
+    } else
+        stagePixels(pImageData, sourceBytes, staging.pData, conversion, bPremultiply, width, height, bytesPerPixel, 1, m_mipFilter, bSRGB);
+
+    bool ret = uploadImage(staging.buffer, staging.offset, uploadFormat, channels, width, height, totalBytes, mipLevels,
+                           (gpuLevels > 1) ? int(gpuLevels) : mipLevels, viewType, layers);
+    doneWithStaging(staging);
+    return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A targa for each layer, mapped one at a time and decoded straight into staging. If the pixels need
+/// converting or mipmapping they all go to scratch memory instead, and through the loader above.
+bool VBBTexture::loadTGATextureLayers(const char *const *szFileNames, uint32_t count, VkImageViewType viewType) {
+    if (count == 0) return false;
+
+    VBBMappedFile file;
+    uint32_t width, height, channels;
+    VkFormat format;
+    size_t size;
+    if (!file.open(szFileNames[0]) || !vbbGetTGAInfo(file.getData(), file.getSize(), &width, &height, &channels, &format, &size))
+        return false;
+    if (!isLayeredView(viewType, count, width, height)) return false;
+
+    VBBPixelConversion conversion;
+    VkFormat uploadFormat = chooseUploadFormat(format, conversion);
+    if (uploadFormat == VK_FORMAT_UNDEFINED) return false;
+
+    bool bVolume = viewType == VK_IMAGE_VIEW_TYPE_3D;
+    uint32_t gpuLevels = 1;
+    if (m_generateMips && m_generateMipsOnGPU && canBlitMips(uploadFormat))
+        gpuLevels = vbbGetMipLevelCount(bVolume ? std::max(width, count) : width, height);
+
+    bool bStraightCopy = conversion == VBB_PIXELS_COPY && !(m_premultiplyAlpha && hasAlpha(format)) &&
+                         (!m_generateMips || gpuLevels > 1 || bVolume);
+
+    std::vector<unsigned char> scratch;
+    VBBStagingAllocation staging;
+    unsigned char *pDest;
+    if (bStraightCopy) {
+        if (!allocateStaging(size * count, uploadFormat, staging)) return false;
+        pDest = staging.pData;
+    } else {
+        scratch.resize(size * count);
+        pDest = scratch.data();
+    }
+
+    // Every one has to match the first
+    bool bOK = true;
+    for (uint32_t i = 0; bOK && i < count; i++) {
+        uint32_t layerWidth, layerHeight, layerChannels;
+        VkFormat layerFormat;
+        size_t layerSize;
+        bOK = (i == 0 || file.open(szFileNames[i])) &&
+              vbbGetTGAInfo(file.getData(), file.getSize(), &layerWidth, &layerHeight, &layerChannels, &layerFormat, &layerSize) &&
+              layerWidth == width && layerHeight == height && layerFormat == format &&
+              vbbDecodeTGA(file.getData(), file.getSize(), pDest + size * i);
+        file.close();
+    }
+
+    if (!bStraightCopy) return bOK && loadRawTextureLayers(scratch.data(), format, channels, width, height, count, uint32_t(size * count), viewType);
+
+    if (bOK)
+        bOK = uploadImage(staging.buffer, staging.offset, uploadFormat, channels, width, height, uint32_t(size * count), 1, int(gpuLevels),
+                          viewType, count);
+    doneWithStaging(staging);
+    return bOK;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Blitting needs linear filtering, and the format has to be able to blit both ways
+bool VBBTexture::canBlitMips(VkFormat format) {
+    return isFormatSupported(format, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                         VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// How many levels the image gets if the GPU is making the mips. 1 if it isn't, or can't.
+uint32_t VBBTexture::getGPUMipLevels(VkFormat format, uint32_t width, uint32_t height) {
+    if (!m_generateMips || !m_generateMipsOnGPU) return 1;
+
+    if (canBlitMips(format) || (m_pMipDownsampler != nullptr && m_pMipDownsampler->isFormatSupported(format, imageTiling)))
+        return vbbGetMipLevelCount(width, height);
+
+    return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Each level is blitted from the one before, which then goes to its final layout. Everything's
+/// in TRANSFER_DST_OPTIMAL to start with. All the layers go at once, and volumes shrink in depth too.
+void VBBTexture::recordBlitMips(VkCommandBuffer cmdBuffer) {
+    int32_t width = int32_t(textureWidth);
+    int32_t height = int32_t(textureHeight);
+    int32_t depth = int32_t(textureDepth);
+
+    for (uint32_t m = 1; m < mipMapLevels; m++) {
+        transitionImageLayout(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m - 1, 1);
+
+        VkImageBlit blit = {};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = m - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = arrayLayers;
+        blit.srcOffsets[1] = {width, height, depth};
+
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+        depth = (depth > 1) ? depth / 2 : 1;
+
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstSubresource.mipLevel = m;
+        blit.dstOffsets[1] = {width, height, depth};
+
+        vkCmdBlitImage(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                       &blit, VK_FILTER_LINEAR);
+
+        transitionImageLayout(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, imageLayout, m - 1, 1);
+    }
+
+    transitionImageLayout(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, imageLayout, mipMapLevels - 1, 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Just the image, nothing in it yet. layers is the depth of a volume.
+bool VBBTexture::createImage(VkFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t totalBytes, int mipLevels,
+                             VkImageUsageFlags extraUsage, VkImageViewType viewType, uint32_t layers) {
+    bool bVolume = viewType == VK_IMAGE_VIEW_TYPE_3D;
+    imageViewType = viewType;
+    arrayLayers = bVolume ? 1 : layers;
+    textureDepth = bVolume ? layers : 1;
     textureWidth = width;
     textureHeight = height;
     textureChannels = channels;
@@ -185,50 +517,186 @@ bool VBBTexture::loadRawTexture(VBBBufferDynamic &imageBuffer, VkFormat format,
     mipMapLevels = mipLevels;
     imageSize = totalBytes;
 
+    // Storage is only for building mips on the GPU, and plenty of formats can't do it
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | extraUsage;
+    if (isFormatSupported(imageFormat, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.imageType = bVolume ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
     imageInfo.extent.width = textureWidth;
     imageInfo.extent.height = textureHeight;
-    imageInfo.extent.depth = 1;
+    imageInfo.extent.depth = textureDepth;
     imageInfo.mipLevels = mipMapLevels;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = imageFormat;
     imageInfo.tiling = imageTiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    imageInfo.usage = usage;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.flags = 0;
+    if (viewType == VK_IMAGE_VIEW_TYPE_CUBE || viewType == VK_IMAGE_VIEW_TYPE_CUBE_ARRAY) imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
     imageInfo.queueFamilyIndexCount = 0;
 
     VmaAllocationCreateInfo texAllocInfo = {};
     texAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
     texAllocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;//VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-    vmaCreateImage(m_VMA, &imageInfo, &texAllocInfo, &textureImage, &m_allocation, nullptr);
-
-    // Wait... wait... Look down below
-    transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    if (mipLevels == 1)
-        copyBufferToImage(imageBuffer.getBuffer(), textureImage, textureWidth, textureHeight);
-    else {
-        VkDeviceSize offset = 0;
-        uint32_t uiWidth = width;
-        uint32_t uiHeight = height;
-
-        for (int m = 0; m < mipLevels; m++) {
-            copyBufferToImage(imageBuffer.getBuffer(), textureImage, uiWidth, uiHeight, offset, m);
-            offset += uiWidth * uiHeight * channels;
-            uiWidth /= 2;
-            uiHeight /= 2;
+    return vmaCreateImage(m_VMA, &imageInfo, &texAllocInfo, &textureImage, &m_allocation, nullptr) == VK_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Make the image and fill it. The first copiedLevels come out of the buffer, one after another from
+/// bufferOffset, the rest (up to mipLevels) are made on the GPU from level 0. It's all one command buffer,
+/// one submit, and none at all if it's going in a batch. The downsampler only does plain 2D images.
+bool VBBTexture::uploadImage(VkBuffer buffer, VkDeviceSize bufferOffset, VkFormat format, uint32_t channels, uint32_t width, uint32_t height,
+                             uint32_t totalBytes, int copiedLevels, int mipLevels, VkImageViewType viewType, uint32_t layers) {
+    bool bMakeMips = copiedLevels < mipLevels;
+    bool bBlit = bMakeMips && canBlitMips(format);
+    if (bMakeMips && !bBlit &&
+        (viewType != VK_IMAGE_VIEW_TYPE_2D || m_pMipDownsampler == nullptr || !m_pMipDownsampler->isFormatSupported(format, imageTiling)))
+        return false;
+
+    if (!createImage(format, channels, width, height, totalBytes, mipLevels, bBlit ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0, viewType, layers))
+        return false;
+
+    // Recorded into the batch if there is one, otherwise submitted here and waited on with a fence
+    bool bBatched = m_pUploadBatch != nullptr && m_pUploadBatch->isRecording();
+    VBBSingleShotCommand singleShot(m_Device, commandPool, graphicsQueue);
+    VkCommandBuffer cmdBuffer = bBatched ? m_pUploadBatch->getCommandBuffer() : singleShot.start();
+
+    transitionImageLayout(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    copyBufferToImage(cmdBuffer, buffer, bufferOffset, textureImage, width, height, uint32_t(copiedLevels));
+
+    VkResult result = VK_SUCCESS;
+    if (!bMakeMips)
+        transitionImageLayout(cmdBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, imageLayout);
+    else if (bBlit)
+        recordBlitMips(cmdBuffer);
+    else
+        result = m_pMipDownsampler->record(cmdBuffer, textureImage, imageFormat, width, height, mipMapLevels, imageLayout);
+
+    if (bBatched) {
+        m_pUploadBatch->addTexture();
+        if (bMakeMips && !bBlit) m_pUploadBatch->releaseAfter(m_pMipDownsampler);
+    } else {
+        singleShot.end();
+        if (bMakeMips && !bBlit) m_pMipDownsampler->release();
+    }
+    if (result != VK_SUCCESS) return false;
+
+    createTextureImageView();
+    createSampler();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Staging the loaders use, out of the device's ring if it has one. Offsets have to suit the texel size.
+/// A batch hangs on to it until it's been run, otherwise the upload has already finished with it.
+bool VBBTexture::allocateStaging(VkDeviceSize size, VkFormat format, VBBStagingAllocation &staging) {
+    return vbbAllocateStaging(m_pDevice->getStagingRing(), m_VMA, size, staging,
+                              VBBStagingRing::getAlignment(uint32_t(getBytesPerPixel(format))));
+}
+
+void VBBTexture::doneWithStaging(VBBStagingAllocation &staging) {
+    if (m_pUploadBatch != nullptr && m_pUploadBatch->isRecording())
+        m_pUploadBatch->keepStaging(staging);
+    else
+        vbbFreeStaging(staging);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Map the file, decode it into the staging buffer (it's persistently mapped), and upload from there.
+/// No malloc'd copy in between, and the file's pages can go as soon as it's decoded. If the pixels need
+/// converting or mipmapping they're read straight out of the file when they can be, or decoded to scratch
+/// memory first when they can't, because staging memory is slow to read back.
+bool VBBTexture::loadTGATexture(const char *szFileName) {
+    VBBMappedFile file;
+    if (!file.open(szFileName)) return false;
+
+    uint32_t width, height, channels;
+    VkFormat format;
+    size_t size;
+    if (!vbbGetTGAInfo(file.getData(), file.getSize(), &width, &height, &channels, &format, &size)) return false;
+
+    // Anything more than a straight copy goes through the other loader, from the pixels in the
+    // file if they can be used as they are.
+    VBBPixelConversion conversion;
+    VkFormat uploadFormat = chooseUploadFormat(format, conversion);
+    if (uploadFormat == VK_FORMAT_UNDEFINED) return false;
+
+    uint32_t gpuLevels = getGPUMipLevels(uploadFormat, width, height);
+    if (conversion != VBB_PIXELS_COPY || (m_premultiplyAlpha && hasAlpha(format)) || (m_generateMips && gpuLevels == 1)) {
+        std::vector<unsigned char> scratch;
+        const void *pPixels = vbbGetTGAPixels(file.getData(), file.getSize());
+        if (pPixels == nullptr) {
+            scratch.resize(size);
+            if (!vbbDecodeTGA(file.getData(), file.getSize(), scratch.data())) return false;
+            pPixels = scratch.data();
         }
+
+        return loadRawTexture(pPixels, format, channels, width, height, uint32_t(size));
     }
 
-    // Does this really need to be done.... look above?!?
-    transitionImageLayout(textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, imageLayout);
+    VBBStagingAllocation staging;
+    if (!allocateStaging(size, uploadFormat, staging)) return false;
+
+    bool bOK = vbbDecodeTGA(file.getData(), file.getSize(), staging.pData);
+    file.close();
+
+    if (bOK) bOK = uploadImage(staging.buffer, staging.offset, uploadFormat, channels, width, height, uint32_t(size), 1, int(gpuLevels));
+    doneWithStaging(staging);
+    return bOK;
+}
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The image, view and sampler are made here, everything else happens on the upload service's worker.
+/// The mapping goes along with the fill, and is closed once it's been decoded. Mips are built on the
+/// CPU if they're wanted, the transfer queue can't blit.
+VBBUploadTicket VBBTexture::loadTGATexture(const char *szFileName, VBBUploadService &uploader) {
+    std::shared_ptr<VBBMappedFile> pFile(new VBBMappedFile);
+    if (!pFile->open(szFileName)) return 0;
+
+    uint32_t width, height, channels;
+    VkFormat format;
+    size_t size;
+    if (!vbbGetTGAInfo(pFile->getData(), pFile->getSize(), &width, &height, &channels, &format, &size)) return 0;
+
+    VBBPixelConversion conversion;
+    VkFormat uploadFormat = chooseUploadFormat(format, conversion);
+    if (uploadFormat == VK_FORMAT_UNDEFINED) return 0;
+
+    bool bPremultiply = m_premultiplyAlpha && hasAlpha(format);
+    uint32_t destSize;
+    uint32_t sourceSize = vbbGetPixelConversionSizes(conversion, &destSize);
+    size_t totalBytes = size / sourceSize * destSize;
+    if (conversion != VBB_PIXELS_COPY) channels = 4;
+
+    bool bSRGB = false;
+    uint32_t bytesPerPixel = uint32_t(getBytesPerPixel(uploadFormat));
+    uint32_t mipLevels = (m_generateMips && isByteFormat(uploadFormat, bSRGB)) ? vbbGetMipLevelCount(width, height) : 1;
+    if (mipLevels > 1) totalBytes = size_t(vbbGetMipChainSize(width, height, mipLevels, bytesPerPixel));
+
+    if (!createImage(uploadFormat, channels, width, height, uint32_t(totalBytes), int(mipLevels), 0)) return 0;
     createTextureImageView();
     createSampler();
-    return true;
+
+    VBBMipFilter filter = m_mipFilter;
+    bool bStraightCopy = conversion == VBB_PIXELS_COPY && !bPremultiply && mipLevels == 1;
+    VBBUploadFill fill = [=](void *pStaging) -> bool {
+        if (bStraightCopy) return vbbDecodeTGA(pFile->getData(), pFile->getSize(), pStaging);
+
+        std::vector<unsigned char> scratch;
+        const void *pPixels = vbbGetTGAPixels(pFile->getData(), pFile->getSize());
+        if (pPixels == nullptr) {
+            scratch.resize(size);
+            if (!vbbDecodeTGA(pFile->getData(), pFile->getSize(), scratch.data())) return false;
+            pPixels = scratch.data();
+        }
+
+        stagePixels(pPixels, size, pStaging, conversion, bPremultiply, width, height, bytesPerPixel, mipLevels, filter, bSRGB);
+        return true;
+    };
+
+    return uploader.uploadImage(textureImage, uploadFormat, width, height, mipLevels, totalBytes, fill, imageLayout);
 }
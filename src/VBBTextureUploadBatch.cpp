@@ -0,0 +1,81 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include <algorithm>
+#include "VBBTextureUploadBatch.h"
+
+VBBTextureUploadBatch::VBBTextureUploadBatch(VBBDevice* pLogicalDevice)
+    : m_command(pLogicalDevice->getDevice(), pLogicalDevice->getCommandPool(), pLogicalDevice->getQueue()) {}
+
+VBBTextureUploadBatch::~VBBTextureUploadBatch(void) {
+    if (m_bRecording) submit(false);
+    wait();
+}
+
+VkCommandBuffer VBBTextureUploadBatch::begin(void) {
+    if (m_bRecording) return m_command.getCommandBuffer();
+    wait();
+
+    m_textureCount = 0;
+    m_bRecording = true;
+    return m_command.start();
+}
+
+VkResult VBBTextureUploadBatch::submit(bool bWait) {
+    if (!m_bRecording) return VK_NOT_READY;
+    m_bRecording = false;
+
+    VkResult result = m_command.submit();
+    if (result != VK_SUCCESS) {
+        // Never ran, nothing on the GPU is using any of it
+        cleanup();
+        return result;
+    }
+
+    m_bSubmitted = true;
+    return bWait ? wait() : VK_SUCCESS;
+}
+
+VkResult VBBTextureUploadBatch::wait(uint64_t timeout) {
+    if (!m_bSubmitted) return VK_SUCCESS;
+
+    VkResult result = m_command.wait(timeout);
+    if (result == VK_TIMEOUT) return result;
+
+    m_bSubmitted = false;
+    cleanup();
+    return result;
+}
+
+void VBBTextureUploadBatch::releaseAfter(VBBMipDownsampler* pDownsampler) {
+    if (std::find(m_downsamplers.begin(), m_downsamplers.end(), pDownsampler) == m_downsamplers.end())
+        m_downsamplers.push_back(pDownsampler);
+}
+
+void VBBTextureUploadBatch::cleanup(void) {
+    for (size_t i = 0; i < m_staging.size(); i++) vbbFreeStaging(m_staging[i]);
+    m_staging.clear();
+
+    for (size_t i = 0; i < m_downsamplers.size(); i++) m_downsamplers[i]->release();
+    m_downsamplers.clear();
+}
@@ -0,0 +1,523 @@
+/* Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Copyright © 2023 Richard S. Wright Jr. (richard@lunarg.com)
+ *
+ * This software is part of the Vulkan Building Blocks
+ */
+
+#include <string.h>
+#include <chrono>
+#include "VBBUploadService.h"
+#include "VBBUtils.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Set up the ring and the command pool, and start the worker
+VkResult VBBUploadService::init(VBBDevice* pLogicalDevice, VmaAllocator allocator, VkDeviceSize stagingSize) {
+    if (isRunning()) return VK_SUCCESS;
+
+    m_pDevice = pLogicalDevice;
+    m_device = pLogicalDevice->getDevice();
+    m_transferQueue = pLogicalDevice->getTransferQueue();
+    m_transferFamily = pLogicalDevice->getTransferQueueFamily();
+    m_graphicsFamily = pLogicalDevice->getQueueFamily();
+    m_bSharedQueue = pLogicalDevice->isTransferQueueShared();
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_transferFamily;
+    VkResult result = vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool);
+    if (result != VK_SUCCESS) return result;
+
+    m_pRing = pLogicalDevice->getStagingRing();
+    if (m_pRing == nullptr) {
+        m_pOwnRing = new VBBStagingRing;
+        result = m_pOwnRing->init(pLogicalDevice, allocator, stagingSize);
+        if (result != VK_SUCCESS) {
+            delete m_pOwnRing;
+            m_pOwnRing = nullptr;
+            vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+            m_commandPool = VK_NULL_HANDLE;
+            return result;
+        }
+        m_pRing = m_pOwnRing;
+    }
+
+    m_bStop = false;
+    m_bWorkerDone = false;
+    m_worker = std::thread(&VBBUploadService::workerThread, this);
+    return VK_SUCCESS;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The worker drains the queue before it stops. If update() is the one submitting, keep doing that for
+/// it until the worker's finished.
+void VBBUploadService::shutdown(void) {
+    if (!isRunning()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_wakeWorker.notify_one();
+
+    while (m_bSharedQueue && !m_bWorkerDone) {
+        update(VK_NULL_HANDLE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m_worker.join();
+
+    delete m_pOwnRing;
+    m_pOwnRing = nullptr;
+    m_pRing = nullptr;
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+
+    // Nobody's going to acquire these now
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_acquires.empty()) m_completedTicket = m_acquires.back().ticket;
+    m_acquires.clear();
+    m_ticketDone.notify_all();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VBBUploadTicket VBBUploadService::uploadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VBBUploadFill fill) {
+    Request request = {};
+    request.buffer = buffer;
+    request.offset = offset;
+    request.size = size;
+    request.fill = fill;
+    return queueRequest(request);
+}
+
+VBBUploadTicket VBBUploadService::uploadBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const void* pData) {
+    return uploadBuffer(buffer, offset, size, [pData, size](void* pStaging) {
+        memcpy(pStaging, pData, size_t(size));
+        return true;
+    });
+}
+
+VBBUploadTicket VBBUploadService::uploadImage(VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t levels,
+                                              VkDeviceSize size, VBBUploadFill fill, VkImageLayout finalLayout) {
+    Request request = {};
+    request.image = image;
+    request.format = format;
+    request.width = width;
+    request.height = height;
+    request.levels = levels;
+    request.size = size;
+    request.finalLayout = finalLayout;
+    request.fill = fill;
+    return queueRequest(request);
+}
+
+VBBUploadTicket VBBUploadService::queueRequest(Request& request) {
+    if (request.size == 0 || !request.fill) return 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!isRunning() || m_bStop) return 0;
+
+    request.ticket = m_nextTicket++;
+    m_requests.push_back(request);
+    m_wakeWorker.notify_one();
+    return request.ticket;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Render thread side. Submit what the worker couldn't, and take ownership of whatever has arrived.
+void VBBUploadService::update(VkCommandBuffer cmdBuffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t i = 0; i < m_toSubmit.size(); i++) {
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &m_toSubmit[i]->cmdBuffer;
+        if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, m_toSubmit[i]->fence) != VK_SUCCESS) m_toSubmit[i]->bSubmitFailed = true;
+        freeStaging(*m_toSubmit[i], m_toSubmit[i]->bSubmitFailed ? VK_NULL_HANDLE : m_toSubmit[i]->fence);
+        m_toSubmit[i]->bSubmitted = true;
+    }
+    if (!m_toSubmit.empty()) m_wakeWorker.notify_one();
+    m_toSubmit.clear();
+
+    if (cmdBuffer == VK_NULL_HANDLE || m_acquires.empty()) return;
+
+    // Same layouts and family indexes as the release, now it's the destination side that counts
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    for (size_t i = 0; i < m_acquires.size(); i++) {
+        const Acquire& upload = m_acquires[i];
+        if (upload.image == VK_NULL_HANDLE && upload.buffer == VK_NULL_HANDLE) continue;  // Failed before it got anywhere
+
+        if (upload.image != VK_NULL_HANDLE) {
+            VkImageMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = upload.finalLayout;
+            barrier.srcQueueFamilyIndex = m_transferFamily;
+            barrier.dstQueueFamilyIndex = m_graphicsFamily;
+            barrier.image = upload.image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            getAccess(upload, barrier.dstAccessMask);
+            imageBarriers.push_back(barrier);
+        } else {
+            VkBufferMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = m_transferFamily;
+            barrier.dstQueueFamilyIndex = m_graphicsFamily;
+            barrier.buffer = upload.buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            getAccess(upload, barrier.dstAccessMask);
+            bufferBarriers.push_back(barrier);
+        }
+    }
+
+    if (!imageBarriers.empty() || !bufferBarriers.empty())
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+                             uint32_t(bufferBarriers.size()), bufferBarriers.data(), uint32_t(imageBarriers.size()),
+                             imageBarriers.data());
+
+    m_completedTicket = m_acquires.back().ticket;
+    m_acquires.clear();
+    m_ticketDone.notify_all();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Tickets complete in order, so there's just the one number to check
+bool VBBUploadService::isComplete(VBBUploadTicket ticket) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return ticket <= m_completedTicket;
+}
+
+bool VBBUploadService::hasFailed(VBBUploadTicket ticket) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return ticket == 0 || m_failed.count(ticket) != 0;
+}
+
+bool VBBUploadService::wait(VBBUploadTicket ticket) {
+    if (ticket == 0) return false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_ticketDone.wait(lock, [this, ticket] { return ticket <= m_completedTicket; });
+    return m_failed.count(ticket) == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Whatever reads it afterwards. Buffers could be anything.
+void VBBUploadService::getAccess(const Acquire& upload, VkAccessFlags& access) {
+    if (upload.image != VK_NULL_HANDLE)
+        access = VK_ACCESS_SHADER_READ_BIT;
+    else
+        access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The worker. Takes everything that's queued each time round, and checks on what's in flight.
+void VBBUploadService::workerThread(void) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // Don't sleep long if there's something to retire
+        std::chrono::milliseconds sleepTime(m_inFlight.empty() ? 100 : 1);
+        m_wakeWorker.wait_for(lock, sleepTime, [this] { return m_bStop || !m_requests.empty(); });
+
+        lock.unlock();
+        retire(0);
+        lock.lock();
+
+        if (m_requests.empty()) {
+            if (m_bStop) {
+                if (m_inFlight.empty()) break;
+
+                // Nothing else is coming, and the wait above won't sleep any more. Block on the fences instead.
+                lock.unlock();
+                retire(UINT64_MAX);
+                lock.lock();
+            }
+            continue;
+        }
+
+        std::deque<Request> requests;
+        requests.swap(m_requests);
+        lock.unlock();
+        processRequests(requests);
+        lock.lock();
+    }
+
+    m_bWorkerDone = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Fill staging and record the copies, as many as fit in one go. When the ring's full, submit what
+/// there is and wait for it. Anything too big for the ring gets a buffer of its own from it.
+void VBBUploadService::processRequests(std::deque<Request>& requests) {
+    Submission submission;
+    while (!requests.empty()) {
+        Request& request = requests.front();
+
+        if (submission.cmdBuffer == VK_NULL_HANDLE && !beginSubmission(submission)) {
+            // Out of something. Wait for what's in flight to give it back, then give up on this one.
+            if (!m_inFlight.empty()) {
+                retire(UINT64_MAX);
+                continue;
+            }
+
+            std::vector<Acquire> failed(1);
+            failed[0].ticket = request.ticket;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_failed.insert(request.ticket);
+            }
+            completeTickets(failed);
+            requests.pop_front();
+            continue;
+        }
+
+        VkDeviceSize alignment = VBB_STAGING_ALIGNMENT;
+        if (request.image != VK_NULL_HANDLE) alignment = VBBStagingRing::getAlignment(uint32_t(getBytesPerPixel(request.format)));
+
+        VBBStagingAllocation staging;
+        bool bStaged = m_pRing->allocate(request.size, staging, alignment, false);
+        if (!bStaged && request.size <= m_pRing->getSize()) {
+            if (!submission.uploads.empty()) {
+                submit(submission);
+                submission = Submission();
+            }
+            if (!m_inFlight.empty()) {
+                retire(UINT64_MAX);
+                continue;
+            }
+        }
+
+        // Nothing of ours left to wait for. Someone else's, or a buffer of its own.
+        if (!bStaged) bStaged = m_pRing->allocate(request.size, staging, alignment);
+
+        bool bFilled = bStaged && request.fill(staging.pData);
+        recordRequest(submission, request, staging.buffer, staging.offset, bFilled);
+        if (bStaged) submission.staging.push_back(staging);
+        requests.pop_front();
+    }
+
+    if (submission.cmdBuffer != VK_NULL_HANDLE) submit(submission);
+}
+
+bool VBBUploadService::beginSubmission(Submission& submission) {
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(m_device, &allocInfo, &submission.cmdBuffer) != VK_SUCCESS) {
+        submission.cmdBuffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(m_device, &fenceInfo, nullptr, &submission.fence) != VK_SUCCESS) {
+        vkFreeCommandBuffers(m_device, m_commandPool, 1, &submission.cmdBuffer);
+        submission.cmdBuffer = VK_NULL_HANDLE;
+        submission.fence = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(submission.cmdBuffer, &beginInfo);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The copy, then either a release to the graphics family or a plain barrier if it's the same family.
+/// If the fill failed there's no copy, but the image still goes to the layout it was asked for.
+void VBBUploadService::recordRequest(Submission& submission, Request& request, VkBuffer staging, VkDeviceSize stagingOffset,
+                                     bool bFilled) {
+    bool bRelease = needsOwnershipTransfer();
+    Acquire upload = {request.ticket, request.buffer, request.image, request.finalLayout};
+
+    VkAccessFlags dstAccess = 0;
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;  // Release, the acquire does the rest
+    if (!bRelease) {
+        getAccess(upload, dstAccess);
+        dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    if (request.image != VK_NULL_HANDLE) {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = request.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(submission.cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &barrier);
+
+        if (bFilled) {
+            std::vector<VkBufferImageCopy> regions(request.levels);
+            VkDeviceSize offset = stagingOffset;
+            uint32_t width = request.width;
+            uint32_t height = request.height;
+            for (uint32_t m = 0; m < request.levels; m++) {
+                VkBufferImageCopy& region = regions[m];
+                region.bufferOffset = offset;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = m;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = {width, height, 1};
+
+                offset += VkDeviceSize(width) * height * getBytesPerPixel(request.format);
+                if (width > 1) width /= 2;
+                if (height > 1) height /= 2;
+            }
+            vkCmdCopyBufferToImage(submission.cmdBuffer, staging, request.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   uint32_t(regions.size()), regions.data());
+        }
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = request.finalLayout;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dstAccess;
+        if (bRelease) {
+            barrier.srcQueueFamilyIndex = m_transferFamily;
+            barrier.dstQueueFamilyIndex = m_graphicsFamily;
+        }
+        vkCmdPipelineBarrier(submission.cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    } else {
+        if (bFilled) {
+            VkBufferCopy copy = {};
+            copy.srcOffset = stagingOffset;
+            copy.dstOffset = request.offset;
+            copy.size = request.size;
+            vkCmdCopyBuffer(submission.cmdBuffer, staging, request.buffer, 1, &copy);
+        }
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = bRelease ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = bRelease ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = request.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(submission.cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    submission.uploads.push_back(upload);
+    if (!bFilled) submission.failed.push_back(request.ticket);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Straight onto the transfer queue, or over to update() if that's the graphics queue
+void VBBUploadService::submit(Submission& submission) {
+    vkEndCommandBuffer(submission.cmdBuffer);
+
+    if (m_bSharedQueue) {
+        m_inFlight.push_back(submission);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_toSubmit.push_back(&m_inFlight.back());
+        return;
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &submission.cmdBuffer;
+    if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, submission.fence) != VK_SUCCESS) {
+        finishSubmission(submission, true);
+        return;
+    }
+
+    freeStaging(submission, submission.fence);
+    submission.bSubmitted = true;
+    m_inFlight.push_back(submission);
+}
+
+// Back to the ring, which takes it back when the fence signals
+void VBBUploadService::freeStaging(Submission& submission, VkFence fence) {
+    for (size_t i = 0; i < submission.staging.size(); i++) m_pRing->free(submission.staging[i], fence);
+    submission.staging.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Finish everything that's done, oldest first. Waits up to timeout for the oldest one.
+void VBBUploadService::retire(uint64_t timeout) {
+    while (!m_inFlight.empty()) {
+        Submission& submission = m_inFlight.front();
+
+        // The fence can't be touched until it's been submitted (update() does that when the queue is shared)
+        bool bSubmitted, bSubmitFailed;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (timeout != 0) m_wakeWorker.wait(lock, [&submission] { return submission.bSubmitted; });
+            bSubmitted = submission.bSubmitted;
+            bSubmitFailed = submission.bSubmitFailed;
+        }
+        if (!bSubmitted) break;
+        if (!bSubmitFailed && vkWaitForFences(m_device, 1, &submission.fence, VK_TRUE, timeout) != VK_SUCCESS) break;
+        timeout = 0;
+
+        finishSubmission(submission, bSubmitFailed);
+        m_inFlight.pop_front();
+    }
+}
+
+// Done with, one way or another. If it never ran everything in it failed. The ring has to let go of
+// the fence before it goes.
+void VBBUploadService::finishSubmission(Submission& submission, bool bFailed) {
+    freeStaging(submission, VK_NULL_HANDLE);
+    m_pRing->retire();
+    vkDestroyFence(m_device, submission.fence, nullptr);
+    vkFreeCommandBuffers(m_device, m_commandPool, 1, &submission.cmdBuffer);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_failed.insert(submission.failed.begin(), submission.failed.end());
+        if (bFailed)
+            for (size_t i = 0; i < submission.uploads.size(); i++) m_failed.insert(submission.uploads[i].ticket);
+    }
+
+    // Nothing to hand over if it never ran, but the tickets still complete in order
+    for (size_t i = 0; bFailed && i < submission.uploads.size(); i++) {
+        submission.uploads[i].buffer = VK_NULL_HANDLE;
+        submission.uploads[i].image = VK_NULL_HANDLE;
+    }
+    completeTickets(submission.uploads);
+}
+
+void VBBUploadService::completeTickets(const std::vector<Acquire>& uploads) {
+    if (uploads.empty()) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (needsOwnershipTransfer())
+        m_acquires.insert(m_acquires.end(), uploads.begin(), uploads.end());
+    else {
+        m_completedTicket = uploads.back().ticket;
+        m_ticketDone.notify_all();
+    }
+}
@@ -20,7 +20,6 @@
  *
  * This software is part of the Vulkan Building Blocks
  */
-#include <assert.h>
 
 #ifdef VK_NO_PROTOTYPES
 #include <volk/volk.h>
@@ -29,10 +28,20 @@
 #endif
 
 #include "VBBUtils.h"
+#include "VBBMeshFile.h"
+#include "VBBMath.h"
 #include <array>
+#include <algorithm>
+#include <thread>
+#include <string.h>
 
 static const double VBB_PI = 3.14159265358979323846;
 
+// Hash cells are this many epsilons wide. Wider cells mean fewer lookups straddle a cell edge,
+// but more vertices in each cell to compare against. Cells are centered on multiples of the
+// cell size so that common values like 0.0 and 1.0 never sit on an edge.
+static const double VBB_HASH_CELL_SCALE = 32.0;
+
 // Just takes a stab at reserving enough space ahead of time to avoid re-allocation
 void VBBSimpleIndexedMesh::startBuilding(uint32_t estimatedVertexCount, float epsilon) {
     m_vertices.reserve(estimatedVertexCount);
@@ -41,6 +50,39 @@ void VBBSimpleIndexedMesh::startBuilding(uint32_t estimatedVertexCount, float ep
     m_indexes.reserve(estimatedVertexCount);
 
     m_epsilon = epsilon;
+    m_hashDisabled = false;
+
+    // Cell size depends on epsilon, so anything already in the mesh has to be rehashed
+    rebuildHash();
+    m_hashNext.reserve(estimatedVertexCount);
+}
+
+// *********************************************************************************************************
+// Done adding vertices, the hash is only needed while building so give the memory back.
+void VBBSimpleIndexedMesh::endBuilding(void) {
+    std::unordered_map<uint64_t, uint32_t>().swap(m_hashHeads);
+    std::vector<uint32_t>().swap(m_hashNext);
+    m_hashDisabled = false;
+
+    // The sphere grown while adding depends on the order the vertices came in and can be loose, tighten it
+    updateBounds();
+
+    if (m_optimizeOnBuild) optimize();
+}
+
+// *********************************************************************************************************
+// Size everything up front for generators that know exactly what they are making
+void VBBSimpleIndexedMesh::allocateMesh(uint32_t vertexCount, uint32_t indexCount, bool bNormals, bool bTexCoords) {
+    m_vertices.assign(vertexCount, VBBSimpleVertex());
+    m_normals.assign(bNormals ? vertexCount : 0, VBBSimpleNormal());
+    m_texCoords.assign(bTexCoords ? vertexCount : 0, VBBSimpleTexCoord());
+    m_indexes.assign(indexCount, 0);
+
+    m_hashHeads.clear();
+    m_hashNext.clear();
+
+    m_boundsValid = false;
+    m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 }
 
 void VBBSimpleIndexedMesh::addVertex(void* pVertex, void* pNormal, void* pTexCoord, uint32_t searchOnlyLast) {
@@ -57,93 +99,845 @@ void VBBSimpleIndexedMesh::addVertex(VBBSimpleVertex* pVertex, VBBSimpleNormal*
                                      uint32_t searchOnlyLast) {
     uint32_t index = 0;  // Index is currently unknown
 
-    // Start at the beginning, or use the hint
-    uint32_t startIndex = 0;
-    if(searchOnlyLast != 0)
-        if (searchOnlyLast < m_indexes.size()) startIndex = static_cast<uint32_t>(m_vertices.size()) - searchOnlyLast;
-
-    for (uint32_t i = startIndex; i < m_vertices.size(); i++) {
-        index = i;
-        
-        // All we have is vertex positions
-        if (pNormal == nullptr && pTexCoord == nullptr) {
-            if (closeEnough(m_vertices[index].x, pVertex->x) && closeEnough(m_vertices[index].y, pVertex->y) &&
-                closeEnough(m_vertices[index].z, pVertex->z)) {
-                m_indexes.push_back(index);
-                m_vertices.push_back(*pVertex);
-                return;
-            }
-            else continue;
+    // The hash is keyed on whatever attributes we are given, so it only works if every vertex
+    // supplies the same ones. The storage assumes that anyway, but if not, drop the hash and
+    // search linearly until endBuilding(), rather than rebuilding it on every call.
+    uint32_t attributes = ((pNormal != nullptr) ? uint32_t(HASH_NORMALS) : 0u) | ((pTexCoord != nullptr) ? uint32_t(HASH_TEXCOORDS) : 0u);
+    bool bUseHash = (m_useSpatialHash && m_epsilon > 0.0f && !m_hashDisabled);
+    if (bUseHash) {
+        if (m_hashNext.size() != m_vertices.size())  // Loaded, or added to after endBuilding()
+            rebuildHash();
+
+        if (m_vertices.empty()) m_hashAttributes = attributes;
+
+        if (attributes != m_hashAttributes) {
+            m_hashDisabled = true;
+            m_hashHeads.clear();
+            m_hashNext.clear();
+            bUseHash = false;
         }
+    }
+
+    bool bFound;
+    if (searchOnlyLast != 0) {
+        // Only look at the last few, this is still the fastest if you know your data
+        uint32_t startIndex = 0;
+        if (searchOnlyLast < m_vertices.size()) startIndex = static_cast<uint32_t>(m_vertices.size()) - searchOnlyLast;
+        bFound = searchLinear(pVertex, pNormal, pTexCoord, startIndex, index);
+    } else if (bUseHash)
+        bFound = searchHash(pVertex, pNormal, pTexCoord, index);
+    else
+        bFound = searchLinear(pVertex, pNormal, pTexCoord, 0, index);
+
+    if (bFound) {
+        m_indexes.push_back(index);
+        return;
+    }
 
-        // We have/want all three
-        if (pNormal != nullptr && pTexCoord != nullptr) {
-            if (closeEnough(m_vertices[index].x, pVertex->x) && closeEnough(m_vertices[index].y, pVertex->y) &&
-                closeEnough(m_vertices[index].z, pVertex->z) &&
+    // Not found, it's a new one
+    if (m_vertices.empty()) {
+        for (int k = 0; k < 3; k++) m_boundingBox.min[k] = m_boundingBox.max[k] = m_boundingSphere.center[k] = (&pVertex->x)[k];
+        m_boundingSphere.radius = 0.0f;
+        m_boundsValid = true;
+    } else if (m_boundsValid)
+        growBounds(&pVertex->x);
+
+    m_vertices.push_back(*pVertex);
+    if (pNormal != nullptr) m_normals.push_back(*pNormal);
+    if (pTexCoord != nullptr) m_texCoords.push_back(*pTexCoord);
+
+    index = static_cast<uint32_t>(m_vertices.size()) - 1;
+    m_indexes.push_back(index);
+
+    if (bUseHash) insertHash(index);
+}
+
+// *********************************************************************************************************
+// Stretch the box, and move the sphere toward the point just enough to take it in (Ritter)
+void VBBSimpleIndexedMesh::growBounds(const float* pPoint) {
+    for (int k = 0; k < 3; k++) {
+        if (pPoint[k] < m_boundingBox.min[k]) m_boundingBox.min[k] = pPoint[k];
+        if (pPoint[k] > m_boundingBox.max[k]) m_boundingBox.max[k] = pPoint[k];
+    }
+
+    growSphere(m_boundingSphere, pPoint);
+}
+
+void VBBSimpleIndexedMesh::growSphere(VBBBoundingSphere& sphere, const float* pPoint) {
+    float d[3] = {pPoint[0] - sphere.center[0], pPoint[1] - sphere.center[1], pPoint[2] - sphere.center[2]};
+    float distanceSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    if (distanceSq <= sphere.radius * sphere.radius) return;
+
+    float distance = sqrtf(distanceSq);
+    float radius = (sphere.radius + distance) * 0.5f;
+    float move = (radius - sphere.radius) / distance;
+    for (int k = 0; k < 3; k++) sphere.center[k] += d[k] * move;
+
+    // Rounding can leave the point a hair outside
+    sphere.radius = radius * (1.0f + FLT_EPSILON * 4.0f);
+}
 
-                closeEnough(m_normals[index].x, pNormal->x) && closeEnough(m_normals[index].y, pNormal->y) &&
-                closeEnough(m_normals[index].z, pNormal->z) &&
+// *********************************************************************************************************
+// Everything from scratch. The box is exact. The sphere starts as Ritter's, from the two farthest apart
+// of the six points on the box faces, then gets shrunk and regrown a few times keeping the smallest
+// that still holds everything. Usually within a few percent of the minimum sphere.
+void VBBSimpleIndexedMesh::updateBounds(void) {
+    m_boundsValid = true;
+    if (m_vertices.empty()) {
+        m_boundingBox = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+        m_boundingSphere = {{0.0f, 0.0f, 0.0f}, 0.0f};
+        return;
+    }
 
-                closeEnough(m_texCoords[index].s, pTexCoord->s) && closeEnough(m_texCoords[index].t, pTexCoord->t)) {
-                m_indexes.push_back(index);
-                return;
+    const uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+    uint32_t minIndex[3] = {0, 0, 0};
+    uint32_t maxIndex[3] = {0, 0, 0};
+    for (int k = 0; k < 3; k++) m_boundingBox.min[k] = m_boundingBox.max[k] = (&m_vertices[0].x)[k];
+
+    for (uint32_t v = 1; v < vertexCount; v++) {
+        const float* p = &m_vertices[v].x;
+        for (int k = 0; k < 3; k++) {
+            if (p[k] < m_boundingBox.min[k]) {
+                m_boundingBox.min[k] = p[k];
+                minIndex[k] = v;
             }
-            else continue;
+            if (p[k] > m_boundingBox.max[k]) {
+                m_boundingBox.max[k] = p[k];
+                maxIndex[k] = v;
+            }
+        }
+    }
+
+    // Widest pair of extremes makes the first guess
+    int axis = 0;
+    float widest = -1.0f;
+    for (int k = 0; k < 3; k++) {
+        const float* a = &m_vertices[minIndex[k]].x;
+        const float* b = &m_vertices[maxIndex[k]].x;
+        float lengthSq = (b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) + (b[2] - a[2]) * (b[2] - a[2]);
+        if (lengthSq > widest) {
+            widest = lengthSq;
+            axis = k;
+        }
+    }
+
+    const float* a = &m_vertices[minIndex[axis]].x;
+    const float* b = &m_vertices[maxIndex[axis]].x;
+    VBBBoundingSphere best;
+    for (int k = 0; k < 3; k++) best.center[k] = (a[k] + b[k]) * 0.5f;
+    best.radius = sqrtf(widest) * 0.5f;
+    for (uint32_t v = 0; v < vertexCount; v++) growSphere(best, &m_vertices[v].x);
+
+    // Shrink and regrow, walking the points from a different place each time since the order matters
+    const int passes = 8;
+    for (int pass = 1; pass <= passes; pass++) {
+        VBBBoundingSphere sphere = best;
+        sphere.radius *= 0.95f;
+
+        uint32_t start = static_cast<uint32_t>((uint64_t(vertexCount) * pass) / (passes + 1));
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            uint32_t v = start + i;
+            if (v >= vertexCount) v -= vertexCount;
+            growSphere(sphere, &m_vertices[v].x);
+        }
+
+        if (sphere.radius < best.radius) best = sphere;
+    }
+
+    // Box shaped meshes can do better around the box center
+    VBBBoundingSphere boxSphere;
+    float radiusSq = 0.0f;
+    for (int k = 0; k < 3; k++) boxSphere.center[k] = (m_boundingBox.min[k] + m_boundingBox.max[k]) * 0.5f;
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        const float* p = &m_vertices[v].x;
+        float d[3] = {p[0] - boxSphere.center[0], p[1] - boxSphere.center[1], p[2] - boxSphere.center[2]};
+        float distanceSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        if (distanceSq > radiusSq) radiusSq = distanceSq;
+    }
+    boxSphere.radius = sqrtf(radiusSq) * (1.0f + FLT_EPSILON * 4.0f);
+
+    m_boundingSphere = (boxSphere.radius < best.radius) ? boxSphere : best;
+}
+
+// *********************************************************************************************************
+// Normals get the inverse transpose, so non-uniform scales don't bend them
+void VBBSimpleIndexedMesh::transform(const float matrix[16]) {
+    uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+    if (vertexCount == 0) return;
+
+    vbbTransformPoints(matrix, &m_vertices[0].x, &m_vertices[0].x, vertexCount);
+    m_boundsValid = false;
+
+    float normalMatrix[9];
+    float determinant = vbbGetNormalMatrix(matrix, normalMatrix);
+    if (m_normals.size() == vertexCount) {
+        vbbTransformVectors(normalMatrix, &m_normals[0].x, &m_normals[0].x, vertexCount);
+        vbbNormalizeArray(&m_normals[0].x, vertexCount);
+    }
+
+    if (determinant >= 0.0f) return;
+
+    // Mirrored. Swap two corners of each triangle, or run each strip backwards. Backwards only flips an
+    // odd length strip, even ones (all of the generated ones) get their first index doubled up instead,
+    // which adds a degenerate triangle and shifts the rest over by one.
+    if (m_topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {
+        for (size_t i = 0; i + 2 < m_indexes.size(); i += 3) std::swap(m_indexes[i + 1], m_indexes[i + 2]);
+        return;
+    }
+
+    std::vector<uint32_t> indexes;
+    indexes.reserve(m_indexes.size() + 16);
+    size_t start = 0;
+    for (size_t i = 0; i <= m_indexes.size(); i++) {
+        if (i < m_indexes.size() && m_indexes[i] != VBB_PRIMITIVE_RESTART_INDEX) continue;
+
+        size_t length = i - start;
+        if (length & 1)
+            indexes.insert(indexes.end(), m_indexes.rbegin() + (m_indexes.size() - i), m_indexes.rbegin() + (m_indexes.size() - start));
+        else if (length > 0) {
+            indexes.push_back(m_indexes[start]);
+            indexes.insert(indexes.end(), m_indexes.begin() + start, m_indexes.begin() + i);
+        }
+
+        if (i < m_indexes.size()) indexes.push_back(VBB_PRIMITIVE_RESTART_INDEX);
+        start = i + 1;
+    }
+
+    m_indexes.swap(indexes);
+}
+
+// *********************************************************************************************************
+// Get the indexes in whatever size getIndexType() says. Indexes are always built as 32-bit, the 16-bit
+// copy is made here when asked for.
+void* VBBSimpleIndexedMesh::getIndexData(void) {
+    if (getIndexType() == VK_INDEX_TYPE_UINT32) return m_indexes.data();
+
+    m_indexes16.resize(m_indexes.size());
+    for (size_t i = 0; i < m_indexes.size(); i++) m_indexes16[i] = static_cast<uint16_t>(m_indexes[i]);
+
+    return m_indexes16.data();
+}
+
+// *********************************************************************************************************
+// Does the vertex at index match what was passed in? Only the attributes passed in are compared.
+bool VBBSimpleIndexedMesh::isMatch(uint32_t index, VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal,
+                                   VBBSimpleTexCoord* pTexCoord) {
+    if (!closeEnough(m_vertices[index].x, pVertex->x) || !closeEnough(m_vertices[index].y, pVertex->y) ||
+        !closeEnough(m_vertices[index].z, pVertex->z))
+        return false;
+
+    if (pNormal != nullptr)
+        if (!closeEnough(m_normals[index].x, pNormal->x) || !closeEnough(m_normals[index].y, pNormal->y) ||
+            !closeEnough(m_normals[index].z, pNormal->z))
+            return false;
+
+    if (pTexCoord != nullptr)
+        if (!closeEnough(m_texCoords[index].s, pTexCoord->s) || !closeEnough(m_texCoords[index].t, pTexCoord->t)) return false;
+
+    return true;
+}
+
+// *********************************************************************************************************
+// The old brute force way. Finds the first match starting at startIndex.
+bool VBBSimpleIndexedMesh::searchLinear(VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord,
+                                        uint32_t startIndex, uint32_t& index) {
+    for (uint32_t i = startIndex; i < m_vertices.size(); i++)
+        if (isMatch(i, pVertex, pNormal, pTexCoord)) {
+            index = i;
+            return true;
+        }
+
+    return false;
+}
+
+// *********************************************************************************************************
+// Pack up to 8 floats (position, normal, texture coordinate) that make up the hash key
+static uint32_t gatherHashKey(const float* pVertex, const float* pNormal, const float* pTexCoord, float key[8]) {
+    uint32_t count = 0;
+    key[count++] = pVertex[0];
+    key[count++] = pVertex[1];
+    key[count++] = pVertex[2];
+
+    if (pNormal != nullptr) {
+        key[count++] = pNormal[0];
+        key[count++] = pNormal[1];
+        key[count++] = pNormal[2];
+    }
+
+    if (pTexCoord != nullptr) {
+        key[count++] = pTexCoord[0];
+        key[count++] = pTexCoord[1];
+    }
+
+    return count;
+}
+
+// Cell a value lands in. Anything past what an int64 holds (and NaN) goes in the cell at the end
+// instead, those can only match by comparing anyway, so it's a long chain and not a wrong answer.
+static inline int64_t hashCell(double value, double cellSize) {
+    double cell = floor(value / cellSize + 0.5);
+    if (!(cell > -9.0e18)) return INT64_MIN;
+    if (cell > 9.0e18) return INT64_MAX;
+    return static_cast<int64_t>(cell);
+}
+
+// Combine the quantized cell coordinates into one 64-bit key
+static uint64_t hashCells(const int64_t* pCells, uint32_t count) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t i = 0; i < count; i++) {
+        hash ^= static_cast<uint64_t>(pCells[i]) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// *********************************************************************************************************
+// Add a vertex that is already in the mesh to the hash
+void VBBSimpleIndexedMesh::insertHash(uint32_t index) {
+    float key[8];
+    int64_t cells[8];
+    uint32_t count =
+        gatherHashKey(&m_vertices[index].x, (m_hashAttributes & HASH_NORMALS) ? &m_normals[index].x : nullptr,
+                      (m_hashAttributes & HASH_TEXCOORDS) ? &m_texCoords[index].s : nullptr, key);
+
+    for (uint32_t i = 0; i < count; i++) cells[i] = hashCell(double(key[i]), m_cellSize);
+
+    uint64_t hash = hashCells(cells, count);
+
+    // Push onto the front of the chain for this cell
+    std::unordered_map<uint64_t, uint32_t>::iterator it = m_hashHeads.find(hash);
+    if (it == m_hashHeads.end()) {
+        m_hashNext.push_back(HASH_END);
+        m_hashHeads[hash] = index;
+    } else {
+        m_hashNext.push_back(it->second);
+        it->second = index;
+    }
+}
+
+// *********************************************************************************************************
+// Look for a match in the hash. Cells are much wider than epsilon, so anything within epsilon of a value is
+// either in the same cell or the neighbor on one side. We only have to visit the neighbor when the value is
+// within epsilon of a cell edge, so this is usually a single lookup. If there is more than one match, the
+// lowest index wins, which is what the linear search would have found.
+bool VBBSimpleIndexedMesh::searchHash(VBBSimpleVertex* pVertex, VBBSimpleNormal* pNormal, VBBSimpleTexCoord* pTexCoord,
+                                      uint32_t& index) {
+    float key[8];
+    int64_t lowCells[8];
+    int64_t highCells[8];
+    int64_t cells[8];
+    uint32_t straddleMask = 0;
+    uint32_t count = gatherHashKey(&pVertex->x, (pNormal != nullptr) ? &pNormal->x : nullptr,
+                                   (pTexCoord != nullptr) ? &pTexCoord->s : nullptr, key);
+
+    for (uint32_t i = 0; i < count; i++) {
+        lowCells[i] = hashCell(double(key[i]) - m_epsilon, m_cellSize);
+        highCells[i] = hashCell(double(key[i]) + m_epsilon, m_cellSize);
+        if (lowCells[i] != highCells[i]) straddleMask |= (1 << i);
+    }
+
+    uint32_t best = HASH_END;
+
+    // Walk every combination of low/high cells, but only for the values that straddle an edge
+    uint32_t subset = straddleMask;
+    while (true) {
+        for (uint32_t i = 0; i < count; i++) cells[i] = (subset & (1 << i)) ? highCells[i] : lowCells[i];
+
+        std::unordered_map<uint64_t, uint32_t>::iterator it = m_hashHeads.find(hashCells(cells, count));
+        if (it != m_hashHeads.end())
+            for (uint32_t i = it->second; i != HASH_END; i = m_hashNext[i])
+                if (i < best && isMatch(i, pVertex, pNormal, pTexCoord)) best = i;
+
+        if (subset == 0) break;
+        subset = (subset - 1) & straddleMask;
+    }
+
+    if (best == HASH_END) return false;
+
+    index = best;
+    return true;
+}
+
+// *********************************************************************************************************
+// Throw away the hash and put back whatever is in the mesh already.
+void VBBSimpleIndexedMesh::rebuildHash(void) {
+    m_hashHeads.clear();
+    m_hashNext.clear();
+    m_cellSize = VBB_HASH_CELL_SCALE * double(m_epsilon);
+
+    if (!m_useSpatialHash || m_epsilon <= 0.0f) return;
+
+    // Figure out what we have from what is stored
+    m_hashAttributes = 0;
+    if (!m_vertices.empty() && m_normals.size() == m_vertices.size()) m_hashAttributes |= HASH_NORMALS;
+    if (!m_vertices.empty() && m_texCoords.size() == m_vertices.size()) m_hashAttributes |= HASH_TEXCOORDS;
+
+    m_hashNext.reserve(m_vertices.size());
+    for (uint32_t i = 0; i < m_vertices.size(); i++) insertHash(i);
+}
+
+// *********************************************************************************************************
+// Forsyth's "Linear-Speed Vertex Cache Optimisation". Triangles are scored by how recently their vertices
+// were used (a simulated LRU cache), plus a boost for vertices with few triangles left, so we finish off
+// vertices rather than leave stragglers behind. Greedily emit the best triangle that touches the cache.
+static const uint32_t VBB_FORSYTH_MAX_VALENCE = 64;
+
+static float forsythVertexScore(int32_t cachePosition, uint32_t remaining, uint32_t cacheSize) {
+    if (remaining == 0) return -1.0f;  // Nothing left to do with this one
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3)  // Was in the last triangle, doesn't matter which way it goes
+            score = 0.75f;
+        else {
+            score = 1.0f - float(cachePosition - 3) / float(cacheSize - 3);
+            score = powf(score, 1.5f);
+        }
+    }
+
+    if (remaining > VBB_FORSYTH_MAX_VALENCE) remaining = VBB_FORSYTH_MAX_VALENCE;
+    return score + 2.0f * powf(float(remaining), -0.5f);
+}
+
+void VBBSimpleIndexedMesh::optimizeVertexCache(uint32_t cacheSize) {
+    if (m_topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) return;  // Strips from the generators are in cache order already
+
+    uint32_t triangleCount = static_cast<uint32_t>(m_indexes.size() / 3);
+    uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+    if (triangleCount == 0) return;
+    if (cacheSize < 4) cacheSize = 4;
+
+    // Which triangles use each vertex. The first remaining[v] entries are the ones not emitted yet.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t i = 0; i < triangleCount * 3; i++) remaining[m_indexes[i]]++;
+
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (uint32_t i = 0; i < triangleCount * 3; i++) vertexTriangles[fill[m_indexes[i]]++] = i / 3;
+
+    // Score lookup tables, saves a lot of powf()
+    std::vector<float> cacheScores((cacheSize + 3) * (VBB_FORSYTH_MAX_VALENCE + 1));
+    for (uint32_t p = 0; p < cacheSize + 3; p++)
+        for (uint32_t r = 0; r <= VBB_FORSYTH_MAX_VALENCE; r++)
+            cacheScores[p * (VBB_FORSYTH_MAX_VALENCE + 1) + r] =
+                forsythVertexScore((p < cacheSize) ? int32_t(p) : -1, r, cacheSize);
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) vertexScore[v] = forsythVertexScore(-1, remaining[v], cacheSize);
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> newIndexes;
+    newIndexes.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(cacheSize + 3);
+    newCache.reserve(cacheSize + 3);
+
+    uint32_t nextUnused = 0;  // Where to look when nothing in the cache is any good
+    int64_t bestTriangle = -1;
+    float bestScore = -1.0f;
+
+    // Start with the best triangle of all
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        float score = vertexScore[m_indexes[t * 3]] + vertexScore[m_indexes[t * 3 + 1]] + vertexScore[m_indexes[t * 3 + 2]];
+        if (score > bestScore) {
+            bestScore = score;
+            bestTriangle = t;
+        }
+    }
+
+    for (uint32_t n = 0; n < triangleCount; n++) {
+        if (bestTriangle < 0) {  // Dead end, take the next one in the original order
+            while (emitted[nextUnused]) nextUnused++;
+            bestTriangle = nextUnused;
+        }
+
+        uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+        const uint32_t* pCorners = &m_indexes[triangle * 3];
+        emitted[triangle] = true;
+        newIndexes.push_back(pCorners[0]);
+        newIndexes.push_back(pCorners[1]);
+        newIndexes.push_back(pCorners[2]);
+
+        // Take this triangle out of each vertex's list
+        for (uint32_t c = 0; c < 3; c++) {
+            uint32_t v = pCorners[c];
+            uint32_t* pList = &vertexTriangles[firstTriangle[v]];
+            for (uint32_t i = 0; i < remaining[v]; i++)
+                if (pList[i] == triangle) {
+                    pList[i] = pList[remaining[v] - 1];
+                    pList[remaining[v] - 1] = triangle;
+                    remaining[v]--;
+                    break;
+                }
         }
 
-        // We have normals, but no texture coordinates
-        if (pNormal != nullptr && pTexCoord == nullptr) {
-            if (closeEnough(m_vertices[index].x, pVertex->x) && closeEnough(m_vertices[index].y, pVertex->y) &&
-                closeEnough(m_vertices[index].z, pVertex->z) &&
+        // This triangle goes to the front of the cache, everything else moves back
+        newCache.clear();
+        for (uint32_t c = 0; c < 3; c++)
+            if (std::find(newCache.begin(), newCache.end(), pCorners[c]) == newCache.end()) newCache.push_back(pCorners[c]);
+
+        for (size_t i = 0; i < cache.size(); i++)
+            if (std::find(newCache.begin(), newCache.end(), cache[i]) == newCache.end()) newCache.push_back(cache[i]);
 
-                closeEnough(m_normals[index].x, pNormal->x) && closeEnough(m_normals[index].y, pNormal->y) &&
-                closeEnough(m_normals[index].z, pNormal->z)) {
-                m_indexes.push_back(index);
-                return;
+        // Rescore everything that was touched, the ones that fell off the end included
+        for (size_t i = 0; i < newCache.size(); i++) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = (i < cacheSize) ? int32_t(i) : -1;
+            uint32_t r = (remaining[v] > VBB_FORSYTH_MAX_VALENCE) ? VBB_FORSYTH_MAX_VALENCE : remaining[v];
+            vertexScore[v] = cacheScores[((i < cacheSize) ? i : cacheSize) * (VBB_FORSYTH_MAX_VALENCE + 1) + r];
+        }
+
+        if (newCache.size() > cacheSize) newCache.resize(cacheSize);
+        cache.swap(newCache);
+
+        // Best triangle that uses something in the cache
+        bestTriangle = -1;
+        bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++) {
+            uint32_t v = cache[i];
+            const uint32_t* pList = &vertexTriangles[firstTriangle[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                const uint32_t* pTri = &m_indexes[pList[j] * 3];
+                float score = vertexScore[pTri[0]] + vertexScore[pTri[1]] + vertexScore[pTri[2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = pList[j];
+                }
             }
-            else continue;
         }
+    }
+
+    m_indexes.swap(newIndexes);
+    m_hashNext.clear();  // Hash doesn't know about any of this, rebuild if more vertices are added
+}
+
+// *********************************************************************************************************
+// Renumber vertices in the order the index buffer first uses them, so vertex fetch walks memory forward.
+// Vertices that are never used end up at the end.
+void VBBSimpleIndexedMesh::optimizeVertexFetch(void) {
+    uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+    std::vector<uint32_t> remap(vertexCount, HASH_END);
+    uint32_t next = 0;
+
+    for (size_t i = 0; i < m_indexes.size(); i++) {
+        uint32_t v = m_indexes[i];
+        if (v == VBB_PRIMITIVE_RESTART_INDEX) continue;
+        if (remap[v] == HASH_END) remap[v] = next++;
+        m_indexes[i] = remap[v];
+    }
+
+    for (uint32_t v = 0; v < vertexCount; v++)
+        if (remap[v] == HASH_END) remap[v] = next++;
+
+    std::vector<VBBSimpleVertex> vertices(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) vertices[remap[v]] = m_vertices[v];
+    m_vertices.swap(vertices);
+
+    if (m_normals.size() == vertexCount) {
+        std::vector<VBBSimpleNormal> normals(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) normals[remap[v]] = m_normals[v];
+        m_normals.swap(normals);
+    }
+
+    if (m_texCoords.size() == vertexCount) {
+        std::vector<VBBSimpleTexCoord> texCoords(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) texCoords[remap[v]] = m_texCoords[v];
+        m_texCoords.swap(texCoords);
+    }
+
+    m_hashNext.clear();
+}
+
+// *********************************************************************************************************
+// Run the index buffer through a FIFO cache of the given size and count the misses. A restart doesn't
+// flush the cache.
+uint32_t VBBSimpleIndexedMesh::countCacheMisses(uint32_t cacheSize) {
+    std::vector<uint32_t> timeStamp(m_vertices.size(), 0);
+    uint32_t time = cacheSize + 1;  // Nothing starts out in the cache
+    uint32_t misses = 0;
+
+    size_t indexCount = m_indexes.size();
+    if (m_topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) indexCount = (indexCount / 3) * 3;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = m_indexes[i];
+        if (v == VBB_PRIMITIVE_RESTART_INDEX) continue;
+        if (time - timeStamp[v] > cacheSize) {
+            timeStamp[v] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+float VBBSimpleIndexedMesh::getACMR(uint32_t cacheSize) {
+    uint32_t triangleCount = getTriangleCount();
+    if (triangleCount == 0) return 0.0f;
+
+    return float(countCacheMisses(cacheSize)) / float(triangleCount);
+}
+
+// Each strip of n indexes is n - 2 triangles. Degenerate ones are counted too, the GPU still has to
+// look at them.
+uint32_t VBBSimpleIndexedMesh::getTriangleCount(void) {
+    if (m_topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) return static_cast<uint32_t>(m_indexes.size() / 3);
+
+    uint32_t triangleCount = 0;
+    uint32_t stripLength = 0;
+    for (size_t i = 0; i <= m_indexes.size(); i++) {
+        if (i == m_indexes.size() || m_indexes[i] == VBB_PRIMITIVE_RESTART_INDEX) {
+            if (stripLength > 2) triangleCount += stripLength - 2;
+            stripLength = 0;
+        } else
+            stripLength++;
+    }
+
+    return triangleCount;
+}
+
+float VBBSimpleIndexedMesh::getATVR(uint32_t cacheSize) {
+    if (m_vertices.empty()) return 0.0f;
+
+    return float(countCacheMisses(cacheSize)) / float(m_vertices.size());
+}
+
+// *********************************************************************************************************
+// Work out the offsets and stride for an interleaved vertex. Fails if the mesh doesn't have one of the
+// attributes asked for, an attribute is listed twice, an encoding doesn't fit the attribute, or the
+// stride asked for is too small.
+bool VBBSimpleIndexedMesh::makeInterleavedLayout(VBBInterleavedLayout& layout, uint32_t attributeCount,
+                                                 const VBBMeshAttribute* pAttributes, uint32_t alignment, uint32_t stride,
+                                                 const VBBMeshEncoding* pEncodings) {
+    if (attributeCount == 0 || attributeCount > VBB_MESH_ATTRIBUTE_COUNT || pAttributes == nullptr) return false;
+
+    if (alignment == 0) alignment = 1;
+
+    uint32_t offset = 0;
+    bool bUsed[VBB_MESH_ATTRIBUTE_COUNT] = {false, false, false};
+    for (uint32_t i = 0; i < attributeCount; i++) {
+        VBBMeshAttribute attribute = pAttributes[i];
+        if (attribute >= VBB_MESH_ATTRIBUTE_COUNT || bUsed[attribute]) return false;
+        bUsed[attribute] = true;
+
+        VBBMeshEncoding encoding = (pEncodings != nullptr) ? pEncodings[i] : VBB_MESH_ENCODING_FLOAT;
+
+        uint32_t size = 0;
+        switch (attribute) {
+            case VBB_MESH_ATTRIBUTE_POSITION:
+                if (encoding == VBB_MESH_ENCODING_FLOAT) {
+                    layout.formats[i] = VK_FORMAT_R32G32B32_SFLOAT;
+                    size = sizeof(VBBSimpleVertex);
+                } else if (encoding == VBB_MESH_ENCODING_HALF) {
+                    layout.formats[i] = VK_FORMAT_R16G16B16A16_SFLOAT;  // Three component 16-bit formats are
+                    size = 4 * sizeof(uint16_t);                        // rarely supported for vertices
+                } else if (encoding == VBB_MESH_ENCODING_SNORM16) {
+                    layout.formats[i] = VK_FORMAT_R16G16B16A16_SNORM;
+                    size = 4 * sizeof(int16_t);
+                } else
+                    return false;
+                break;
+
+            case VBB_MESH_ATTRIBUTE_NORMAL:
+                if (m_normals.size() != m_vertices.size()) return false;
+                if (encoding == VBB_MESH_ENCODING_FLOAT) {
+                    layout.formats[i] = VK_FORMAT_R32G32B32_SFLOAT;
+                    size = sizeof(VBBSimpleNormal);
+                } else if (encoding == VBB_MESH_ENCODING_OCTAHEDRAL) {
+                    layout.formats[i] = VK_FORMAT_R16G16_SNORM;
+                    size = 2 * sizeof(int16_t);
+                } else
+                    return false;
+                break;
+
+            case VBB_MESH_ATTRIBUTE_TEXCOORD:
+                if (m_texCoords.size() != m_vertices.size()) return false;
+                if (encoding == VBB_MESH_ENCODING_FLOAT) {
+                    layout.formats[i] = VK_FORMAT_R32G32_SFLOAT;
+                    size = sizeof(VBBSimpleTexCoord);
+                } else if (encoding == VBB_MESH_ENCODING_HALF) {
+                    layout.formats[i] = VK_FORMAT_R16G16_SFLOAT;
+                    size = 2 * sizeof(uint16_t);
+                } else if (encoding == VBB_MESH_ENCODING_UNORM16) {
+                    layout.formats[i] = VK_FORMAT_R16G16_UNORM;
+                    size = 2 * sizeof(uint16_t);
+                } else
+                    return false;
+                break;
+
+            default:
+                return false;
+        }
+
+        offset = ((offset + alignment - 1) / alignment) * alignment;
+        layout.attributes[i] = attribute;
+        layout.encodings[i] = encoding;
+        layout.offsets[i] = offset;
+        offset += size;
+    }
+
+    uint32_t packedStride = ((offset + alignment - 1) / alignment) * alignment;
+    if (stride == 0)
+        stride = packedStride;
+    else if (stride < offset)
+        return false;
+
+    // Normalized positions are relative to the center of the bounding box, scaled by half its size
+    for (int k = 0; k < 3; k++) {
+        layout.positionScale[k] = 1.0f;
+        layout.positionOffset[k] = 0.0f;
+    }
+
+    bool bNormalizedPositions = false;
+    for (uint32_t i = 0; i < attributeCount; i++)
+        if (layout.attributes[i] == VBB_MESH_ATTRIBUTE_POSITION && layout.encodings[i] == VBB_MESH_ENCODING_SNORM16)
+            bNormalizedPositions = true;
+
+    if (bNormalizedPositions && !m_vertices.empty()) {
+        const VBBBoundingBox& bounds = getBoundingBox();
+        for (int k = 0; k < 3; k++) {
+            layout.positionOffset[k] = (bounds.min[k] + bounds.max[k]) * 0.5f;
+            layout.positionScale[k] = (bounds.max[k] - bounds.min[k]) * 0.5f;
+            if (layout.positionScale[k] <= 0.0f) layout.positionScale[k] = 1.0f;  // Flat in this direction
+        }
+    }
+
+    layout.attributeCount = attributeCount;
+    layout.stride = stride;
+    return true;
+}
+
+static inline int16_t toSnorm16(float value) {
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return static_cast<int16_t>(lrintf(value * 32767.0f));
+}
 
-        // We have no normals, but we do have texture coordinates
-        if (pNormal == nullptr && pTexCoord != nullptr) {
-            if (closeEnough(m_vertices[index].x, pVertex->x) && closeEnough(m_vertices[index].y, pVertex->y) &&
-                closeEnough(m_vertices[index].z, pVertex->z) &&
+static inline uint16_t toUnorm16(float value) {
+    if (value > 1.0f) value = 1.0f;
+    if (value < 0.0f) value = 0.0f;
+    return static_cast<uint16_t>(lrintf(value * 65535.0f));
+}
 
-                closeEnough(m_texCoords[index].s, pTexCoord->s) && closeEnough(m_texCoords[index].t, pTexCoord->t)) {
-                m_indexes.push_back(index);
-                return;
+// *********************************************************************************************************
+// Write the interleaved vertices to pDest, which must hold getInterleavedSize() bytes. This can
+// go straight into mapped buffer memory. Any padding is zeroed. Each vertex is put together on
+// the side and written once, whole, which is what write-combined memory likes.
+void VBBSimpleIndexedMesh::copyInterleaved(const VBBInterleavedLayout& layout, void* pDest) {
+    unsigned char* pOut = static_cast<unsigned char*>(pDest);
+
+    // Attributes land in the same places every time, so the padding stays zero
+    std::vector<unsigned char> vertex(layout.stride, 0);
+    unsigned char* pVertex = vertex.data();
+
+    float invScale[3];
+    for (int k = 0; k < 3; k++) invScale[k] = 1.0f / layout.positionScale[k];
+
+    for (size_t v = 0; v < m_vertices.size(); v++) {
+        for (uint32_t i = 0; i < layout.attributeCount; i++) {
+            unsigned char* pAttribute = pVertex + layout.offsets[i];
+
+            switch (layout.attributes[i]) {
+                case VBB_MESH_ATTRIBUTE_POSITION:
+                    if (layout.encodings[i] == VBB_MESH_ENCODING_HALF) {
+                        uint16_t half[4] = {vbbFloatToHalf(m_vertices[v].x), vbbFloatToHalf(m_vertices[v].y),
+                                            vbbFloatToHalf(m_vertices[v].z), vbbFloatToHalf(1.0f)};
+                        memcpy(pAttribute, half, sizeof(half));
+                    } else if (layout.encodings[i] == VBB_MESH_ENCODING_SNORM16) {
+                        int16_t snorm[4] = {toSnorm16((m_vertices[v].x - layout.positionOffset[0]) * invScale[0]),
+                                            toSnorm16((m_vertices[v].y - layout.positionOffset[1]) * invScale[1]),
+                                            toSnorm16((m_vertices[v].z - layout.positionOffset[2]) * invScale[2]), 32767};
+                        memcpy(pAttribute, snorm, sizeof(snorm));
+                    } else
+                        memcpy(pAttribute, &m_vertices[v], sizeof(VBBSimpleVertex));
+                    break;
+
+                case VBB_MESH_ATTRIBUTE_NORMAL:
+                    if (layout.encodings[i] == VBB_MESH_ENCODING_OCTAHEDRAL) {
+                        int16_t oct[2];
+                        vbbOctahedralEncode(&m_normals[v].x, oct);
+                        memcpy(pAttribute, oct, sizeof(oct));
+                    } else
+                        memcpy(pAttribute, &m_normals[v], sizeof(VBBSimpleNormal));
+                    break;
+
+                case VBB_MESH_ATTRIBUTE_TEXCOORD:
+                    if (layout.encodings[i] == VBB_MESH_ENCODING_HALF) {
+                        uint16_t half[2] = {vbbFloatToHalf(m_texCoords[v].s), vbbFloatToHalf(m_texCoords[v].t)};
+                        memcpy(pAttribute, half, sizeof(half));
+                    } else if (layout.encodings[i] == VBB_MESH_ENCODING_UNORM16) {
+                        uint16_t unorm[2] = {toUnorm16(m_texCoords[v].s), toUnorm16(m_texCoords[v].t)};
+                        memcpy(pAttribute, unorm, sizeof(unorm));
+                    } else
+                        memcpy(pAttribute, &m_texCoords[v], sizeof(VBBSimpleTexCoord));
+                    break;
+
+                default:
+                    break;
             }
-            else continue;
         }
+
+        memcpy(pOut, pVertex, layout.stride);
+        pOut += layout.stride;
     }
+}
 
-    m_vertices.push_back(*pVertex);
-    if (pNormal != nullptr) m_normals.push_back(*pNormal);
-    if (pTexCoord != nullptr) m_texCoords.push_back(*pTexCoord);
-    if(m_vertices.size() == 1)
-        m_indexes.push_back(0);
-    else
-        m_indexes.push_back((index+1));
-    
-    assert(m_vertices.size() < 65535);
+// *********************************************************************************************************
+// Write the mesh out in the VBBMeshFile format
+bool VBBSimpleIndexedMesh::saveMesh(const char* szMeshFile, bool bOptimize, bool bCompress) {
+    if (szMeshFile == nullptr) return false;
+
+    if (bOptimize) optimize();
+
+    return VBBMeshFile::save(szMeshFile, *this, bCompress);
 }
 
+// *********************************************************************************************************
+// Reads a VBBMeshFile, or failing that the raw format saveMesh() used to write, which is just the two
+// counts followed by the arrays (all attributes, always).
+bool VBBSimpleIndexedMesh::loadMesh(const char* szMeshFile) {
+    if (szMeshFile == nullptr) return false;
+
+    VBBMeshFile meshFile;
+    if (meshFile.open(szMeshFile)) return meshFile.copyToMesh(*this);
+
+    FILE* pFile = fopen(szMeshFile, "rb");
+    if (pFile == NULL) return false;
+
+    // Get counts, and make sure the file is really that big before allocating anything
+    uint32_t counts[2];  // Index count, then vertex count
+    bool bOK = (fread(counts, sizeof(uint32_t), 2, pFile) == 2) && (counts[0] != VBB_MESH_FILE_MAGIC);
+    if (bOK) {
+        uint64_t expected = sizeof(counts) + uint64_t(counts[0]) * sizeof(uint32_t) +
+                            uint64_t(counts[1]) * (sizeof(VBBSimpleVertex) + sizeof(VBBSimpleNormal) + sizeof(VBBSimpleTexCoord));
+        bOK = (fseek(pFile, 0, SEEK_END) == 0) && (uint64_t(ftell(pFile)) == expected) && (fseek(pFile, sizeof(counts), SEEK_SET) == 0);
+    }
+
+    if (bOK) {
+        allocateMesh(counts[1], counts[0]);
+        bOK = (fread(m_indexes.data(), sizeof(uint32_t), counts[0], pFile) == counts[0]) &&
+              (fread(m_vertices.data(), sizeof(VBBSimpleVertex), counts[1], pFile) == counts[1]) &&
+              (fread(m_normals.data(), sizeof(VBBSimpleNormal), counts[1], pFile) == counts[1]) &&
+              (fread(m_texCoords.data(), sizeof(VBBSimpleTexCoord), counts[1], pFile) == counts[1]);
+
+        if (!bOK) allocateMesh(0, 0);
+    }
 
-// Pass in a normal by reference, and normalize it in place
-static inline void normalize(VBBSimpleIndexedMesh::VBBSimpleNormal& normal) {
-    double sum = (normal.x * normal.x) + (normal.y * normal.y) + (normal.z * normal.z);
-    double len = sqrt(sum);
-    normal.x /= len;
-    normal.y /= len;
-    normal.z /= len;
+    fclose(pFile);
+    return bOK;
 }
 
-static inline void normalize(float normal[3]) {
-    double sum = (normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]);
-    double len = sqrt(sum);
-    normal[0] /= len;
-    normal[1] /= len;
-    normal[2] /= len;
+// The generators leave their normals at whatever length they come out, then do them all at once
+// here. Vertices that weld have the same normals before or after.
+static inline void normalizeMesh(VBBSimpleIndexedMesh& mesh) {
+    if (mesh.getNormalPointer() != nullptr) vbbNormalizeArray(&mesh.getNormalPointer()->x, mesh.getAttributeCount());
 }
 
 // Draw a torus (doughnut)  at z = fZVal... torus is in xy plane
@@ -152,6 +946,10 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
     double minorStep = 2.0f * VBB_PI / numMinor;
     int i, j;
 
+    // Every ring uses the same minor angles
+    std::vector<double> sinMinor(numMinor + 2), cosMinor(numMinor + 2);
+    vbbMakeSinCosTable(numMinor + 2, minorStep, sinMinor.data(), cosMinor.data());
+
     torusBatch.startBuilding(numMajor * (numMinor + 1) * 6);
     for (i = 0; i < numMajor; ++i) {
         double a0 = i * majorStep;
@@ -166,10 +964,9 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
         VBBSimpleIndexedMesh::VBBSimpleTexCoord vTexture[4];
 
         for (j = 0; j <= numMinor; ++j) {
-            double b = j * minorStep;
-            double c = cos(b);
+            double c = cosMinor[j];
             double r = minorRadius * c + majorRadius;
-            double z = minorRadius * sin(b);
+            double z = minorRadius * sinMinor[j];
 
             // First point
             vTexture[0].s = double(i) / double(numMajor);
@@ -177,7 +974,6 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
             vNormal[0].x = x0 * c;
             vNormal[0].y = y0 * c;
             vNormal[0].z = z / minorRadius;
-            normalize(vNormal[0]);
             vVertex[0].x = x0 * r;
             vVertex[0].y = y0 * r;
             vVertex[0].z = z;
@@ -188,16 +984,14 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
             vNormal[1].x = x1 * c;
             vNormal[1].y = y1 * c;
             vNormal[1].z = z / minorRadius;
-            normalize(vNormal[1]);
             vVertex[1].x = x1 * r;
             vVertex[1].y = y1 * r;
             vVertex[1].z = z;
 
             // Next one over
-            b = (j + 1) * minorStep;
-            c = cos(b);
+            c = cosMinor[j + 1];
             r = minorRadius * c + majorRadius;
-            z = minorRadius * sin(b);
+            z = minorRadius * sinMinor[j + 1];
 
             // Third (based on first)
             vTexture[2].s = (double)(i) / (double)(numMajor);
@@ -205,7 +999,6 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
             vNormal[2].x = x0 * c;
             vNormal[2].y = y0 * c;
             vNormal[2].z = z / minorRadius;
-            normalize(vNormal[2]);
             vVertex[2].x = x0 * r;
             vVertex[2].y = y0 * r;
             vVertex[2].z = z;
@@ -216,7 +1009,6 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
             vNormal[3].x = x1 * c;
             vNormal[3].y = y1 * c;
             vNormal[3].z = z / minorRadius;
-            normalize(vNormal[3]);
             vVertex[3].x = x1 * r;
             vVertex[3].y = y1 * r;
             vVertex[3].z = z;
@@ -230,6 +1022,9 @@ void VBBMakeTorus(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float min
             torusBatch.addVertex(&vVertex[2], &vNormal[2], &vTexture[2]);
         }
     }
+
+    torusBatch.endBuilding();
+    normalizeMesh(torusBatch);
 }
 
 void VBBMakeSphere(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iSlices, uint32_t iStacks) {
@@ -241,6 +1036,10 @@ void VBBMakeSphere(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iS
     double s = 0.0;
     uint32_t i, j;  // Looping variables
 
+    // Every stack uses the same slice angles, the last one is the first again
+    std::vector<double> sinTheta(iSlices + 1), cosTheta(iSlices + 1);
+    vbbMakeSinCosTable(iSlices + 1, dtheta, sinTheta.data(), cosTheta.data(), true);
+
     sphereBatch.startBuilding(iSlices * iStacks * 6);
     for (i = 0; i < iStacks; i++) {
         double rho = double(i) * drho;
@@ -255,9 +1054,8 @@ void VBBMakeSphere(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iS
         std::array<float, 2> vTexture[4];
 
         for (j = 0; j < iSlices; j++) {
-            double theta = (j == iSlices) ? 0.0f : j * dtheta;
-            double stheta = -sin(theta);
-            double ctheta = cos(theta);
+            double stheta = -sinTheta[j];
+            double ctheta = cosTheta[j];
 
             double x = stheta * srho;
             double y = ctheta * srho;
@@ -285,9 +1083,8 @@ void VBBMakeSphere(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iS
             vVertex[1][1] = y * radius;
             vVertex[1][2] = z * radius;
 
-            theta = ((j + 1) == iSlices) ? 0.0f : (j + 1) * dtheta;
-            stheta = -sin(theta);
-            ctheta = cos(theta);
+            stheta = -sinTheta[j + 1];
+            ctheta = cosTheta[j + 1];
 
             x = stheta * srho;
             y = ctheta * srho;
@@ -326,6 +1123,8 @@ void VBBMakeSphere(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iS
         }
         t -= dt;
     }
+
+    sphereBatch.endBuilding();
 }
 
 void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, float topRadius, float fLength, uint32_t numSlices,
@@ -338,6 +1137,10 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
     std::array<float, 3> vNormal[4];
     std::array<float, 2> vTexture[4];
 
+    // Every stack uses the same slice angles
+    std::vector<double> sinSlice(numSlices + 1), cosSlice(numSlices + 1);
+    vbbMakeSinCosTable(numSlices + 1, fStepSizeSlice, sinSlice.data(), cosSlice.data(), degrees == 360);
+
     cylinderBatch.startBuilding(numSlices * numStacks * 6);
 
     double ds = 1.0 / double(numSlices);
@@ -359,8 +1162,6 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
 
         double fCurrentRadius = baseRadius + (fRadiusStep * double(i));
         double fNextRadius = baseRadius + (fRadiusStep * double(i + 1));
-        double theyta;
-        double theytaNext;
 
         double fCurrentZ = double(i) * (fLength / double(numStacks));
         double fNextZ = double(i + 1) * (fLength / double(numStacks));
@@ -383,35 +1184,27 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
             else
                 sNext = float(j + 1) * ds;
 
-            theyta = fStepSizeSlice * float(j);
-            if (j == (numSlices - 1) && degrees == 360)
-                theytaNext = 0.0f;
-            else
-                theytaNext = fStepSizeSlice * (float(j + 1));
-
             // Inner First
-            vVertex[1][0] = cos(theyta) * fCurrentRadius;  // X
-            vVertex[1][1] = sin(theyta) * fCurrentRadius;  // Y
+            vVertex[1][0] = cosSlice[j] * fCurrentRadius;  // X
+            vVertex[1][1] = sinSlice[j] * fCurrentRadius;  // Y
             vVertex[1][2] = fCurrentZ;                     // Z
 
             vNormal[1][0] = vVertex[1][0];  // Surface Normal, same for everybody
             vNormal[1][1] = vVertex[1][1];
             vNormal[1][2] = zNormal;
-            normalize(vNormal[1].data());
 
             vTexture[1][0] = s;  // Texture Coordinates, I have no idea...
             vTexture[1][1] = t;
 
             // Outer First
-            vVertex[0][0] = cos(theyta) * fNextRadius;  // X
-            vVertex[0][1] = sin(theyta) * fNextRadius;  // Y
+            vVertex[0][0] = cosSlice[j] * fNextRadius;  // X
+            vVertex[0][1] = sinSlice[j] * fNextRadius;  // Y
             vVertex[0][2] = fNextZ;                     // Z
 
             if (fabs(fNextRadius) > 0.00001f) {
                 vNormal[0][0] = vVertex[0][0];  // Surface Normal, same for everybody
                 vNormal[0][1] = vVertex[0][1];  // For cones, tip is tricky
                 vNormal[0][2] = zNormal;
-                normalize(vNormal[0].data());
             } else
                 vNormal[0] = vNormal[1];
 
@@ -419,28 +1212,26 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
             vTexture[0][1] = tNext;
 
             // Inner second
-            vVertex[3][0] = cos(theytaNext) * fCurrentRadius;  // X
-            vVertex[3][1] = sin(theytaNext) * fCurrentRadius;  // Y
+            vVertex[3][0] = cosSlice[j + 1] * fCurrentRadius;  // X
+            vVertex[3][1] = sinSlice[j + 1] * fCurrentRadius;  // Y
             vVertex[3][2] = fCurrentZ;                         // Z
 
             vNormal[3][0] = vVertex[3][0];  // Surface Normal, same for everybody
             vNormal[3][1] = vVertex[3][1];
             vNormal[3][2] = zNormal;
-            normalize(vNormal[3].data());
 
             vTexture[3][0] = sNext;  // Texture Coordinates, I have no idea...
             vTexture[3][1] = t;
 
             // Outer second
-            vVertex[2][0] = cos(theytaNext) * fNextRadius;  // X
-            vVertex[2][1] = sin(theytaNext) * fNextRadius;  // Y
+            vVertex[2][0] = cosSlice[j + 1] * fNextRadius;  // X
+            vVertex[2][1] = sinSlice[j + 1] * fNextRadius;  // Y
             vVertex[2][2] = fNextZ;                         // Z
 
             if (fabs(fNextRadius) > 0.00001f) {
                 vNormal[2][0] = vVertex[2][0];  // Surface Normal, same for everybody
                 vNormal[2][1] = vVertex[2][1];
                 vNormal[2][2] = zNormal;
-                normalize(vNormal[2].data());
             } else
                 vNormal[2] = vNormal[1];
 
@@ -456,6 +1247,9 @@ void VBBMakeCylinder(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, floa
             cylinderBatch.addVertex(vVertex[2].data(), vNormal[2].data(), vTexture[2].data());
         }
     }
+
+    cylinderBatch.endBuilding();
+    normalizeMesh(cylinderBatch);
 }
 
 void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outerRadius, uint32_t nSlices, uint32_t nStacks,
@@ -468,6 +1262,10 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
 
     float fStepSizeSlice = (double(degrees) * (3.14159265 / 180.0)) / double(nSlices);
 
+    // Every ring uses the same slice angles
+    std::vector<double> sinSlice(nSlices + 1), cosSlice(nSlices + 1);
+    vbbMakeSinCosTable(nSlices + 1, fStepSizeSlice, sinSlice.data(), cosSlice.data(), degrees == 360);
+
     diskBatch.startBuilding(nSlices * nStacks * 6);
 
     std::array<float, 3> vVertex[4];
@@ -478,22 +1276,14 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
 
     for (uint32_t i = 0; i < nStacks; i++)  // Stacks
     {
-        double theyta;
-        double theytaNext;
         for (uint32_t j = 0; j < nSlices; j++)  // Slices
         {
             double inner = innerRadius + (double(i)) * fStepSizeRadial;
             double outer = innerRadius + (double(i + 1)) * fStepSizeRadial;
 
-            theyta = fStepSizeSlice * double(j);
-            if (j == (nSlices - 1) && degrees == 360)
-                theytaNext = 0.0;
-            else
-                theytaNext = fStepSizeSlice * (double(j + 1));
-
             // Inner First
-            vVertex[0][0] = cos(theyta) * inner;  // X
-            vVertex[0][1] = sin(theyta) * inner;  // Y
+            vVertex[0][0] = cosSlice[j] * inner;  // X
+            vVertex[0][1] = sinSlice[j] * inner;  // Y
             vVertex[0][2] = 0.0f;                 // Z
 
             vNormal[0][0] = 0.0f;  // Surface Normal, same for everybody
@@ -504,8 +1294,8 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
             vTexture[0][1] = ((vVertex[0][1] * fRadialScale) + 1.0f) * 0.5f;
 
             // Outer First
-            vVertex[1][0] = cos(theyta) * outer;  // X
-            vVertex[1][1] = sin(theyta) * outer;  // Y
+            vVertex[1][0] = cosSlice[j] * outer;  // X
+            vVertex[1][1] = sinSlice[j] * outer;  // Y
             vVertex[1][2] = 0.0f;                 // Z
 
             vNormal[1][0] = 0.0f;  // Surface Normal, same for everybody
@@ -516,8 +1306,8 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
             vTexture[1][1] = ((vVertex[1][1] * fRadialScale) + 1.0f) * 0.5f;
 
             // Inner Second
-            vVertex[2][0] = cos(theytaNext) * inner;  // X
-            vVertex[2][1] = sin(theytaNext) * inner;  // Y
+            vVertex[2][0] = cosSlice[j + 1] * inner;  // X
+            vVertex[2][1] = sinSlice[j + 1] * inner;  // Y
             vVertex[2][2] = 0.0f;                     // Z
 
             vNormal[2][0] = 0.0f;  // Surface Normal, same for everybody
@@ -528,8 +1318,8 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
             vTexture[2][1] = ((vVertex[2][1] * fRadialScale) + 1.0f) * 0.5f;
 
             // Outer Second
-            vVertex[3][0] = cos(theytaNext) * outer;  // X
-            vVertex[3][1] = sin(theytaNext) * outer;  // Y
+            vVertex[3][0] = cosSlice[j + 1] * outer;  // X
+            vVertex[3][1] = sinSlice[j + 1] * outer;  // Y
             vVertex[3][2] = 0.0f;                     // Z
 
             vNormal[3][0] = 0.0f;  // Surface Normal, same for everybody
@@ -548,131 +1338,810 @@ void VBBMakeDisk(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outer
             diskBatch.addVertex(vVertex[2].data(), vNormal[2].data(), vTexture[2].data());
         }
     }
+
+    diskBatch.endBuilding();
 }
 
-////////////////////////////////////////////////////////////////////
-// Allocate memory and load targa bits. Returns pointer to new buffer,
-// height, and width of texture, and the OpenGL format of data.
-// Call free() on buffer when finished!
-// This only works on pretty vanilla targas... 8, 24, or 32 bit color
-// only, no palettes, no RLE encoding.
-unsigned char* vbbReadTGABits(const char* szFileName, uint32_t* iWidth, uint32_t* iHeight, uint32_t* iComponents, VkFormat* format,
-                              unsigned char* pMemoryBuffer) {
-    FILE* pFile;                  // File pointer
-    TGAHEADER tgaHeader;          // TGA file header
-    unsigned long lImageSize;     // Size in bytes of image
-    short sDepth;                 // Pixel depth;
-    unsigned char* pBits = NULL;  // Pointer to bits
+// *********************************************************************************************************
+// Split count items into nThreads contiguous ranges and run them at the same time. The calling thread
+// does the first range. nThreads = 0 means use all the hardware threads.
+void vbbParallelFor(uint32_t count, uint32_t nThreads, const std::function<void(uint32_t, uint32_t)>& work) {
+    if (nThreads == 0) nThreads = std::thread::hardware_concurrency();
+    if (nThreads > count) nThreads = count;
+    if (nThreads <= 1) {
+        work(0, count);
+        return;
+    }
 
-    // Default/Failed values
-    *iWidth = 0;
-    *iHeight = 0;
-    *iComponents = 3;
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
 
-    // Attempt to open the file
-    pFile = fopen(szFileName, "rb");
-    if (pFile == NULL) return nullptr;
+    uint32_t chunk = count / nThreads;
+    uint32_t extra = count % nThreads;  // First few ranges get one more
+    uint32_t first = chunk + ((extra > 0) ? 1 : 0);
+    for (uint32_t t = 1; t < nThreads; t++) {
+        uint32_t size = chunk + ((t < extra) ? 1 : 0);
+        threads.push_back(std::thread(work, first, first + size));
+        first += size;
+    }
 
-    // Read in header (binary)
-    fread(&tgaHeader, 18 /* sizeof(TGAHEADER)*/, 1, pFile);
+    work(0, chunk + ((extra > 0) ? 1 : 0));
 
-    // Get width, height, and depth of texture
-    *iWidth = tgaHeader.width;
-    *iHeight = tgaHeader.height;
-    sDepth = tgaHeader.bits / 8;
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+}
 
-    // Put some validity checks here. Very simply, I only understand
-    // or care about 8, 24, or 32 bit targa's.
-    if (tgaHeader.bits != 8 && tgaHeader.bits != 24 && tgaHeader.bits != 32) return nullptr;
+// *********************************************************************************************************
+// Float to half, round to nearest even. Too big becomes infinity, too small becomes a denormal or zero.
+uint16_t vbbFloatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x007FFFFF;
+
+    if (exponent == 0xFF) return uint16_t(sign | 0x7C00 | (mantissa ? 0x200 : 0));  // Inf or NaN
+
+    int32_t halfExponent = int32_t(exponent) - 127 + 15;
+    if (halfExponent >= 0x1F) return uint16_t(sign | 0x7C00);  // Overflow
+
+    if (halfExponent <= 0) {  // Denormal, or zero
+        if (halfExponent < -10) return uint16_t(sign);
+        mantissa |= 0x00800000;
+        uint32_t shift = uint32_t(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return uint16_t(sign | half);
+    }
 
-    // Calculate size of image buffer
-    lImageSize = tgaHeader.width * tgaHeader.height * sDepth;
+    uint32_t half = (uint32_t(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;  // Can carry into the exponent, which is right
 
-    // Allocate memory and check for success
-    if (pMemoryBuffer == nullptr)
-        pBits = (unsigned char*)malloc(lImageSize * sizeof(unsigned char));
-    else
-        pBits = pMemoryBuffer;
+    return uint16_t(sign | half);
+}
 
-    if (pBits == nullptr) return nullptr;
+// *********************************************************************************************************
+float vbbHalfToFloat(uint16_t value) {
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0x1F)
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else {  // Denormal, normalize it
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
 
-    // Read in the bits
-    // Check for read error. This should catch RLE or other
-    // weird formats that I don't want to recognize
-    if (fread(pBits, lImageSize, 1, pFile) != 1) {
-        if (pMemoryBuffer == nullptr)  // Only free if we also allocated
-            free(pBits);
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
 
-        return nullptr;
+// *********************************************************************************************************
+// Octahedral normals. Project onto the octahedron, fold the bottom half over the top, and store
+// the result as two snorms. The GLSL in StockShader_FakeLightQ.vert is the reverse of this.
+void vbbOctahedralEncode(const float normal[3], int16_t encoded[2]) {
+    float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (length == 0.0f) {
+        encoded[0] = encoded[1] = 0;
+        return;
     }
 
-    // Set format expected
-    switch (sDepth) {
-        case 3:  // Most likely case
-            *iComponents = 3;
-            *format = VK_FORMAT_R8G8B8_UNORM;
-            break;
-        case 4:
-            *iComponents = 4;
-            *format = VK_FORMAT_R8G8B8A8_UNORM; // it's actually BRGA
-            break;
-        case 1:
-            *iComponents = 1;
-            *format = VK_FORMAT_R8_UNORM;
-            break;
-        default:  // RGB
-            break;
-    }
+    float x = normal[0] / length;
+    float y = normal[1] / length;
 
-    // Done with File
-    fclose(pFile);
+    if (normal[2] < 0.0f) {
+        float foldX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        float foldY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+        x = foldX;
+        y = foldY;
+    }
 
-    // Return pointer to image data
-    return pBits;
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
 }
 
-// ***************************************************************
-// How many bytes per pixel does a particular image format have
-// This function was written by ChatGPT from my prompts. Pretty
-// impressive.
-int getBytesPerPixel(VkFormat format) {
-    switch (format) {
-        case VK_FORMAT_R8_UNORM:
-        case VK_FORMAT_R8_SNORM:
-        case VK_FORMAT_R8_UINT:
-        case VK_FORMAT_R8_SINT:
-            return 1;
+void vbbOctahedralDecode(const int16_t encoded[2], float normal[3]) {
+    float x = (encoded[0] < -32767) ? -1.0f : float(encoded[0]) / 32767.0f;
+    float y = (encoded[1] < -32767) ? -1.0f : float(encoded[1]) / 32767.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
 
-        case VK_FORMAT_R8G8_UNORM:
-        case VK_FORMAT_R8G8_SNORM:
-        case VK_FORMAT_R8G8_UINT:
+    float t = (z < 0.0f) ? -z : 0.0f;
+    x += (x >= 0.0f) ? -t : t;
+    y += (y >= 0.0f) ? -t : t;
+
+    float length = sqrtf(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+// *********************************************************************************************************
+// Scale then translate, column major
+void vbbGetDequantizeMatrix(const VBBInterleavedLayout& layout, float matrix[16]) {
+    memset(matrix, 0, sizeof(float) * 16);
+    matrix[0] = layout.positionScale[0];
+    matrix[5] = layout.positionScale[1];
+    matrix[10] = layout.positionScale[2];
+    matrix[12] = layout.positionOffset[0];
+    matrix[13] = layout.positionOffset[1];
+    matrix[14] = layout.positionOffset[2];
+    matrix[15] = 1.0f;
+}
+
+// *********************************************************************************************************
+// Two triangles for each quad in a grid of vertices that is (columns + 1) wide. The quad corners are
+// a = (row, column), b = (row + 1, column), c = (row, column + 1) and d = (row + 1, column + 1). The
+// generators above don't all split the quad on the same diagonal, so neither do these.
+static void makeGridIndexes(uint32_t* pIndexes, uint32_t columns, uint32_t firstRow, uint32_t endRow, bool bDiagonalAD) {
+    uint32_t rowWidth = columns + 1;
+    pIndexes += firstRow * columns * 6;
+
+    for (uint32_t i = firstRow; i < endRow; i++)
+        for (uint32_t j = 0; j < columns; j++) {
+            uint32_t a = i * rowWidth + j;
+            uint32_t b = a + rowWidth;
+            uint32_t c = a + 1;
+            uint32_t d = b + 1;
+
+            if (bDiagonalAD) {
+                *pIndexes++ = b;
+                *pIndexes++ = a;
+                *pIndexes++ = d;
+                *pIndexes++ = a;
+                *pIndexes++ = c;
+                *pIndexes++ = d;
+            } else {
+                *pIndexes++ = a;
+                *pIndexes++ = b;
+                *pIndexes++ = c;
+                *pIndexes++ = b;
+                *pIndexes++ = d;
+                *pIndexes++ = c;
+            }
+        }
+}
+
+// *********************************************************************************************************
+// One strip per row, a0 b0 a1 b1... (or b0 a0 b1 a1... for the other diagonal), which makes the same
+// triangles with the same winding as makeGridIndexes(). A restart index ends every row but the last.
+static uint32_t gridStripIndexCount(uint32_t columns, uint32_t rows) { return rows * (2 * (columns + 1) + 1) - 1; }
+
+static void makeGridStrips(uint32_t* pIndexes, uint32_t columns, uint32_t rows, uint32_t firstRow, uint32_t endRow, bool bDiagonalAD) {
+    uint32_t rowWidth = columns + 1;
+    pIndexes += firstRow * (2 * rowWidth + 1);
+
+    for (uint32_t i = firstRow; i < endRow; i++) {
+        for (uint32_t j = 0; j <= columns; j++) {
+            uint32_t a = i * rowWidth + j;
+            uint32_t b = a + rowWidth;
+
+            *pIndexes++ = bDiagonalAD ? b : a;
+            *pIndexes++ = bDiagonalAD ? a : b;
+        }
+
+        if (i + 1 < rows) *pIndexes++ = VBB_PRIMITIVE_RESTART_INDEX;
+    }
+}
+
+// Fill in the indexes for a grid generator, either way
+static void makeGrid(VBBSimpleIndexedMesh& mesh, uint32_t columns, uint32_t rows, uint32_t nThreads, bool bDiagonalAD, bool bStrips) {
+    uint32_t* pIndexes = mesh.getIndexPointer();
+    if (bStrips) mesh.setTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+
+    vbbParallelFor(rows, nThreads, [&](uint32_t firstRow, uint32_t endRow) {
+        if (bStrips)
+            makeGridStrips(pIndexes, columns, rows, firstRow, endRow, bDiagonalAD);
+        else
+            makeGridIndexes(pIndexes, columns, firstRow, endRow, bDiagonalAD);
+    });
+}
+
+// *********************************************************************************************************
+// Torus in the xy plane. numMajor + 1 rings of numMinor + 1 vertices.
+void VBBMakeTorusGrid(VBBSimpleIndexedMesh& torusBatch, float majorRadius, float minorRadius, uint32_t numMajor, uint32_t numMinor,
+                      uint32_t nThreads, bool bStrips) {
+    double majorStep = 2.0 * VBB_PI / double(numMajor);
+    double minorStep = 2.0 * VBB_PI / double(numMinor);
+    uint32_t rowWidth = numMinor + 1;
+
+    torusBatch.allocateMesh((numMajor + 1) * rowWidth, bStrips ? gridStripIndexCount(numMinor, numMajor) : numMajor * numMinor * 6);
+    VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = torusBatch.getVertexPointer();
+    VBBSimpleIndexedMesh::VBBSimpleNormal* pNormals = torusBatch.getNormalPointer();
+    VBBSimpleIndexedMesh::VBBSimpleTexCoord* pTexCoords = torusBatch.getTexCoordPointer();
+
+    std::vector<double> sinMinor(rowWidth), cosMinor(rowWidth);
+    vbbMakeSinCosTable(rowWidth, minorStep, sinMinor.data(), cosMinor.data(), true);
+
+    vbbParallelFor(numMajor + 1, nThreads, [&](uint32_t firstRow, uint32_t endRow) {
+        for (uint32_t i = firstRow; i < endRow; i++) {
+            double a = (i == numMajor) ? 0.0 : double(i) * majorStep;  // Seam lands exactly on the first ring
+            double x = cos(a);
+            double y = sin(a);
+
+            for (uint32_t j = 0; j <= numMinor; j++) {
+                double c = cosMinor[j];
+                double sb = sinMinor[j];
+                double r = minorRadius * c + majorRadius;
+                uint32_t v = i * rowWidth + j;
+
+                pVertices[v].x = x * r;
+                pVertices[v].y = y * r;
+                pVertices[v].z = minorRadius * sb;
+
+                pNormals[v].x = x * c;
+                pNormals[v].y = y * c;
+                pNormals[v].z = sb;
+
+                pTexCoords[v].s = double(i) / double(numMajor);
+                pTexCoords[v].t = double(j) / double(numMinor);
+            }
+        }
+    });
+
+    makeGrid(torusBatch, numMinor, numMajor, nThreads, false, bStrips);
+}
+
+// *********************************************************************************************************
+// Sphere around the z axis. iStacks + 1 rows (pole to pole) of iSlices + 1 vertices.
+void VBBMakeSphereGrid(VBBSimpleIndexedMesh& sphereBatch, double radius, uint32_t iSlices, uint32_t iStacks, uint32_t nThreads,
+                       bool bStrips) {
+    double drho = VBB_PI / double(iStacks);
+    double dtheta = (2.0 * VBB_PI) / double(iSlices);
+    uint32_t rowWidth = iSlices + 1;
+
+    sphereBatch.allocateMesh((iStacks + 1) * rowWidth, bStrips ? gridStripIndexCount(iSlices, iStacks) : iSlices * iStacks * 6);
+    VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = sphereBatch.getVertexPointer();
+    VBBSimpleIndexedMesh::VBBSimpleNormal* pNormals = sphereBatch.getNormalPointer();
+    VBBSimpleIndexedMesh::VBBSimpleTexCoord* pTexCoords = sphereBatch.getTexCoordPointer();
+
+    std::vector<double> sinTheta(rowWidth), cosTheta(rowWidth);
+    vbbMakeSinCosTable(rowWidth, dtheta, sinTheta.data(), cosTheta.data(), true);
+
+    vbbParallelFor(iStacks + 1, nThreads, [&](uint32_t firstRow, uint32_t endRow) {
+        for (uint32_t i = firstRow; i < endRow; i++) {
+            double rho = double(i) * drho;
+            double srho = sin(rho);
+            double crho = cos(rho);
+
+            for (uint32_t j = 0; j <= iSlices; j++) {
+                double x = -sinTheta[j] * srho;
+                double y = cosTheta[j] * srho;
+                double z = crho;
+                uint32_t v = i * rowWidth + j;
+
+                pVertices[v].x = x * radius;
+                pVertices[v].y = y * radius;
+                pVertices[v].z = z * radius;
+
+                pNormals[v].x = x;
+                pNormals[v].y = y;
+                pNormals[v].z = z;
+
+                pTexCoords[v].s = double(j) / double(iSlices);
+                pTexCoords[v].t = 1.0 - double(i) / double(iStacks);
+            }
+        }
+    });
+
+    makeGrid(sphereBatch, iSlices, iStacks, nThreads, false, bStrips);
+}
+
+// *********************************************************************************************************
+// Cylinder (or cone) along the z axis, numStacks + 1 rows of numSlices + 1 vertices. Normals come from
+// the actual slope of the side, so the tip of a cone gets a proper normal too.
+void VBBMakeCylinderGrid(VBBSimpleIndexedMesh& cylinderBatch, float baseRadius, float topRadius, float fLength, uint32_t numSlices,
+                         uint32_t numStacks, uint32_t degrees, uint32_t nThreads, bool bStrips) {
+    double fRadiusStep = (topRadius - baseRadius) / double(numStacks);
+    double fStepSizeSlice = (double(degrees) * (VBB_PI / 180.0)) / double(numSlices);
+    uint32_t rowWidth = numSlices + 1;
+
+    // Normal is (cos * length, sin * length, base - top) normalized
+    double slopeLength = sqrt(double(fLength) * double(fLength) + double(baseRadius - topRadius) * double(baseRadius - topRadius));
+    double xyNormal = (slopeLength > 0.0) ? fLength / slopeLength : 1.0;
+    double zNormal = (slopeLength > 0.0) ? (baseRadius - topRadius) / slopeLength : 0.0;
+
+    cylinderBatch.allocateMesh((numStacks + 1) * rowWidth,
+                               bStrips ? gridStripIndexCount(numSlices, numStacks) : numSlices * numStacks * 6);
+    VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = cylinderBatch.getVertexPointer();
+    VBBSimpleIndexedMesh::VBBSimpleNormal* pNormals = cylinderBatch.getNormalPointer();
+    VBBSimpleIndexedMesh::VBBSimpleTexCoord* pTexCoords = cylinderBatch.getTexCoordPointer();
+
+    std::vector<double> sinSlice(rowWidth), cosSlice(rowWidth);
+    vbbMakeSinCosTable(rowWidth, fStepSizeSlice, sinSlice.data(), cosSlice.data(), degrees == 360);
+
+    vbbParallelFor(numStacks + 1, nThreads, [&](uint32_t firstRow, uint32_t endRow) {
+        for (uint32_t i = firstRow; i < endRow; i++) {
+            double radius = baseRadius + fRadiusStep * double(i);
+            double z = double(i) * (fLength / double(numStacks));
+
+            for (uint32_t j = 0; j <= numSlices; j++) {
+                double c = cosSlice[j];
+                double s = sinSlice[j];
+                uint32_t v = i * rowWidth + j;
+
+                pVertices[v].x = c * radius;
+                pVertices[v].y = s * radius;
+                pVertices[v].z = z;
+
+                pNormals[v].x = c * xyNormal;
+                pNormals[v].y = s * xyNormal;
+                pNormals[v].z = zNormal;
+
+                pTexCoords[v].s = double(j) / double(numSlices);
+                pTexCoords[v].t = double(i) / double(numStacks);
+            }
+        }
+    });
+
+    makeGrid(cylinderBatch, numSlices, numStacks, nThreads, true, bStrips);
+}
+
+// *********************************************************************************************************
+// Flat disk (or ring) in the xy plane, nStacks + 1 rings of nSlices + 1 vertices, from the inside out
+void VBBMakeDiskGrid(VBBSimpleIndexedMesh& diskBatch, float innerRadius, float outerRadius, uint32_t nSlices, uint32_t nStacks,
+                     uint32_t degrees, uint32_t nThreads, bool bStrips) {
+    double fStepSizeRadial = fabs(double(outerRadius) - double(innerRadius)) / double(nStacks);
+    double fStepSizeSlice = (double(degrees) * (VBB_PI / 180.0)) / double(nSlices);
+    double fRadialScale = 1.0 / outerRadius;
+    uint32_t rowWidth = nSlices + 1;
+
+    diskBatch.allocateMesh((nStacks + 1) * rowWidth, bStrips ? gridStripIndexCount(nSlices, nStacks) : nSlices * nStacks * 6);
+    VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = diskBatch.getVertexPointer();
+    VBBSimpleIndexedMesh::VBBSimpleNormal* pNormals = diskBatch.getNormalPointer();
+    VBBSimpleIndexedMesh::VBBSimpleTexCoord* pTexCoords = diskBatch.getTexCoordPointer();
+
+    std::vector<double> sinSlice(rowWidth), cosSlice(rowWidth);
+    vbbMakeSinCosTable(rowWidth, fStepSizeSlice, sinSlice.data(), cosSlice.data(), degrees == 360);
+
+    vbbParallelFor(nStacks + 1, nThreads, [&](uint32_t firstRow, uint32_t endRow) {
+        for (uint32_t i = firstRow; i < endRow; i++) {
+            double radius = innerRadius + double(i) * fStepSizeRadial;
+
+            for (uint32_t j = 0; j <= nSlices; j++) {
+                double x = cosSlice[j] * radius;
+                double y = sinSlice[j] * radius;
+                uint32_t v = i * rowWidth + j;
+
+                pVertices[v].x = x;
+                pVertices[v].y = y;
+                pVertices[v].z = 0.0f;
+
+                pNormals[v].x = 0.0f;
+                pNormals[v].y = 0.0f;
+                pNormals[v].z = 1.0f;
+
+                pTexCoords[v].s = ((x * fRadialScale) + 1.0) * 0.5;
+                pTexCoords[v].t = ((y * fRadialScale) + 1.0) * 0.5;
+            }
+        }
+    });
+
+    makeGrid(diskBatch, nSlices, nStacks, nThreads, false, bStrips);
+}
+
+// *********************************************************************************************************
+// Fill count pixels with the same one. The pixel is repeated into a pattern that is a whole number of
+// pixels and a whole number of 16 byte vectors long (48 bytes for 24-bit, 64 for the rest), which is
+// then stored over and over. Short runs aren't worth setting that up for. Templated on the pixel size
+// so the little copies are just a move.
+template <uint32_t depth>
+static void tgaFillRun(unsigned char* pDest, const unsigned char* pPixel, uint32_t count) {
+    size_t bytes = size_t(count) * depth;
+    if (bytes < 32) {
+        for (uint32_t i = 0; i < count; i++, pDest += depth) memcpy(pDest, pPixel, depth);
+        return;
+    }
+
+    unsigned char pattern[64];
+    const uint32_t period = (depth == 3) ? 48 : 64;
+    for (uint32_t i = 0; i < period; i += depth) memcpy(pattern + i, pPixel, depth);
+
+#if defined(VBB_SIMD_SSE)
+    __m128i v[4];
+    for (uint32_t i = 0; i < period / 16; i++) v[i] = _mm_loadu_si128((const __m128i*)(pattern + i * 16));
+    while (bytes >= period) {
+        for (uint32_t i = 0; i < period / 16; i++) _mm_storeu_si128((__m128i*)(pDest + i * 16), v[i]);
+        pDest += period;
+        bytes -= period;
+    }
+#elif defined(VBB_SIMD_NEON)
+    uint8x16_t v[4];
+    for (uint32_t i = 0; i < period / 16; i++) v[i] = vld1q_u8(pattern + i * 16);
+    while (bytes >= period) {
+        for (uint32_t i = 0; i < period / 16; i++) vst1q_u8(pDest + i * 16, v[i]);
+        pDest += period;
+        bytes -= period;
+    }
+#else
+    while (bytes >= period) {
+        memcpy(pDest, pattern, period);
+        pDest += period;
+        bytes -= period;
+    }
+#endif
+
+    // The pattern starts on a pixel, so what's left is just the start of it
+    memcpy(pDest, pattern, bytes);
+}
+
+// *********************************************************************************************************
+// Run length encoded pixels. Each packet is a byte, high bit set means the next pixel is repeated
+// (low 7 bits + 1) times, otherwise that many pixels follow as is. Fails if the data runs out or
+// a packet runs off the end of the image.
+template <uint32_t depth>
+static bool tgaDecodeRLE(const unsigned char* pSource, size_t sourceSize, unsigned char* pDest, uint32_t pixelCount) {
+    const unsigned char* pEnd = pSource + sourceSize;
+    uint32_t pixel = 0;
+
+    while (pixel < pixelCount) {
+        if (pSource >= pEnd) return false;
+
+        unsigned char packet = *pSource++;
+        uint32_t count = (packet & 0x7F) + 1;
+        if (count > pixelCount - pixel) return false;
+
+        if (packet & 0x80) {
+            if (size_t(pEnd - pSource) < depth) return false;
+            tgaFillRun<depth>(pDest, pSource, count);
+            pSource += depth;
+        } else {
+            size_t bytes = size_t(count) * depth;
+            if (size_t(pEnd - pSource) < bytes) return false;
+            memcpy(pDest, pSource, bytes);
+            pSource += bytes;
+        }
+
+        pDest += size_t(count) * depth;
+        pixel += count;
+    }
+
+    return true;
+}
+
+static bool tgaDecodeRLE(const unsigned char* pSource, size_t sourceSize, unsigned char* pDest, uint32_t pixelCount,
+                         uint32_t depth) {
+    switch (depth) {
+        case 1:
+            return tgaDecodeRLE<1>(pSource, sourceSize, pDest, pixelCount);
+        case 2:
+            return tgaDecodeRLE<2>(pSource, sourceSize, pDest, pixelCount);
+        case 3:
+            return tgaDecodeRLE<3>(pSource, sourceSize, pDest, pixelCount);
+        case 4:
+            return tgaDecodeRLE<4>(pSource, sourceSize, pDest, pixelCount);
+        default:
+            return false;
+    }
+}
+
+// *********************************************************************************************************
+// Look up each 8-bit index in the color map. The first entry in the map is index colorMapStart.
+static bool tgaExpandPalette(const unsigned char* pIndexes, uint32_t pixelCount, const unsigned char* pPalette, uint32_t first,
+                             uint32_t length, uint32_t depth, unsigned char* pDest) {
+    if (depth == 4) {
+        uint32_t table[256];
+        memset(table, 0, sizeof(table));
+        for (uint32_t i = 0; i < length && first + i < 256; i++) memcpy(&table[first + i], pPalette + i * 4, 4);
+
+        for (uint32_t i = 0; i < pixelCount; i++) {
+            if (pIndexes[i] < first || pIndexes[i] >= first + length) return false;
+            memcpy(pDest + i * 4, &table[pIndexes[i]], 4);
+        }
+        return true;
+    }
+
+    for (uint32_t i = 0; i < pixelCount; i++) {
+        if (pIndexes[i] < first || pIndexes[i] >= first + length) return false;
+        memcpy(pDest + size_t(i) * depth, pPalette + (pIndexes[i] - first) * depth, depth);
+    }
+    return true;
+}
+
+// *********************************************************************************************************
+// Everything about a targa that the header says, and what it will look like once it's read
+struct VBBTGALayout {
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelCount;
+    uint32_t depth;       // Bytes per pixel handed back
+    uint32_t components;
+    VkFormat format;
+    bool bRLE;
+    bool bPaletted;
+    bool bNoAlpha;        // 16-bit pixels that need the alpha bit set
+    size_t paletteOffset; // From the start of the file
+    size_t paletteSize;
+    size_t dataOffset;
+    size_t imageSize;     // Bytes of pixels handed back
+};
+
+// Paletted images have 8-bit indexes into a map of 15, 16, 24, or 32 bit colors, everything
+// else is the pixels themselves. Fails on anything else.
+static bool tgaGetLayout(const TGAHEADER& header, VBBTGALayout& layout) {
+    layout.bRLE = (header.imageType & 8) != 0;
+    unsigned char imageType = header.imageType & 7;
+    layout.bPaletted = (imageType == 1);
+    uint32_t mapDepth = (header.colorMapBits + 7) / 8;
+
+    bool bValid = false;
+    if (layout.bPaletted)
+        bValid = (header.colorMapType == 1 && header.bits == 8 &&
+                  (header.colorMapBits == 15 || header.colorMapBits == 16 || header.colorMapBits == 24 || header.colorMapBits == 32));
+    else if (imageType == 2)
+        bValid = (header.bits == 15 || header.bits == 16 || header.bits == 24 || header.bits == 32);
+    else if (imageType == 3)
+        bValid = (header.bits == 8);
+
+    if (!bValid || header.width == 0 || header.height == 0) return false;
+
+    layout.width = header.width;
+    layout.height = header.height;
+    layout.pixelCount = uint32_t(header.width) * header.height;
+    layout.depth = layout.bPaletted ? mapDepth : (header.bits + 7) / 8;
+    layout.bNoAlpha =
+        (layout.depth == 2) && ((layout.bPaletted ? header.colorMapBits : header.bits) == 15 || (header.descriptor & 0x0F) == 0);
+
+    // The ID field, then the color map if there is one (even if it isn't used), then the pixels
+    layout.paletteOffset = 18 + size_t(header.identsize);
+    layout.paletteSize = (header.colorMapType == 1) ? size_t(header.colorMapLength) * mapDepth : 0;
+    layout.dataOffset = layout.paletteOffset + layout.paletteSize;
+    layout.imageSize = size_t(layout.pixelCount) * layout.depth;
+
+    switch (layout.depth) {
+        case 3:  // Most likely case, and targas are BGR(A)
+            layout.components = 3;
+            layout.format = VK_FORMAT_B8G8R8_UNORM;
+            break;
+        case 4:
+            layout.components = 4;
+            layout.format = VK_FORMAT_B8G8R8A8_UNORM;
+            break;
+        case 2:  // Little endian ARRRRRGG GGGBBBBB, same as Vulkan's packed format
+            layout.components = layout.bNoAlpha ? 3 : 4;
+            layout.format = VK_FORMAT_A1R5G5B5_UNORM_PACK16;
+            break;
+        default:
+            layout.components = 1;
+            layout.format = VK_FORMAT_R8_UNORM;
+            break;
+    }
+
+    return true;
+}
+
+// *********************************************************************************************************
+// Header only, nothing is decoded
+bool vbbGetTGAInfo(const void* pFileData, size_t fileSize, uint32_t* iWidth, uint32_t* iHeight, uint32_t* iComponents,
+                   VkFormat* format, size_t* pImageSize) {
+    TGAHEADER header;
+    VBBTGALayout layout;
+    if (pFileData == nullptr || fileSize < 18) return false;
+
+    memcpy(&header, pFileData, 18);
+    if (!tgaGetLayout(header, layout)) return false;
+
+    *iWidth = layout.width;
+    *iHeight = layout.height;
+    *iComponents = layout.components;
+    *format = layout.format;
+    if (pImageSize != nullptr) *pImageSize = layout.imageSize;
+    return true;
+}
+
+// *********************************************************************************************************
+// Uncompressed pixels that don't need anything done to them can be used right where they are
+const void* vbbGetTGAPixels(const void* pFileData, size_t fileSize) {
+    TGAHEADER header;
+    VBBTGALayout layout;
+    if (pFileData == nullptr || fileSize < 18) return nullptr;
+
+    memcpy(&header, pFileData, 18);
+    if (!tgaGetLayout(header, layout) || layout.bRLE || layout.bPaletted || layout.bNoAlpha) return nullptr;
+    if (layout.dataOffset > fileSize || fileSize - layout.dataOffset < layout.imageSize) return nullptr;
+
+    return static_cast<const unsigned char*>(pFileData) + layout.dataOffset;
+}
+
+// *********************************************************************************************************
+// The whole file is in memory, pixels go to pDest exactly once
+bool vbbDecodeTGA(const void* pFileData, size_t fileSize, void* pDest) {
+    TGAHEADER header;
+    VBBTGALayout layout;
+    if (pFileData == nullptr || pDest == nullptr || fileSize < 18) return false;
+
+    memcpy(&header, pFileData, 18);
+    if (!tgaGetLayout(header, layout) || layout.dataOffset > fileSize) return false;
+
+    const unsigned char* pFile = static_cast<const unsigned char*>(pFileData);
+    const unsigned char* pData = pFile + layout.dataOffset;
+    size_t dataSize = fileSize - layout.dataOffset;
+
+    // pDest may well be write combined, so anything that needs another pass goes through scratch memory first
+    std::vector<unsigned char> scratch;
+    unsigned char* pBits = static_cast<unsigned char*>(pDest);
+    if (layout.bNoAlpha) {
+        scratch.resize(layout.imageSize);
+        pBits = scratch.data();
+    }
+
+    bool bOK;
+    if (!layout.bPaletted) {
+        if (layout.bRLE)
+            bOK = tgaDecodeRLE(pData, dataSize, pBits, layout.pixelCount, layout.depth);
+        else {
+            bOK = (dataSize >= layout.imageSize);
+            if (bOK) memcpy(pBits, pData, layout.imageSize);
+        }
+    } else {
+        // Unpack the indexes first if need be
+        const unsigned char* pIndexes = pData;
+        std::vector<unsigned char> indexes;
+        if (layout.bRLE) {
+            indexes.resize(layout.pixelCount);
+            bOK = tgaDecodeRLE(pData, dataSize, indexes.data(), layout.pixelCount, 1);
+            pIndexes = indexes.data();
+        } else
+            bOK = (dataSize >= layout.pixelCount);
+
+        bOK = bOK && tgaExpandPalette(pIndexes, layout.pixelCount, pFile + layout.paletteOffset, header.colorMapStart,
+                                      header.colorMapLength, layout.depth, pBits);
+    }
+
+    if (!bOK) return false;
+
+    // Opaque 16-bit pixels, otherwise the alpha bit reads as transparent
+    if (layout.bNoAlpha) {
+        unsigned char* pOut = static_cast<unsigned char*>(pDest);
+        for (uint32_t i = 0; i < layout.pixelCount; i++) {
+            pOut[i * 2] = pBits[i * 2];
+            pOut[i * 2 + 1] = pBits[i * 2 + 1] | 0x80;
+        }
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Allocate memory and load targa bits. Returns pointer to new buffer,
+// height, and width of texture, and the Vulkan format of the data.
+// Call free() on buffer when finished!
+// Reads 8, 24, or 32 bit color or greyscale, 15 and 16 bit (A1R5G5B5),
+// and 8-bit paletted targas, RLE compressed or not. Pixels stay in the
+// file's byte order, so 24 and 32 bit come back as B8G8R8(A8), and
+// paletted images come out in the format of the palette. 16-bit images
+// without alpha get the alpha bit set. VBBTexture converts whatever the
+// device can't sample.
+unsigned char* vbbReadTGABits(const char* szFileName, uint32_t* iWidth, uint32_t* iHeight, uint32_t* iComponents, VkFormat* format,
+                              unsigned char* pMemoryBuffer) {
+    FILE* pFile;                  // File pointer
+    TGAHEADER tgaHeader;          // TGA file header
+    VBBTGALayout layout;          // What's in it
+    unsigned char* pBits = NULL;  // Pointer to bits
+
+    // Default/Failed values
+    *iWidth = 0;
+    *iHeight = 0;
+    *iComponents = 3;
+
+    // Attempt to open the file
+    pFile = fopen(szFileName, "rb");
+    if (pFile == NULL) return nullptr;
+
+    // Read in header (binary), and make sure it's something I understand
+    if (fread(&tgaHeader, 18 /* sizeof(TGAHEADER)*/, 1, pFile) != 1 || !tgaGetLayout(tgaHeader, layout)) {
+        fclose(pFile);
+        return nullptr;
+    }
+
+    // Allocate memory and check for success
+    if (pMemoryBuffer == nullptr)
+        pBits = (unsigned char*)malloc(layout.imageSize * sizeof(unsigned char));
+    else
+        pBits = pMemoryBuffer;
+
+    if (pBits == nullptr) {
+        fclose(pFile);
+        return nullptr;
+    }
+
+    bool bOK;
+    if (!layout.bRLE && !layout.bPaletted && !layout.bNoAlpha)
+        // The easy one, straight into the buffer
+        bOK = fseek(pFile, long(layout.dataOffset), SEEK_SET) == 0 && fread(pBits, layout.imageSize, 1, pFile) == 1;
+    else {
+        // The whole file, in one read, then decode it from there
+        fseek(pFile, 0, SEEK_END);
+        long fileSize = ftell(pFile);
+        fseek(pFile, 0, SEEK_SET);
+
+        std::vector<unsigned char> fileData((fileSize > 0) ? size_t(fileSize) : 0);
+        bOK = !fileData.empty() && fread(fileData.data(), fileData.size(), 1, pFile) == 1 &&
+              vbbDecodeTGA(fileData.data(), fileData.size(), pBits);
+    }
+
+    // Done with File
+    fclose(pFile);
+
+    if (!bOK) {
+        if (pMemoryBuffer == nullptr)  // Only free if we also allocated
+            free(pBits);
+
+        return nullptr;
+    }
+
+    *iWidth = layout.width;
+    *iHeight = layout.height;
+    *iComponents = layout.components;
+    *format = layout.format;
+
+    // Return pointer to image data
+    return pBits;
+}
+
+// ***************************************************************
+// How many bytes per pixel does a particular image format have
+// This function was written by ChatGPT from my prompts. Pretty
+// impressive.
+int getBytesPerPixel(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SNORM:
+        case VK_FORMAT_R8_UINT:
+        case VK_FORMAT_R8_SINT:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SNORM:
+        case VK_FORMAT_R8G8_UINT:
         case VK_FORMAT_R8G8_SINT:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_A1R5G5B5_UNORM_PACK16:
             return 2;
 
         case VK_FORMAT_R8G8B8_UNORM:
         case VK_FORMAT_R8G8B8_SNORM:
         case VK_FORMAT_R8G8B8_UINT:
         case VK_FORMAT_R8G8B8_SINT:
+        case VK_FORMAT_R8G8B8_SRGB:
             return 3;
 
         case VK_FORMAT_B8G8R8_UNORM:
         case VK_FORMAT_B8G8R8_SNORM:
         case VK_FORMAT_B8G8R8_UINT:
         case VK_FORMAT_B8G8R8_SINT:
+        case VK_FORMAT_B8G8R8_SRGB:
             return 3;
 
         case VK_FORMAT_R8G8B8A8_UNORM:
         case VK_FORMAT_R8G8B8A8_SNORM:
         case VK_FORMAT_R8G8B8A8_UINT:
         case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_R8G8B8A8_SRGB:
         case VK_FORMAT_B8G8R8A8_UNORM:
         case VK_FORMAT_B8G8R8A8_SNORM:
         case VK_FORMAT_B8G8R8A8_UINT:
         case VK_FORMAT_B8G8R8A8_SINT:
+        case VK_FORMAT_B8G8R8A8_SRGB:
         case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
         case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
         case VK_FORMAT_A8B8G8R8_UINT_PACK32:
         case VK_FORMAT_A8B8G8R8_SINT_PACK32:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
             return 4;
 
         case VK_FORMAT_R16_UNORM:
@@ -739,3 +2208,790 @@ int getBytesPerPixel(VkFormat format) {
             return 0;  // Unknown or unsupported format
     }
 }
+
+static_assert(sizeof(VBBMeshlet) == 48, "VBBMeshlet has to match the struct in the cull shader");
+
+// Cones wider than this (dot of the axis with the worst normal) are not worth testing
+static const float VBB_MESHLET_MIN_CONE_DOT = 0.1f;
+
+// *********************************************************************************************************
+// Greedy clustering. Start a meshlet with the first triangle not used yet, then keep adding the
+// neighboring triangle that brings in the fewest new vertices until it's full or runs out of neighbors.
+bool vbbBuildMeshlets(VBBSimpleIndexedMesh& mesh, std::vector<VBBMeshlet>& meshlets, uint32_t maxVertices, uint32_t maxTriangles) {
+    meshlets.clear();
+
+    uint32_t indexCount = mesh.getIndexCount();
+    uint32_t vertexCount = mesh.getAttributeCount();
+    uint32_t triangleCount = indexCount / 3;
+    uint32_t* pIndexes = mesh.getIndexPointer();
+    const VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = mesh.getVertexPointer();
+
+    if (maxVertices < 3 || maxTriangles < 1 || triangleCount == 0) return false;
+    if (mesh.getTopology() != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) return false;
+
+    // Triangles that use each vertex
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < triangleCount * 3; i++) firstTriangle[pIndexes[i] + 1]++;
+    for (uint32_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] += firstTriangle[v];
+
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (uint32_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++) vertexTriangles[fill[pIndexes[t * 3 + k]]++] = t;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> inMeshlet(vertexCount, 0xFFFFFFFF);  // Meshlet each vertex was last added to
+    std::vector<uint32_t> sorted;
+    sorted.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> meshletVertices;
+    uint32_t seed = 0;
+
+    while (sorted.size() < triangleCount * 3) {
+        while (emitted[seed]) seed++;
+
+        uint32_t id = uint32_t(meshlets.size());
+        VBBMeshlet meshlet = {};
+        meshlet.firstIndex = uint32_t(sorted.size());
+        candidates.clear();
+        meshletVertices.clear();
+
+        uint32_t next = seed;
+        uint32_t triangles = 0;
+        while (true) {
+            // Add it
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = pIndexes[next * 3 + k];
+                sorted.push_back(v);
+                if (inMeshlet[v] != id) {
+                    inMeshlet[v] = id;
+                    meshletVertices.push_back(v);
+                    candidates.insert(candidates.end(), vertexTriangles.begin() + firstTriangle[v],
+                                      vertexTriangles.begin() + firstTriangle[v + 1]);
+                }
+            }
+            emitted[next] = true;
+            if (++triangles == maxTriangles) break;
+
+            // Best neighbor that still fits. Used ones are dropped from the list along the way.
+            uint32_t best = 0xFFFFFFFF;
+            uint32_t bestNew = 4;
+            size_t kept = 0;
+            for (size_t c = 0; c < candidates.size(); c++) {
+                uint32_t t = candidates[c];
+                if (emitted[t]) continue;
+                candidates[kept++] = t;
+
+                uint32_t newVertices = 0;
+                for (int k = 0; k < 3; k++)
+                    if (inMeshlet[pIndexes[t * 3 + k]] != id) newVertices++;
+
+                if (newVertices < bestNew && meshletVertices.size() + newVertices <= maxVertices) {
+                    best = t;
+                    bestNew = newVertices;
+                }
+            }
+            candidates.resize(kept);
+
+            if (best == 0xFFFFFFFF) break;
+            next = best;
+        }
+
+        meshlet.indexCount = triangles * 3;
+        meshlet.vertexCount = uint32_t(meshletVertices.size());
+
+        // Bounding sphere around the center of the box
+        float boundsMin[3] = {pVertices[meshletVertices[0]].x, pVertices[meshletVertices[0]].y, pVertices[meshletVertices[0]].z};
+        float boundsMax[3] = {boundsMin[0], boundsMin[1], boundsMin[2]};
+        for (size_t i = 1; i < meshletVertices.size(); i++) {
+            const float p[3] = {pVertices[meshletVertices[i]].x, pVertices[meshletVertices[i]].y, pVertices[meshletVertices[i]].z};
+            for (int k = 0; k < 3; k++) {
+                if (p[k] < boundsMin[k]) boundsMin[k] = p[k];
+                if (p[k] > boundsMax[k]) boundsMax[k] = p[k];
+            }
+        }
+
+        float radius2 = 0.0f;
+        for (int k = 0; k < 3; k++) meshlet.center[k] = (boundsMin[k] + boundsMax[k]) * 0.5f;
+        for (size_t i = 0; i < meshletVertices.size(); i++) {
+            float dx = pVertices[meshletVertices[i]].x - meshlet.center[0];
+            float dy = pVertices[meshletVertices[i]].y - meshlet.center[1];
+            float dz = pVertices[meshletVertices[i]].z - meshlet.center[2];
+            float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 > radius2) radius2 = d2;
+        }
+        meshlet.radius = sqrtf(radius2);
+
+        // Normal cone from the face normals (counter clockwise is the front)
+        std::vector<float> faceNormals(triangles * 3, 0.0f);
+        float axis[3] = {0.0f, 0.0f, 0.0f};
+        for (uint32_t t = 0; t < triangles; t++) {
+            const uint32_t* pTriangle = &sorted[meshlet.firstIndex + t * 3];
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& a = pVertices[pTriangle[0]];
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& b = pVertices[pTriangle[1]];
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& c = pVertices[pTriangle[2]];
+            float e1[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+            float e2[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+            float* n = &faceNormals[t * 3];
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+            float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0f) continue;  // Degenerate, doesn't face anywhere
+
+            for (int k = 0; k < 3; k++) {
+                n[k] /= length;
+                axis[k] += n[k];
+            }
+        }
+
+        meshlet.coneCutoff = 1.0f;
+        float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        if (axisLength > 0.0f) {
+            for (int k = 0; k < 3; k++) meshlet.coneAxis[k] = axis[k] / axisLength;
+
+            float minDot = 1.0f;
+            for (uint32_t t = 0; t < triangles; t++) {
+                const float* n = &faceNormals[t * 3];
+                float d = n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2];
+                if (d < minDot) minDot = d;
+            }
+
+            if (minDot > VBB_MESHLET_MIN_CONE_DOT) meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+        }
+
+        meshlets.push_back(meshlet);
+    }
+
+    memcpy(pIndexes, sorted.data(), sorted.size() * sizeof(uint32_t));
+    return true;
+}
+
+// *********************************************************************************************************
+// Gribb & Hartmann. Rows of the matrix added and subtracted from the w row.
+void vbbExtractFrustumPlanes(const float mvp[16], float planes[24]) {
+    for (int i = 0; i < 4; i++) {
+        float x = mvp[i * 4 + 0];
+        float y = mvp[i * 4 + 1];
+        float z = mvp[i * 4 + 2];
+        float w = mvp[i * 4 + 3];
+
+        planes[0 + i] = w + x;   // Left
+        planes[4 + i] = w - x;   // Right
+        planes[8 + i] = w + y;   // Bottom (or top, Vulkan's y is flipped, doesn't matter)
+        planes[12 + i] = w - y;  // Top
+        planes[16 + i] = z;      // Near, z >= 0
+        planes[20 + i] = w - z;  // Far
+    }
+
+    for (int p = 0; p < 6; p++) {
+        float* plane = &planes[p * 4];
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length == 0.0f) continue;
+
+        for (int k = 0; k < 4; k++) plane[k] /= length;
+    }
+}
+
+// *********************************************************************************************************
+// Outside any plane, or every triangle faces away from the camera
+bool vbbIsMeshletVisible(const VBBMeshlet& meshlet, const float planes[24], const float cameraPosition[3]) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = &planes[p * 4];
+        if (plane[0] * meshlet.center[0] + plane[1] * meshlet.center[1] + plane[2] * meshlet.center[2] + plane[3] < -meshlet.radius)
+            return false;
+    }
+
+    float v[3] = {meshlet.center[0] - cameraPosition[0], meshlet.center[1] - cameraPosition[1], meshlet.center[2] - cameraPosition[2]};
+    float distance = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float facing = v[0] * meshlet.coneAxis[0] + v[1] * meshlet.coneAxis[1] + v[2] * meshlet.coneAxis[2];
+    if (facing > meshlet.coneCutoff * distance + meshlet.radius) return false;
+
+    return true;
+}
+
+// *********************************************************************************************************
+// Frustum culling. Outside is fully behind any one plane, which lets a few through near the corners of
+// the frustum, but never culls anything that should be seen.
+bool vbbIsSphereVisible(const float planes[24], const VBBBoundingSphere& sphere) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = &planes[p * 4];
+        if (plane[0] * sphere.center[0] + plane[1] * sphere.center[1] + plane[2] * sphere.center[2] + plane[3] < -sphere.radius)
+            return false;
+    }
+
+    return true;
+}
+
+// The box projected onto the plane normal gives the radius to test the center against
+bool vbbIsBoxVisible(const float planes[24], const VBBBoundingBox& box) {
+    float center[3], extent[3];
+    for (int k = 0; k < 3; k++) {
+        center[k] = (box.max[k] + box.min[k]) * 0.5f;
+        extent[k] = (box.max[k] - box.min[k]) * 0.5f;
+    }
+
+    for (int p = 0; p < 6; p++) {
+        const float* plane = &planes[p * 4];
+        float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+        float radius = fabsf(plane[0]) * extent[0] + fabsf(plane[1]) * extent[1] + fabsf(plane[2]) * extent[2];
+        if (distance < -radius) return false;
+    }
+
+    return true;
+}
+
+// *********************************************************************************************************
+// Four at a time. Spheres are 16 bytes, so four of them load and transpose straight into x, y, z, radius.
+uint32_t vbbCullSpheres(const float planes[24], const VBBBoundingSphere* pSpheres, uint32_t count, uint8_t* pVisible) {
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+#if defined(VBB_SIMD_SSE)
+    __m128 planeA[6], planeB[6], planeC[6], planeD[6];
+    for (int p = 0; p < 6; p++) {
+        planeA[p] = _mm_set1_ps(planes[p * 4 + 0]);
+        planeB[p] = _mm_set1_ps(planes[p * 4 + 1]);
+        planeC[p] = _mm_set1_ps(planes[p * 4 + 2]);
+        planeD[p] = _mm_set1_ps(planes[p * 4 + 3]);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&pSpheres[i + 0].center[0]);
+        __m128 y = _mm_loadu_ps(&pSpheres[i + 1].center[0]);
+        __m128 z = _mm_loadu_ps(&pSpheres[i + 2].center[0]);
+        __m128 r = _mm_loadu_ps(&pSpheres[i + 3].center[0]);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeA[p]), _mm_mul_ps(y, planeB[p])),
+                                         _mm_add_ps(_mm_mul_ps(z, planeC[p]), planeD[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++) {
+            pVisible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+            visibleCount += pVisible[i + k];
+        }
+    }
+#elif defined(VBB_SIMD_NEON)
+    float32x4_t planeA[6], planeB[6], planeC[6], planeD[6];
+    for (int p = 0; p < 6; p++) {
+        planeA[p] = vdupq_n_f32(planes[p * 4 + 0]);
+        planeB[p] = vdupq_n_f32(planes[p * 4 + 1]);
+        planeC[p] = vdupq_n_f32(planes[p * 4 + 2]);
+        planeD[p] = vdupq_n_f32(planes[p * 4 + 3]);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4x4_t sphere = vld4q_f32(&pSpheres[i].center[0]);  // De-interleaves for us
+        float32x4_t negRadius = vnegq_f32(sphere.val[3]);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        for (int p = 0; p < 6; p++) {
+            float32x4_t distance = vmlaq_f32(planeD[p], sphere.val[0], planeA[p]);
+            distance = vmlaq_f32(distance, sphere.val[1], planeB[p]);
+            distance = vmlaq_f32(distance, sphere.val[2], planeC[p]);
+            outside = vorrq_u32(outside, vcltq_f32(distance, negRadius));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, outside);
+        for (int k = 0; k < 4; k++) {
+            pVisible[i + k] = lanes[k] ? 0 : 1;
+            visibleCount += pVisible[i + k];
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        pVisible[i] = vbbIsSphereVisible(planes, pSpheres[i]) ? 1 : 0;
+        visibleCount += pVisible[i];
+    }
+
+    return visibleCount;
+}
+
+// *********************************************************************************************************
+// Boxes are gathered into centers and extents four at a time, then it's the same as the spheres with
+// the radius worked out per plane.
+uint32_t vbbCullBoxes(const float planes[24], const VBBBoundingBox* pBoxes, uint32_t count, uint8_t* pVisible) {
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+#if defined(VBB_SIMD_SSE) || defined(VBB_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float center[3][4], extent[3][4];
+        for (int b = 0; b < 4; b++)
+            for (int k = 0; k < 3; k++) {
+                center[k][b] = (pBoxes[i + b].max[k] + pBoxes[i + b].min[k]) * 0.5f;
+                extent[k][b] = (pBoxes[i + b].max[k] - pBoxes[i + b].min[k]) * 0.5f;
+            }
+
+#if defined(VBB_SIMD_SSE)
+        __m128 cx = _mm_loadu_ps(center[0]), cy = _mm_loadu_ps(center[1]), cz = _mm_loadu_ps(center[2]);
+        __m128 ex = _mm_loadu_ps(extent[0]), ey = _mm_loadu_ps(extent[1]), ez = _mm_loadu_ps(extent[2]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            const float* plane = &planes[p * 4];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane[0])), _mm_mul_ps(cy, _mm_set1_ps(plane[1]))),
+                                         _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(fabsf(plane[0]))), _mm_mul_ps(ey, _mm_set1_ps(fabsf(plane[1])))),
+                                       _mm_mul_ps(ez, _mm_set1_ps(fabsf(plane[2]))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++) {
+            pVisible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+            visibleCount += pVisible[i + k];
+        }
+#else
+        float32x4_t cx = vld1q_f32(center[0]), cy = vld1q_f32(center[1]), cz = vld1q_f32(center[2]);
+        float32x4_t ex = vld1q_f32(extent[0]), ey = vld1q_f32(extent[1]), ez = vld1q_f32(extent[2]);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        for (int p = 0; p < 6; p++) {
+            const float* plane = &planes[p * 4];
+            float32x4_t distance = vmlaq_n_f32(vdupq_n_f32(plane[3]), cx, plane[0]);
+            distance = vmlaq_n_f32(distance, cy, plane[1]);
+            distance = vmlaq_n_f32(distance, cz, plane[2]);
+            distance = vmlaq_n_f32(distance, ex, fabsf(plane[0]));
+            distance = vmlaq_n_f32(distance, ey, fabsf(plane[1]));
+            distance = vmlaq_n_f32(distance, ez, fabsf(plane[2]));
+            outside = vorrq_u32(outside, vcltq_f32(distance, vdupq_n_f32(0.0f)));
+        }
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, outside);
+        for (int k = 0; k < 4; k++) {
+            pVisible[i + k] = lanes[k] ? 0 : 1;
+            visibleCount += pVisible[i + k];
+        }
+#endif
+    }
+#endif
+
+    for (; i < count; i++) {
+        pVisible[i] = vbbIsBoxVisible(planes, pBoxes[i]) ? 1 : 0;
+        visibleCount += pVisible[i];
+    }
+
+    return visibleCount;
+}
+
+// *********************************************************************************************************
+// Column major, like glm. Arvo's method, each matrix element stretches the box one way or the other.
+void vbbTransformBoundingBox(const VBBBoundingBox& box, const float matrix[16], VBBBoundingBox& result) {
+    VBBBoundingBox transformed;
+    for (int row = 0; row < 3; row++) {
+        transformed.min[row] = transformed.max[row] = matrix[12 + row];
+        for (int column = 0; column < 3; column++) {
+            float a = matrix[column * 4 + row] * box.min[column];
+            float b = matrix[column * 4 + row] * box.max[column];
+            transformed.min[row] += (a < b) ? a : b;
+            transformed.max[row] += (a < b) ? b : a;
+        }
+    }
+
+    result = transformed;
+}
+
+void vbbTransformBoundingSphere(const VBBBoundingSphere& sphere, const float matrix[16], VBBBoundingSphere& result) {
+    VBBBoundingSphere transformed;
+    float maxScaleSq = 0.0f;
+    for (int column = 0; column < 3; column++) {
+        const float* axis = &matrix[column * 4];
+        float scaleSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        if (scaleSq > maxScaleSq) maxScaleSq = scaleSq;
+    }
+
+    for (int row = 0; row < 3; row++)
+        transformed.center[row] = matrix[row] * sphere.center[0] + matrix[4 + row] * sphere.center[1] +
+                                  matrix[8 + row] * sphere.center[2] + matrix[12 + row];
+    transformed.radius = sphere.radius * sqrtf(maxScaleSq);
+
+    result = transformed;
+}
+
+// *********************************************************************************************************
+// Quadric error metric simplification (Garland & Heckbert), collapsing edges onto existing vertices.
+// A quadric is the sum of squared distances to a set of planes, weighted by area.
+struct VBBQuadric {
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double weight;
+
+    void clear(void) { a00 = a11 = a22 = a01 = a02 = a12 = b0 = b1 = b2 = c = weight = 0.0; }
+
+    void addPlane(double nx, double ny, double nz, double d, double w) {
+        a00 += w * nx * nx;
+        a11 += w * ny * ny;
+        a22 += w * nz * nz;
+        a01 += w * nx * ny;
+        a02 += w * nx * nz;
+        a12 += w * ny * nz;
+        b0 += w * nx * d;
+        b1 += w * ny * d;
+        b2 += w * nz * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const VBBQuadric& q) {
+        a00 += q.a00;
+        a11 += q.a11;
+        a22 += q.a22;
+        a01 += q.a01;
+        a02 += q.a02;
+        a12 += q.a12;
+        b0 += q.b0;
+        b1 += q.b1;
+        b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    double evaluate(double x, double y, double z) const {
+        double r = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                   2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return (r > 0.0) ? r : 0.0;
+    }
+};
+
+// Open edges get a plane through the edge at right angles to the triangle, weighted this much more
+// than the triangles themselves, so the outline doesn't wander off.
+static const double VBB_SIMPLIFY_BORDER_WEIGHT = 10.0;
+
+static inline uint64_t vbbEdgeKey(uint32_t a, uint32_t b) { return (uint64_t(a) << 32) | b; }
+
+uint32_t vbbSimplifyMesh(VBBSimpleIndexedMesh& mesh, std::vector<uint32_t>& indexes, uint32_t targetIndexCount, float targetError,
+                         float* pResultError) {
+    const VBBSimpleIndexedMesh::VBBSimpleVertex* pVertices = mesh.getVertexPointer();
+    uint32_t vertexCount = mesh.getAttributeCount();
+    indexes.assign(mesh.getIndexPointer(), mesh.getIndexPointer() + mesh.getIndexCount());
+
+    if (pResultError != nullptr) *pResultError = 0.0f;
+    if (indexes.size() <= targetIndexCount || vertexCount == 0) return uint32_t(indexes.size());
+    if (mesh.getTopology() != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) return uint32_t(indexes.size());
+
+    // Vertices at exactly the same spot (seams) are one position. position[v] is the first of them,
+    // and nextWedge[] links the copies together in a ring.
+    std::vector<uint32_t> position(vertexCount);
+    std::vector<uint32_t> nextWedge(vertexCount);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> firstAt;
+        std::unordered_map<uint64_t, uint32_t> lastAt;
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            uint32_t bits[3];
+            memcpy(bits, &pVertices[v], sizeof(bits));
+            uint64_t key = (uint64_t(bits[0]) * 73856093u) ^ (uint64_t(bits[1]) * 19349663u << 16) ^ (uint64_t(bits[2]) * 83492791u << 32);
+
+            // The key is only a hash, walk the ring to find the same position
+            uint32_t found = 0xFFFFFFFF;
+            std::unordered_map<uint64_t, uint32_t>::iterator it = firstAt.find(key);
+            while (it != firstAt.end()) {
+                const VBBSimpleIndexedMesh::VBBSimpleVertex& other = pVertices[it->second];
+                if (other.x == pVertices[v].x && other.y == pVertices[v].y && other.z == pVertices[v].z) {
+                    found = it->second;
+                    break;
+                }
+                it = firstAt.find(++key);  // Collision, probe
+            }
+
+            if (found == 0xFFFFFFFF) {
+                firstAt[key] = v;
+                lastAt[key] = v;
+                position[v] = v;
+                nextWedge[v] = v;
+            } else {
+                uint32_t last = lastAt[key];
+                position[v] = found;
+                nextWedge[v] = nextWedge[last];
+                nextWedge[last] = v;
+                lastAt[key] = v;
+            }
+            wedgeCount[position[v]]++;
+        }
+    }
+
+    // Open edges, by position. An edge is open if nothing goes the other way along it.
+    std::vector<bool> border(vertexCount, false);
+    std::unordered_map<uint64_t, uint32_t> directedEdges;
+    for (size_t i = 0; i < indexes.size(); i += 3)
+        for (int k = 0; k < 3; k++) directedEdges[vbbEdgeKey(position[indexes[i + k]], position[indexes[i + (k + 1) % 3]])]++;
+
+    // Quadrics, one per position
+    std::vector<VBBQuadric> quadrics(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) quadrics[v].clear();
+
+    for (size_t i = 0; i < indexes.size(); i += 3) {
+        const VBBSimpleIndexedMesh::VBBSimpleVertex* p[3] = {&pVertices[indexes[i]], &pVertices[indexes[i + 1]], &pVertices[indexes[i + 2]]};
+        double e1[3] = {double(p[1]->x) - p[0]->x, double(p[1]->y) - p[0]->y, double(p[1]->z) - p[0]->z};
+        double e2[3] = {double(p[2]->x) - p[0]->x, double(p[2]->y) - p[0]->y, double(p[2]->z) - p[0]->z};
+        double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0) continue;
+
+        for (int k = 0; k < 3; k++) n[k] /= length;
+        double area = length * 0.5;
+        double d = -(n[0] * p[0]->x + n[1] * p[0]->y + n[2] * p[0]->z);
+
+        VBBQuadric q;
+        q.clear();
+        q.addPlane(n[0], n[1], n[2], d, area);
+        for (int k = 0; k < 3; k++) quadrics[position[indexes[i + k]]].add(q);
+
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = position[indexes[i + k]];
+            uint32_t b = position[indexes[i + (k + 1) % 3]];
+            if (directedEdges.count(vbbEdgeKey(b, a)) != 0) continue;
+
+            border[a] = border[b] = true;
+
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& pa = pVertices[a];
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& pb = pVertices[b];
+            double edge[3] = {double(pb.x) - pa.x, double(pb.y) - pa.y, double(pb.z) - pa.z};
+            double edgeLength2 = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+            double m[3] = {edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0]};
+            double mLength = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+            if (mLength == 0.0) continue;
+
+            for (int j = 0; j < 3; j++) m[j] /= mLength;
+            double md = -(m[0] * pa.x + m[1] * pa.y + m[2] * pa.z);
+
+            VBBQuadric edgeQuadric;
+            edgeQuadric.clear();
+            edgeQuadric.addPlane(m[0], m[1], m[2], md, edgeLength2 * VBB_SIMPLIFY_BORDER_WEIGHT);
+            quadrics[a].add(edgeQuadric);
+            quadrics[b].add(edgeQuadric);
+        }
+    }
+
+    struct Collapse {
+        uint32_t from;  // Vertex
+        uint32_t to;
+        double cost;
+        bool operator<(const Collapse& other) const { return cost < other.cost; }
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> firstTriangle;
+    std::vector<uint32_t> vertexTriangles;
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    double limit = (targetError < FLT_MAX) ? double(targetError) * double(targetError) : DBL_MAX;
+    double worstError = 0.0;
+
+    // The wedges of "from" and which wedge of "to" each one lands on. Every copy has to land on exactly
+    // one copy, or the seam would tear. Returns how many there are, 0 if it can't be done.
+    uint32_t wedgeFrom[8], wedgeTo[8];
+    auto mapWedges = [&](uint32_t from, uint32_t to) -> uint32_t {
+        uint32_t count = 0;
+        uint32_t w = from;
+        do {
+            if (count == 8) return 0;
+
+            uint32_t target = 0xFFFFFFFF;
+            for (uint32_t t = firstTriangle[w]; t < firstTriangle[w + 1]; t++) {
+                const uint32_t* pTriangle = &indexes[vertexTriangles[t] * 3];
+                for (int k = 0; k < 3; k++)
+                    if (position[pTriangle[k]] == position[to]) {
+                        if (target != 0xFFFFFFFF && target != pTriangle[k]) return 0;  // Touches two copies
+                        target = pTriangle[k];
+                    }
+            }
+
+            if (target == 0xFFFFFFFF) return 0;
+            wedgeFrom[count] = w;
+            wedgeTo[count] = target;
+            count++;
+            w = nextWedge[w];
+        } while (w != from);
+
+        return count;
+    };
+
+    while (indexes.size() > targetIndexCount) {
+        uint32_t triangleCount = uint32_t(indexes.size() / 3);
+
+        // Triangles around each vertex
+        firstTriangle.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexes.size(); i++) firstTriangle[indexes[i] + 1]++;
+        for (uint32_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] += firstTriangle[v];
+        vertexTriangles.resize(indexes.size());
+        std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++) vertexTriangles[fill[indexes[t * 3 + k]]++] = t;
+
+        // Every edge both ways. Border vertices only slide along the border.
+        collapses.clear();
+        for (uint32_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = indexes[t * 3 + k];
+                uint32_t b = indexes[t * 3 + (k + 1) % 3];
+                uint32_t pa = position[a];
+                uint32_t pb = position[b];
+
+                for (int dir = 0; dir < 2; dir++) {
+                    uint32_t from = dir ? b : a;
+                    uint32_t to = dir ? a : b;
+                    uint32_t pFrom = dir ? pb : pa;
+                    uint32_t pTo = dir ? pa : pb;
+
+                    if (wedgeCount[pFrom] > 1 && wedgeCount[pTo] != wedgeCount[pFrom]) continue;  // Seams stay seams
+                    if (border[pFrom] && (!border[pTo] || (directedEdges.count(vbbEdgeKey(pFrom, pTo)) != 0 &&
+                                                           directedEdges.count(vbbEdgeKey(pTo, pFrom)) != 0)))
+                        continue;
+
+                    VBBQuadric q = quadrics[pFrom];
+                    q.add(quadrics[pTo]);
+                    const VBBSimpleIndexedMesh::VBBSimpleVertex& p = pVertices[pTo];
+                    double cost = q.evaluate(p.x, p.y, p.z) / ((q.weight > 0.0) ? q.weight : 1.0);
+
+                    Collapse collapse = {from, to, cost};
+                    collapses.push_back(collapse);
+                }
+            }
+
+        std::sort(collapses.begin(), collapses.end());
+
+        for (uint32_t v = 0; v < vertexCount; v++) collapseTo[v] = v;
+        locked.assign(vertexCount, false);
+
+        // Each collapse takes out about two triangles
+        uint32_t wanted = (triangleCount - targetIndexCount / 3 + 1) / 2;
+        if (wanted == 0) wanted = 1;
+        uint32_t done = 0;
+        bool bOverLimit = false;
+
+        for (size_t c = 0; c < collapses.size() && done < wanted; c++) {
+            const Collapse& collapse = collapses[c];
+            uint32_t pFrom = position[collapse.from];
+            uint32_t pTo = position[collapse.to];
+            if (collapse.cost > limit) {
+                bOverLimit = true;
+                break;
+            }
+            if (locked[pFrom] || locked[pTo]) continue;
+
+            uint32_t wedges = mapWedges(pFrom, pTo);
+            if (wedges == 0) continue;
+
+            // Don't flip or squash anything that's left around the vertex being moved
+            const VBBSimpleIndexedMesh::VBBSimpleVertex& target = pVertices[pTo];
+            bool bFlips = false;
+            for (uint32_t w = 0; w < wedges && !bFlips; w++)
+                for (uint32_t t = firstTriangle[wedgeFrom[w]]; t < firstTriangle[wedgeFrom[w] + 1] && !bFlips; t++) {
+                    const uint32_t* pTriangle = &indexes[vertexTriangles[t] * 3];
+                    int corner = 0;
+                    bool bGoesAway = false;
+                    for (int k = 0; k < 3; k++) {
+                        if (pTriangle[k] == wedgeFrom[w]) corner = k;
+                        if (position[pTriangle[k]] == pTo) bGoesAway = true;
+                    }
+                    if (bGoesAway) continue;
+
+                    const VBBSimpleIndexedMesh::VBBSimpleVertex& p0 = pVertices[pTriangle[corner]];
+                    const VBBSimpleIndexedMesh::VBBSimpleVertex& p1 = pVertices[pTriangle[(corner + 1) % 3]];
+                    const VBBSimpleIndexedMesh::VBBSimpleVertex& p2 = pVertices[pTriangle[(corner + 2) % 3]];
+                    double e1[3] = {double(p1.x) - p0.x, double(p1.y) - p0.y, double(p1.z) - p0.z};
+                    double e2[3] = {double(p2.x) - p0.x, double(p2.y) - p0.y, double(p2.z) - p0.z};
+                    double f1[3] = {double(p1.x) - target.x, double(p1.y) - target.y, double(p1.z) - target.z};
+                    double f2[3] = {double(p2.x) - target.x, double(p2.y) - target.y, double(p2.z) - target.z};
+                    double before[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                    double after[3] = {f1[1] * f2[2] - f1[2] * f2[1], f1[2] * f2[0] - f1[0] * f2[2], f1[0] * f2[1] - f1[1] * f2[0]};
+                    double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                    double lengths = sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                                          (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                    if (dot <= 0.25 * lengths) bFlips = true;  // More than about 75 degrees, or gone flat
+                }
+            if (bFlips) continue;
+
+            for (uint32_t w = 0; w < wedges; w++) collapseTo[wedgeFrom[w]] = wedgeTo[w];
+            quadrics[pTo].add(quadrics[pFrom]);
+            if (collapse.cost > worstError) worstError = collapse.cost;
+
+            // Everything touching the moved vertex is locked for the rest of this pass, so the
+            // flip test above stays true
+            for (uint32_t w = 0; w < wedges; w++)
+                for (uint32_t t = firstTriangle[wedgeFrom[w]]; t < firstTriangle[wedgeFrom[w] + 1]; t++)
+                    for (int k = 0; k < 3; k++) locked[position[indexes[vertexTriangles[t] * 3 + k]]] = true;
+            done++;
+        }
+
+        if (done == 0) break;
+
+        // Apply, and drop whatever collapsed to nothing
+        size_t kept = 0;
+        for (size_t i = 0; i < indexes.size(); i += 3) {
+            uint32_t a = collapseTo[indexes[i]];
+            uint32_t b = collapseTo[indexes[i + 1]];
+            uint32_t c = collapseTo[indexes[i + 2]];
+            if (position[a] == position[b] || position[b] == position[c] || position[c] == position[a]) continue;
+
+            indexes[kept++] = a;
+            indexes[kept++] = b;
+            indexes[kept++] = c;
+        }
+        indexes.resize(kept);
+
+        if (bOverLimit) break;
+    }
+
+    if (pResultError != nullptr) *pResultError = float(sqrt(worstError));
+
+    return uint32_t(indexes.size());
+}
+
+// *********************************************************************************************************
+// Each level is simplified from the original, so the errors don't pile up from one level to the next
+bool vbbBuildLODChain(VBBSimpleIndexedMesh& mesh, std::vector<uint32_t>& indexes, std::vector<VBBMeshLOD>& lods, uint32_t maxLevels,
+                      float reduction, float maxError) {
+    indexes.assign(mesh.getIndexPointer(), mesh.getIndexPointer() + mesh.getIndexCount());
+    lods.clear();
+
+    if (indexes.empty() || maxLevels == 0 || reduction <= 0.0f || reduction >= 1.0f) return false;
+    if (mesh.getTopology() != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) return false;
+
+    VBBMeshLOD lod = {0, uint32_t(indexes.size()), 0.0f};
+    lods.push_back(lod);
+
+    std::vector<uint32_t> levelIndexes;
+    while (lods.size() < maxLevels) {
+        const VBBMeshLOD& last = lods.back();
+        uint32_t target = uint32_t(float(last.indexCount / 3) * reduction) * 3;
+        if (target < 3) break;
+
+        float error = 0.0f;
+        uint32_t count = vbbSimplifyMesh(mesh, levelIndexes, target, maxError, &error);
+
+        // Not worth another level if it barely got smaller
+        if (count == 0 || count > last.indexCount - last.indexCount / 10) break;
+
+        lod.firstIndex = uint32_t(indexes.size());
+        lod.indexCount = count;
+        lod.error = (error > last.error) ? error : last.error;
+        indexes.insert(indexes.end(), levelIndexes.begin(), levelIndexes.end());
+        lods.push_back(lod);
+    }
+
+    return true;
+}
+
+// *********************************************************************************************************
+uint32_t vbbSelectLOD(const std::vector<VBBMeshLOD>& lods, float distance, float pixelsPerUnit, float maxPixelError) {
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < lods.size(); i++)
+        if (vbbGetLODScreenError(lods[i], distance, pixelsPerUnit) <= maxPixelError) best = i;
+
+    return best;
+}
@@ -329,21 +329,7 @@ static unsigned int StockShader_FakeLight_frag_spv_len = 900;
 VBBUtilsUnitAxes::~VBBUtilsUnitAxes(void) {
     delete pPipeline;
 
-    delete pVertexBufferSphere;
-    delete pNormalBufferSphere;
-    delete pIndexBufferSphere;
-
-    delete pVertexBufferCylinder;
-    delete pNormalBufferCylinder;
-    delete pIndexBufferCylinder;
-
-    delete pVertexBufferDisk;
-    delete pNormalBufferDisk;
-    delete pIndexBufferDisk;
-
-    delete pVertexBufferCone;
-    delete pNormalBufferCone;
-    delete pIndexBufferCone;
+    delete pGeometry;
 }
 
 
@@ -353,12 +339,16 @@ VkResult VBBUtilsUnitAxes::createAxes(VBBCanvas* pCanvas)
 {
     m_pCanvas = pCanvas;
 
+    // Positions and normals, interleaved in one buffer for all the shapes
+    VBBMeshAttribute attributes[] = { VBB_MESH_ATTRIBUTE_POSITION, VBB_MESH_ATTRIBUTE_NORMAL };
+    pGeometry = new VBBGeometryPool(m_pCanvas->getVMA());
+    pGeometry->setLayout(2, attributes);
+
     // Going to draw triangles
     pPipeline = new VBBPipelineGraphics();
 
             // What does the attribute data look like, and what is it's location
-    pPipeline->addVertexAttributeBinding(sizeof(float)*3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 0, VK_FORMAT_R32G32B32_SFLOAT);
-    pPipeline->addVertexAttributeBinding(sizeof(float)*3, 0, VK_VERTEX_INPUT_RATE_VERTEX, 1, VK_FORMAT_R32G32B32_SFLOAT);
+    pPipeline->addInterleavedVertexBinding(pGeometry->getLayout());
 
     // Push constants are SO FREAKING EASY
     VkPushConstantRange pushConstant;
@@ -374,7 +364,9 @@ VkResult VBBUtilsUnitAxes::createAxes(VBBCanvas* pCanvas)
 
     pPipeline->setPushConstants(1, &pushConstant);
 
-    pPipeline->setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    // Everything here is a grid, so it's all strips. A third of the indexes.
+    pPipeline->setPrimitiveTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+    pPipeline->setPrimitiveRestartEnable(VK_TRUE);
     pPipeline->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
     pPipeline->setCullMode(VK_CULL_MODE_BACK_BIT);
     pPipeline->setPolygonMode(VK_POLYGON_MODE_FILL);
@@ -387,70 +379,19 @@ VkResult VBBUtilsUnitAxes::createAxes(VBBCanvas* pCanvas)
 
     // Build a mesh
     VBBSimpleIndexedMesh sphere, cylinder, disk, cone;
-    VBBMakeSphere(sphere, sphereSize, 52, 26);
-    VBBMakeCylinder(cylinder, cylinderRadius, cylinderRadius, cylinderLength, 50, 100);
-    VBBMakeDisk(disk, 0.0f, diskRadius, 50, 2);
-    VBBMakeCylinder(cone, 0, diskRadius, coneHeight, 50, 5);
-
-    // ***************************************************************
-    // Sphere
-    indexCountSphere = sphere.getIndexCount();
-    attribCountSphere = sphere.getAttributeCount();
-
-    pVertexBufferSphere = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pVertexBufferSphere->createBuffer(sphere.getVertexPointer(),
-                            sizeof(float)*3*attribCountSphere, m_pCanvas->getDevice());
-
-    pNormalBufferSphere = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pNormalBufferSphere->createBuffer(sphere.getNormalPointer(), sizeof(float)*3*attribCountSphere, m_pCanvas->getDevice());
-
-    pIndexBufferSphere = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pIndexBufferSphere->createBuffer(sphere.getIndexPointer(), sizeof(uint32_t)*indexCountSphere, m_pCanvas->getDevice());
-    // ***************************************************************
-
-            // ***************************************************************
-            // Cylinder
-    indexCountCylinder = cylinder.getIndexCount();
-    attribCountCylinder = cylinder.getAttributeCount();
-
-    pVertexBufferCylinder = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pVertexBufferCylinder->createBuffer(cylinder.getVertexPointer(), sizeof(float)*3*attribCountCylinder, m_pCanvas->getDevice());
-
-    pNormalBufferCylinder = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pNormalBufferCylinder->createBuffer(cylinder.getNormalPointer(), sizeof(float)*3*attribCountCylinder, m_pCanvas->getDevice());
-
-    pIndexBufferCylinder = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pIndexBufferCylinder->createBuffer(cylinder.getIndexPointer(), sizeof(uint32_t)*indexCountCylinder, m_pCanvas->getDevice());
-
-
-    // ***************************************************************
-    // Disk
-    indexCountDisk = disk.getIndexCount();
-    attribCountDisk = disk.getAttributeCount();
-
-    pVertexBufferDisk = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pVertexBufferDisk->createBuffer(disk.getVertexPointer(), sizeof(float)*3*attribCountDisk, m_pCanvas->getDevice());
-
-    pNormalBufferDisk = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pNormalBufferDisk->createBuffer(disk.getNormalPointer(), sizeof(float)*3*attribCountDisk, m_pCanvas->getDevice());
-
-    pIndexBufferDisk = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pIndexBufferDisk->createBuffer(disk.getIndexPointer(), sizeof(uint32_t)*indexCountDisk, m_pCanvas->getDevice());
-
-    // ***************************************************************
-    // Cone
-    indexCountCone = cone.getIndexCount();
-    attribCountCone = cone.getAttributeCount();
+    VBBMakeSphereGrid(sphere, sphereSize, 52, 26, 1, true);
+    VBBMakeCylinderGrid(cylinder, cylinderRadius, cylinderRadius, cylinderLength, 50, 100, 360, 1, true);
+    VBBMakeDiskGrid(disk, 0.0f, diskRadius, 50, 2, 360, 1, true);
+    VBBMakeCylinderGrid(cone, 0, diskRadius, coneHeight, 50, 5, 360, 1, true);
 
-    pVertexBufferCone = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pVertexBufferCone->createBuffer(cone.getVertexPointer(), sizeof(float)*3*attribCountCone, m_pCanvas->getDevice());
-
-    pNormalBufferCone = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pNormalBufferCone->createBuffer(cone.getNormalPointer(), sizeof(float)*3*attribCountCone, m_pCanvas->getDevice());
-
-    pIndexBufferCone = new VBBBufferStatic(m_pCanvas->getVMA());
-    lastResult = pIndexBufferCone->createBuffer(cone.getIndexPointer(), sizeof(uint32_t)*indexCountCone, m_pCanvas->getDevice());
+    rangeSphere = pGeometry->addMesh(sphere);
+    rangeCylinder = pGeometry->addMesh(cylinder);
+    rangeDisk = pGeometry->addMesh(disk);
+    rangeCone = pGeometry->addMesh(cone);
 
+    lastResult = pGeometry->createBuffers(m_pCanvas->getDevice());
+    if(lastResult != VK_SUCCESS)
+        return lastResult;
 
     return VK_SUCCESS;
 }
@@ -476,58 +417,22 @@ void VBBUtilsUnitAxes::packagePushConstants(pushConstantDef& pc, glm::mat4& mode
 
 void VBBUtilsUnitAxes::drawCylinder(VkCommandBuffer cmdBuffer)
 {
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = { pVertexBufferCylinder->getBuffer() };
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = { pNormalBufferCylinder->getBuffer() };
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBufferCylinder->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(cmdBuffer, indexCountCylinder, 1, 0, 0, 0);
+    pGeometry->draw(cmdBuffer, rangeCylinder);
 }
 
 void VBBUtilsUnitAxes::drawSphere(VkCommandBuffer cmdBuffer)
 {
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = { pVertexBufferSphere->getBuffer() };
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = { pNormalBufferSphere->getBuffer() };
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBufferSphere->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(cmdBuffer, indexCountSphere, 1, 0, 0, 0);
+    pGeometry->draw(cmdBuffer, rangeSphere);
 }
 
 void VBBUtilsUnitAxes::drawDisk(VkCommandBuffer cmdBuffer)
 {
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = { pVertexBufferDisk->getBuffer() };
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = { pNormalBufferDisk->getBuffer() };
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBufferDisk->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(cmdBuffer, indexCountDisk, 1, 0, 0, 0);
+    pGeometry->draw(cmdBuffer, rangeDisk);
 }
 
 void VBBUtilsUnitAxes::drawCone(VkCommandBuffer cmdBuffer)
 {
-    // Bind to geometry attribute data and draw
-    VkBuffer vertexBuffers[] = { pVertexBufferCone->getBuffer() };
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-
-    VkBuffer normalBuffers[] = { pNormalBufferCone->getBuffer() };
-    vkCmdBindVertexBuffers(cmdBuffer, 1, 1, normalBuffers, offsets);
-
-    vkCmdBindIndexBuffer(cmdBuffer, pIndexBufferCone->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(cmdBuffer, indexCountCone, 1, 0, 0, 0);
+    pGeometry->draw(cmdBuffer, rangeCone);
 }
 
 VkResult VBBUtilsUnitAxes::renderAxes(glm::mat4& modelView, glm::mat4& proj, VkCommandBuffer cmdBuffer)
@@ -536,6 +441,9 @@ VkResult VBBUtilsUnitAxes::renderAxes(glm::mat4& modelView, glm::mat4& proj, VkC
             // Bind to the pipeline that we want to use
     vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipeline());
 
+    // One bind for every shape
+    pGeometry->bind(cmdBuffer);
+
 
     // We use this for everything
     pushConstantDef pc;